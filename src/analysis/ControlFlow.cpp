@@ -0,0 +1,275 @@
+#include "ControlFlow.h"
+#include <algorithm>
+
+namespace {
+
+bool isBranch(InstructionInfo const & info) {
+    return info.mode == AddrMode::rel;
+}
+
+bool isStaticJump(InstructionInfo const & info) {
+    return info.mode == AddrMode::abs &&
+           (info.mnemonic == Mnemonic::JMP || info.mnemonic == Mnemonic::JSR);
+}
+
+bool isIndirectJump(InstructionInfo const & info) {
+    return info.mnemonic == Mnemonic::JMP &&
+           (info.mode == AddrMode::ind || info.mode == AddrMode::axi);
+}
+
+//Last instruction of a block
+bool endsBlock(InstructionInfo const & info) {
+    switch(info.mnemonic) {
+        case Mnemonic::JMP: case Mnemonic::JSR: case Mnemonic::RTS:
+        case Mnemonic::RTI: case Mnemonic::BRK:
+            return true;
+        default:
+            return isBranch(info);
+    }
+}
+
+bool fallsThrough(InstructionInfo const & info) {
+    switch(info.mnemonic) {
+        case Mnemonic::JMP: case Mnemonic::JSR: case Mnemonic::RTS:
+        case Mnemonic::RTI: case Mnemonic::BRK: case Mnemonic::BRA:
+            return false;
+        default:
+            return true;
+    }
+}
+
+}
+
+template<class Variant>
+ControlFlow<Variant>::ControlFlow(std::vector<uint8_t> image, uint16_t base):
+    image{std::move(image)}, base{base}
+{
+    if(this->image.size() > 0x10000u - base) {
+        this->image.resize(0x10000u - base);
+    }
+
+    //Vectors found in the image
+    for(uint16_t vector : {0xfffa, 0xfffc, 0xfffe}) {
+        if(inImage(vector, 2)) {
+            addEntry(byte(vector) | (byte(vector+1) << 8));
+        }
+    }
+}
+
+template<class Variant>
+void ControlFlow<Variant>::addEntry(uint16_t addr) {
+    walk(addr);
+}
+
+template<class Variant>
+bool ControlFlow<Variant>::addIndirectTarget(uint16_t site, uint16_t target) {
+    if(!sites[site]) return false;
+
+    std::vector<uint16_t>& targets = resolved[site];
+    if(std::find(targets.begin(), targets.end(), target) != targets.end()) return false;
+
+    targets.push_back(target);
+    walk(target);
+    return true;
+}
+
+/**** Queries ****/
+template<class Variant>
+typename ControlFlow<Variant>::Byte ControlFlow<Variant>::type(uint16_t addr) const {
+    if(instructions[addr]) return Byte::opcode;
+    if(operands[addr]) return Byte::operand;
+    return Byte::data;
+}
+
+template<class Variant>
+bool ControlFlow<Variant>::isInstruction(uint16_t addr) const {
+    return instructions[addr];
+}
+
+template<class Variant>
+bool ControlFlow<Variant>::isLeader(uint16_t addr) const {
+    return leaders[addr] && instructions[addr];
+}
+
+template<class Variant>
+bool ControlFlow<Variant>::isIndirectSite(uint16_t addr) const {
+    return sites[addr];
+}
+
+template<class Variant>
+std::vector<typename ControlFlow<Variant>::Block> const & ControlFlow<Variant>::blocks() const {
+    if(dirty) {
+        buildBlocks();
+        dirty = false;
+    }
+    return blockList;
+}
+
+template<class Variant>
+typename ControlFlow<Variant>::Block const * ControlFlow<Variant>::blockAt(uint16_t addr) const {
+    std::vector<Block> const & list = blocks();
+    auto it = std::upper_bound(list.begin(), list.end(), addr,
+                               [](uint16_t a, Block const & b) { return a < b.start; });
+    if(it == list.begin()) return nullptr;
+    --it;
+    return addr <= it->last ? &*it : nullptr;
+}
+
+template<class Variant>
+std::vector<uint16_t> ControlFlow<Variant>::indirectSites() const {
+    std::vector<uint16_t> list;
+    for(unsigned addr = 0; addr < 0x10000; ++addr) {
+        if(sites[addr]) list.push_back(addr);
+    }
+    return list;
+}
+
+template<class Variant>
+std::size_t ControlFlow<Variant>::instructionCount() const {
+    return instructions.count();
+}
+
+template<class Variant>
+bool ControlFlow<Variant>::inImage(uint16_t addr, uint8_t length) const {
+    return addr >= base && static_cast<std::size_t>(addr - base) + length <= image.size();
+}
+
+template<class Variant>
+uint8_t ControlFlow<Variant>::byte(uint16_t addr) const {
+    return image[addr - base];
+}
+
+template<class Variant>
+uint16_t ControlFlow<Variant>::operand(uint16_t addr) const {
+    InstructionInfo const & info = INSTRUCTIONS<Variant>[byte(addr)];
+    uint8_t length = instructionLength(info.mode);
+    if(length == 1) return 0;
+    if(length == 3) return byte(addr+1) | (byte(addr+2) << 8);
+    if(isBranch(info)) return static_cast<uint16_t>(addr + 2 + static_cast<int8_t>(byte(addr+1)));
+    return byte(addr+1);
+}
+/*****************/
+
+/**** Discovery ****/
+template<class Variant>
+void ControlFlow<Variant>::walk(uint16_t addr) {
+    std::vector<uint16_t> pending{addr};
+    leaders[addr] = 1;
+    dirty = true;
+    auto follow = [&](uint16_t target) {
+        leaders[target] = 1;
+        if(!instructions[target]) pending.push_back(target);
+    };
+
+    while(!pending.empty()) {
+        uint16_t PC = pending.back();
+        pending.pop_back();
+
+        //Sequential flow up to the end of the block
+        for(;;) {
+            if(instructions[PC]) {
+                //Joins code already discovered
+                leaders[PC] = 1;
+                break;
+            }
+            if(!inImage(PC)) break;
+            InstructionInfo const & info = INSTRUCTIONS<Variant>[byte(PC)];
+            uint8_t length = instructionLength(info.mode);
+            if(info.mnemonic == Mnemonic::ILL || !inImage(PC, length)) break;
+
+            instructions[PC] = 1;
+            for(uint8_t i = 1; i < length; ++i) {
+                operands[static_cast<uint16_t>(PC+i)] = 1;
+            }
+
+            uint16_t next = PC + length;
+            if(isBranch(info) || isStaticJump(info)) {
+                follow(operand(PC));
+            }
+            if(isIndirectJump(info)) {
+                sites[PC] = 1;
+                for(uint16_t target : resolved[PC]) follow(target);
+            }
+            if(info.mnemonic == Mnemonic::JSR) {
+                follow(next);
+            } else if(info.mnemonic == Mnemonic::BRK) {
+                //RTI returns after the signature byte
+                follow(next+1);
+            }
+
+            if(!fallsThrough(info)) break;
+            if(endsBlock(info)) leaders[next] = 1;
+            PC = next;
+        }
+    }
+}
+
+template<class Variant>
+void ControlFlow<Variant>::buildBlocks() const {
+    blockList.clear();
+
+    for(unsigned start = 0; start < 0x10000; ++start) {
+        if(!isLeader(start)) continue;
+
+        Block block{static_cast<uint16_t>(start), 0, 0, false, {}};
+        uint16_t PC = start;
+        for(;;) {
+            InstructionInfo const & info = INSTRUCTIONS<Variant>[byte(PC)];
+            uint16_t next = PC + instructionLength(info.mode);
+            block.last = PC;
+            block.size += instructionLength(info.mode);
+
+            if(endsBlock(info)) {
+                if(isBranch(info) || isStaticJump(info)) {
+                    block.successors.push_back(operand(PC));
+                }
+                if(isIndirectJump(info)) {
+                    block.indirect = true;
+                    auto it = resolved.find(PC);
+                    if(it != resolved.end()) {
+                        block.successors.insert(block.successors.end(), it->second.begin(), it->second.end());
+                    }
+                }
+                if(info.mnemonic == Mnemonic::JSR || (isBranch(info) && fallsThrough(info))) {
+                    block.successors.push_back(next);
+                } else if(info.mnemonic == Mnemonic::BRK) {
+                    block.successors.push_back(next+1);
+                }
+                break;
+            }
+            //Fall-through into the next block, or end of the discovered code
+            if(!instructions[next] || next < PC) break;
+            if(leaders[next]) {
+                block.successors.push_back(next);
+                break;
+            }
+            PC = next;
+        }
+
+        blockList.push_back(std::move(block));
+    }
+}
+/*******************/
+
+/**** Runtime resolution ****/
+template<class Variant>
+ControlFlowTracker<Variant>::ControlFlowTracker(ControlFlow<Variant>& flow):
+    flow{flow}
+{}
+
+template<class Variant>
+void ControlFlowTracker<Variant>::postInstruction(DecodedInstruction const & instruction,
+                                                  CPUState const & state) {
+    if(flow.isIndirectSite(instruction.PC)) {
+        flow.addIndirectTarget(instruction.PC, state.PC);
+    }
+}
+/****************************/
+
+template class ControlFlow<NMOS6502>;
+template class ControlFlow<CMOS65C02>;
+template class ControlFlow<RP2A03>;
+
+template class ControlFlowTracker<NMOS6502>;
+template class ControlFlowTracker<CMOS65C02>;
+template class ControlFlowTracker<RP2A03>;
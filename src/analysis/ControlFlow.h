@@ -0,0 +1,111 @@
+#ifndef CONTROL_FLOW_H
+#define CONTROL_FLOW_H
+
+#include <vector>
+#include <map>
+#include <bitset>
+#include <cstdint>
+#include <cstddef>
+#include "../cpu/Variants.h"
+#include "../cpu/Instructions.h"
+#include "../cpu/Hooks.h"
+
+/*
+    Static analysis of a ROM image: code/data discovery, basic blocks
+    and control-flow graph.
+
+    The code is discovered from the vectors found in the image (reset,
+    NMI, IRQ/BRK) and from the extra entry points, decoding with
+    INSTRUCTIONS<Variant> and following the branches, JMP and JSR (the
+    return addresses of JSR and BRK are followed too). The targets of
+    JMP (ind) and JMP (abs,X) are only known at runtime: these sites
+    are recorded, and the targets found while running are added with
+    addIndirectTarget() (see ControlFlowTracker), which only walks the
+    newly reached code.
+
+        ControlFlow<NMOS6502> flow(image, 0xc000);
+        for(auto const & block : flow.blocks()) ...
+        if(flow.type(addr) == ControlFlow<NMOS6502>::Byte::data) ...
+
+    Illegal opcodes and instructions running past the end of the image
+    stop the discovery of a path (they are most likely data). RTS and
+    RTI end a block without successors.
+*/
+template<class Variant>
+class ControlFlow {
+public:
+    enum class Byte : uint8_t {
+        data,       //Not reached by the discovery (or outside the image)
+        opcode,     //First byte of an instruction
+        operand     //Operand of an instruction
+    };
+
+    struct Block {
+        uint16_t start;
+        uint16_t last;                      //Address of the last instruction
+        uint16_t size;                      //Bytes
+        bool indirect;                      //Ends with JMP (ind) or JMP (abs,X)
+        std::vector<uint16_t> successors;   //Static targets, fall-through, return
+                                            //address of JSR/BRK, resolved targets
+    };
+
+    ControlFlow(std::vector<uint8_t> image, uint16_t base);
+
+    void addEntry(uint16_t addr);
+    //Target of the indirect jump at site found at runtime (true if new)
+    bool addIndirectTarget(uint16_t site, uint16_t target);
+
+    Byte type(uint16_t addr) const;
+    bool isInstruction(uint16_t addr) const;
+    //First instruction of a basic block
+    bool isLeader(uint16_t addr) const;
+    bool isIndirectSite(uint16_t addr) const;
+
+    //Basic blocks in address order (rebuilt after new code is found)
+    std::vector<Block> const & blocks() const;
+    //Block containing the instruction at addr (nullptr if none)
+    Block const * blockAt(uint16_t addr) const;
+    std::vector<uint16_t> indirectSites() const;
+    std::size_t instructionCount() const;
+
+    bool inImage(uint16_t addr, uint8_t length = 1) const;
+    uint8_t byte(uint16_t addr) const;
+    //Operand of the instruction at addr (the target for branches)
+    uint16_t operand(uint16_t addr) const;
+
+private:
+    std::vector<uint8_t> image;
+    uint16_t base;
+
+    std::bitset<0x10000> instructions;
+    std::bitset<0x10000> operands;
+    std::bitset<0x10000> leaders;
+    std::bitset<0x10000> sites;
+    std::map<uint16_t, std::vector<uint16_t>> resolved;    //Indirect site -> targets
+
+    mutable std::vector<Block> blockList;
+    mutable bool dirty{true};
+
+    //Discover the code reachable from addr
+    void walk(uint16_t addr);
+    void buildBlocks() const;
+};
+
+/*
+    Hooks that resolve the indirect jumps while the CPU runs:
+
+        ControlFlowTracker<NMOS6502> tracker(flow);
+        cpu.setHooks(&tracker);
+*/
+template<class Variant>
+class ControlFlowTracker : public CPUHooks {
+public:
+    explicit ControlFlowTracker(ControlFlow<Variant>& flow);
+
+    void postInstruction(DecodedInstruction const & instruction, CPUState const & state) override;
+
+private:
+    ControlFlow<Variant>& flow;
+};
+
+#endif
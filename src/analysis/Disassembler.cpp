@@ -0,0 +1,330 @@
+#include "Disassembler.h"
+#include "Format.h"
+#include <array>
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+
+using namespace Format;
+
+namespace {
+
+//Operand of an addressing mode
+enum class Operand : uint8_t {
+    none,           //Implied (or accumulator)
+    immediate,      //"#$2a"
+    zeropage,       //"$10"
+    absolute,       //"$1234"
+    relative        //Branch target, "$f000"
+};
+
+//Text around the operand of an addressing mode: " (" operand ",X)"
+struct ModeFormat {
+    char prefix[3];
+    uint8_t prefixSize;
+    char suffix[4];
+    uint8_t suffixSize;
+    Operand operand;
+};
+
+constexpr ModeFormat modeFormat(AddrMode mode) {
+    switch(mode) {
+        case AddrMode::imp: return {"",   0, "",    0, Operand::none};
+        case AddrMode::imm: return {" #", 2, "",    0, Operand::immediate};
+        case AddrMode::zpg: return {" ",  1, "",    0, Operand::zeropage};
+        case AddrMode::zpx: return {" ",  1, ",X",  2, Operand::zeropage};
+        case AddrMode::zpy: return {" ",  1, ",Y",  2, Operand::zeropage};
+        case AddrMode::abs: return {" ",  1, "",    0, Operand::absolute};
+        case AddrMode::abx: return {" ",  1, ",X",  2, Operand::absolute};
+        case AddrMode::aby: return {" ",  1, ",Y",  2, Operand::absolute};
+        case AddrMode::ind: return {" (", 2, ")",   1, Operand::absolute};
+        case AddrMode::xin: return {" (", 2, ",X)", 3, Operand::zeropage};
+        case AddrMode::iny: return {" (", 2, "),Y", 3, Operand::zeropage};
+        case AddrMode::rel: return {" ",  1, "",    0, Operand::relative};
+        case AddrMode::izp: return {" (", 2, ")",   1, Operand::zeropage};
+        case AddrMode::axi: return {" (", 2, ",X)", 3, Operand::absolute};
+    }
+    return {"", 0, "", 0, Operand::none};
+}
+
+/*
+    Line of an opcode without symbols, after the address: the text with
+    the bytes column blank ("            LDA $"), then the text after the
+    operand digits (",X\n").
+*/
+struct LineTemplate {
+    char text[40];
+    char suffix[8];
+    uint8_t blank;          //Start of the column after the instruction bytes
+    uint8_t operand;        //Position of the operand digits
+    uint8_t digits;         //0, 2 or 4
+    uint8_t length;         //Instruction bytes
+    uint8_t size;           //Chars of the line after the address
+    uint16_t byteMask;      //Operand value: the byte (shifted to the first
+    uint16_t wordMask;      //two digits), the word or the branch target
+    uint16_t targetMask;
+};
+
+constexpr std::size_t put(char* out, std::size_t i, char const * string, std::size_t size) {
+    for(std::size_t k = 0; k < size; ++k) out[i++] = string[k];
+    return i;
+}
+
+template<class Variant>
+constexpr std::array<LineTemplate, 256> makeLineTemplates() {
+    std::array<LineTemplate, 256> templates{};
+    for(unsigned opcode = 0; opcode < 0x100; ++opcode) {
+        InstructionInfo const info = INSTRUCTIONS<Variant>[opcode];
+        ModeFormat const format = modeFormat(info.mode);
+        LineTemplate& t = templates[opcode];
+
+        t.length = instructionLength(info.mode);
+        t.blank = 3*t.length + 1;
+
+        std::size_t i = put(t.text, 0, "            ", 12);
+        i = put(t.text, i, mnemonicName(info.mnemonic), 3);
+        i = put(t.text, i, format.prefix, format.prefixSize);
+        if(format.operand == Operand::none) {
+            if(accessType(info.mnemonic) == Access::rmw) i = put(t.text, i, " A", 2);
+        } else {
+            t.text[i++] = '$';
+            t.digits = (format.operand == Operand::immediate || format.operand == Operand::zeropage) ? 2 : 4;
+        }
+        t.operand = i;
+        t.byteMask = t.digits == 2 ? 0xff00 : 0;
+        t.wordMask = format.operand == Operand::absolute ? 0xffff : 0;
+        t.targetMask = format.operand == Operand::relative ? 0xffff : 0;
+
+        std::size_t end = put(t.suffix, 0, format.suffix, format.suffixSize);
+        t.suffix[end++] = '\n';
+        t.size = i + t.digits + end;
+    }
+    return templates;
+}
+
+template<class Variant>
+constexpr std::array<LineTemplate, 256> LINE_TEMPLATES = makeLineTemplates<Variant>();
+
+/*
+    Line of the instruction at bytes (3 readable bytes), without
+    symbols. Every part is written whole and the parts that do not
+    belong to the instruction are overwritten, so that the random
+    opcodes of an image cost no mispredicted branch.
+*/
+template<class Variant>
+std::size_t templateLine(uint16_t addr, uint8_t const * bytes, char* out) {
+    LineTemplate const & t = LINE_TEMPLATES<Variant>[bytes[0]];
+    char* start = out;
+
+    out = hex4(out, addr);
+    std::memcpy(out, t.text, 8);
+
+    //Bytes column: "bd 34 12", the template from the end of the instruction
+    hex2(out + 2, bytes[0]);
+    hex2(out + 5, bytes[1]);
+    hex2(out + 8, bytes[2]);
+    std::memcpy(out + t.blank, t.text + t.blank, 24);
+
+    //Operand digits: 4 written, the suffix overwrites those past the operand
+    uint16_t word = bytes[1] | (bytes[2] << 8);
+    uint16_t target = addr + 2 + static_cast<int8_t>(bytes[1]);
+    uint16_t value = ((bytes[1] << 8) & t.byteMask) | (word & t.wordMask) | (target & t.targetMask);
+    hex4(out + t.operand, value);
+    std::memcpy(out + t.operand + t.digits, t.suffix, sizeof(t.suffix));
+
+    return out - start + t.size;
+}
+}
+
+/**** Symbols ****/
+template<class Variant>
+void Disassembler<Variant>::addSymbol(uint16_t addr, std::string const & name) {
+    symbols[addr] = name.substr(0, MAX_SYMBOL);
+    symbolMap[addr] = 1;
+}
+
+template<class Variant>
+void Disassembler<Variant>::clearSymbols() {
+    symbols.clear();
+    symbolMap.reset();
+}
+
+template<class Variant>
+char* Disassembler<Variant>::address(char* out, uint16_t addr, bool zeropage) const {
+    if(symbolMap[addr]) {
+        std::string const & name = symbols.find(addr)->second;
+        return text(out, name.data(), name.size());
+    }
+    *out++ = '$';
+    return zeropage ? hex2(out, addr) : hex4(out, addr);
+}
+/*****************/
+
+/**** Formatting ****/
+template<class Variant>
+std::size_t Disassembler<Variant>::instruction(uint16_t addr, uint8_t const * bytes, char* out) const {
+    InstructionInfo const & info = INSTRUCTIONS<Variant>[bytes[0]];
+    ModeFormat const format = modeFormat(info.mode);
+    char* start = out;
+
+    out = text(out, mnemonicName(info.mnemonic), 3);
+
+    //Only the operand bytes of the instruction (it may end the image)
+    uint8_t length = instructionLength(info.mode);
+    uint8_t LB = length > 1 ? bytes[1] : 0;
+    uint16_t word = length > 2 ? LB | (bytes[2] << 8) : LB;
+
+    out = text(out, format.prefix, format.prefixSize);
+    switch(format.operand) {
+        case Operand::none:
+            //Accumulator operand of the read-modify-write instructions
+            if(accessType(info.mnemonic) == Access::rmw) out = text(out, " A");
+            break;
+        case Operand::immediate:
+            *out++ = '$';
+            out = hex2(out, LB);
+            break;
+        case Operand::zeropage:
+            out = address(out, LB, true);
+            break;
+        case Operand::absolute:
+            out = address(out, word, false);
+            break;
+        case Operand::relative:
+            out = address(out, static_cast<uint16_t>(addr + 2 + static_cast<int8_t>(LB)), false);
+            break;
+    }
+    out = text(out, format.suffix, format.suffixSize);
+
+    return out - start;
+}
+
+template<class Variant>
+std::size_t Disassembler<Variant>::line(uint16_t addr, uint8_t const * bytes, char* out) const {
+    uint8_t length = instructionLength(INSTRUCTIONS<Variant>[bytes[0]].mode);
+    char* start = out;
+
+    out = hex4(out, addr);
+    out = text(out, "  ");
+    //Bytes column: "bd 34 12"
+    std::memset(out, ' ', 8);
+    for(uint8_t i = 0; i < length; ++i) {
+        hex2(out + 3*i, bytes[i]);
+    }
+    out = text(out + 8, "  ");
+    out += instruction(addr, bytes, out);
+    *out++ = '\n';
+
+    return out - start;
+}
+
+template<class Variant>
+std::size_t Disassembler<Variant>::traceLine(TraceRecord const & record, char* out) const {
+    uint8_t const bytes[3] = {record.opcode, record.operand[0], record.operand[1]};
+    char* start = out;
+
+    //Line without the newline, then the registers from column 40
+    std::size_t size = line(record.PC, bytes, out) - 1;
+    if(size < 40) {
+        std::memset(out + size, ' ', 40 - size);
+        size = 40;
+    } else {
+        out[size++] = ' ';
+    }
+    out += size;
+
+    out = hex2(text(out, "A:"), record.AC);
+    out = hex2(text(out, " X:"), record.X);
+    out = hex2(text(out, " Y:"), record.Y);
+    out = hex2(text(out, " P:"), record.SR);
+    out = hex2(text(out, " SP:"), record.SP);
+    out = decimal(text(out, " CYC:"), record.cycles);
+    *out++ = '\n';
+
+    return out - start;
+}
+/********************/
+
+/**** Bulk ****/
+template<class Variant>
+bool Disassembler<Variant>::disassemble(uint8_t const * image, std::size_t size, uint16_t base, int fd) const {
+    char buffer[BUFFER_SIZE];
+    std::size_t used = 0;
+
+    std::size_t offset = 0;
+    //Without symbols, lines from the templates up to the last two bytes
+    //(read as operands whatever the instruction)
+    if(symbols.empty()) {
+        while(offset + 3 <= size) {
+            used += templateLine<Variant>(base + offset, image + offset, buffer + used);
+            offset += LINE_TEMPLATES<Variant>[image[offset]].length;
+
+            if(used > BUFFER_SIZE - MAX_LINE) {
+                if(!writeAll(fd, buffer, used)) return false;
+                used = 0;
+            }
+        }
+    }
+
+    while(offset < size) {
+        uint8_t length = instructionLength(INSTRUCTIONS<Variant>[image[offset]].mode);
+        uint16_t addr = base + offset;
+        if(offset + length <= size) {
+            used += line(addr, image + offset, buffer + used);
+        } else {
+            //Truncated instruction at the end of the image
+            char* out = hex4(buffer + used, addr);
+            out = hex2(text(out, "  "), image[offset]);
+            out = hex2(text(out, "        .byte $"), image[offset]);
+            *out++ = '\n';
+            used = out - buffer;
+            length = 1;
+        }
+        offset += length;
+
+        if(used > BUFFER_SIZE - MAX_LINE) {
+            if(!writeAll(fd, buffer, used)) return false;
+            used = 0;
+        }
+    }
+
+    return writeAll(fd, buffer, used);
+}
+
+template<class Variant>
+bool Disassembler<Variant>::disassembleTrace(int inputFd, int outputFd) const {
+    constexpr std::size_t RECORDS{1024};
+    TraceRecord records[RECORDS];
+    char* input = reinterpret_cast<char*>(records);
+    std::size_t pending = 0;        //Bytes read in records
+    char buffer[BUFFER_SIZE];
+    std::size_t used = 0;
+
+    for(;;) {
+        ssize_t n = ::read(inputFd, input + pending, sizeof(records) - pending);
+        if(n < 0 && errno == EINTR) continue;
+        if(n <= 0) break;
+        pending += n;
+
+        std::size_t complete = pending / sizeof(TraceRecord);
+        for(std::size_t i = 0; i < complete; ++i) {
+            used += traceLine(records[i], buffer + used);
+            if(used > BUFFER_SIZE - MAX_LINE) {
+                if(!writeAll(outputFd, buffer, used)) return false;
+                used = 0;
+            }
+        }
+
+        //Keep the partial record for the next read
+        std::size_t consumed = complete * sizeof(TraceRecord);
+        std::memmove(input, input + consumed, pending - consumed);
+        pending -= consumed;
+    }
+
+    return writeAll(outputFd, buffer, used);
+}
+/**************/
+
+template class Disassembler<NMOS6502>;
+template class Disassembler<CMOS65C02>;
+template class Disassembler<RP2A03>;
@@ -0,0 +1,63 @@
+#ifndef DISASSEMBLER_H
+#define DISASSEMBLER_H
+
+#include <string>
+#include <bitset>
+#include <unordered_map>
+#include <cstdint>
+#include <cstddef>
+#include "../cpu/Variants.h"
+#include "../cpu/Instructions.h"
+#include "Trace.h"
+
+/*
+    Table-driven disassembler (mnemonics and addressing modes from
+    INSTRUCTIONS<Variant>).
+
+    The formatting functions write into a caller buffer of at least
+    MAX_LINE chars, return the number of chars written (no terminating
+    null) and never allocate:
+
+        char text[Disassembler<NMOS6502>::MAX_LINE];
+        std::size_t size = disassembler.line(0xf000, bytes, text);
+
+    gives "f000  bd 34 12  LDA $1234,X\n". Operand addresses with a
+    symbol are replaced by its name ("LDA counter,X"); the symbols are
+    copied by addSymbol(), before disassembling.
+
+    The bulk functions format a whole image (linear sweep) or a binary
+    trace file (see Trace.h) to a file descriptor through a fixed
+    buffer, one write per BUFFER_SIZE bytes.
+*/
+template<class Variant>
+class Disassembler {
+public:
+    static constexpr std::size_t MAX_SYMBOL{32};    //Longer names are truncated
+    static constexpr std::size_t MAX_LINE{128};
+    static constexpr std::size_t BUFFER_SIZE{1 << 16};
+
+    void addSymbol(uint16_t addr, std::string const & name);
+    void clearSymbols();
+
+    //"LDA $1234,X" (bytes: opcode and operands)
+    std::size_t instruction(uint16_t addr, uint8_t const * bytes, char* out) const;
+    //"f000  bd 34 12  LDA $1234,X\n"
+    std::size_t line(uint16_t addr, uint8_t const * bytes, char* out) const;
+    //Line of a trace record, with the registers before the instruction
+    //and the cycle counter (decimal)
+    std::size_t traceLine(TraceRecord const & record, char* out) const;
+
+    //Disassemble image (loaded at base) to fd (false on write error)
+    bool disassemble(uint8_t const * image, std::size_t size, uint16_t base, int fd) const;
+    //Format the trace records read from inputFd to outputFd
+    bool disassembleTrace(int inputFd, int outputFd) const;
+
+private:
+    std::bitset<0x10000> symbolMap;
+    std::unordered_map<uint16_t, std::string> symbols;
+
+    //Operand address, or its symbol
+    char* address(char* out, uint16_t addr, bool zeropage) const;
+};
+
+#endif
@@ -0,0 +1,103 @@
+#ifndef FORMAT_H
+#define FORMAT_H
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+
+/*
+    Text output without allocation, shared by the disassembler, the
+    heatmap and the memory dumps: every function writes at out and
+    returns the end of what it wrote (lowercase hex, no prefix).
+
+    writeAll()/readAll() move a whole buffer through a file descriptor,
+    retrying on EINTR and short transfers (false on error or end of
+    file).
+*/
+namespace Format {
+
+constexpr char HEX[] = "0123456789abcdef";
+
+//Both digits of every byte
+struct HexPair {
+    char digits[2];
+};
+
+constexpr std::array<HexPair, 256> makeHexPairs() {
+    std::array<HexPair, 256> pairs{};
+    for(unsigned value = 0; value < 0x100; ++value) {
+        pairs[value] = {{HEX[value >> 4], HEX[value & 0x0f]}};
+    }
+    return pairs;
+}
+
+inline constexpr std::array<HexPair, 256> HEX_PAIRS = makeHexPairs();
+
+inline char* hex2(char* out, uint8_t value) {
+    std::memcpy(out, HEX_PAIRS[value].digits, 2);
+    return out + 2;
+}
+
+inline char* hex4(char* out, uint16_t value) {
+    return hex2(hex2(out, value >> 8), value);
+}
+
+inline char* text(char* out, char const * string, std::size_t size) {
+    std::memcpy(out, string, size);
+    return out + size;
+}
+
+template<std::size_t N>
+char* text(char* out, char const (&string)[N]) {
+    return text(out, string, N-1);
+}
+
+inline char* decimal(char* out, uint64_t value) {
+    char digits[20];
+    std::size_t size = 0;
+    do {
+        digits[size++] = '0' + value % 10;
+        value /= 10;
+    } while(value);
+    while(size) *out++ = digits[--size];
+    return out;
+}
+
+inline char* decimal(char* out, int64_t value) {
+    if(value < 0) {
+        *out++ = '-';
+        return decimal(out, uint64_t{0} - static_cast<uint64_t>(value));
+    }
+    return decimal(out, static_cast<uint64_t>(value));
+}
+
+inline bool writeAll(int fd, void const * data, std::size_t size) {
+    char const * bytes = static_cast<char const *>(data);
+    while(size > 0) {
+        ssize_t n = ::write(fd, bytes, size);
+        if(n < 0 && errno == EINTR) continue;
+        if(n <= 0) return false;
+        bytes += n;
+        size -= n;
+    }
+    return true;
+}
+
+inline bool readAll(int fd, void* data, std::size_t size) {
+    char* bytes = static_cast<char*>(data);
+    while(size > 0) {
+        ssize_t n = ::read(fd, bytes, size);
+        if(n < 0 && errno == EINTR) continue;
+        if(n <= 0) return false;
+        bytes += n;
+        size -= n;
+    }
+    return true;
+}
+
+}
+
+#endif
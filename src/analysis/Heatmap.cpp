@@ -0,0 +1,172 @@
+#include "Heatmap.h"
+#include "Format.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace Format;
+
+namespace {
+
+constexpr std::size_t ADDRESSES{0x10000};
+constexpr std::size_t BUFFER_SIZE{1 << 14};
+constexpr std::size_t MAX_LINE{80};
+
+//Binary file: header, then the reads, writes and fetches (uint64_t each)
+struct Header {
+    char magic[4];
+    uint32_t version;
+};
+constexpr Header HEADER{{'H', 'E', 'A', 'T'}, 1};
+
+bool validPageSize(std::size_t pageSize) {
+    return pageSize > 0 && pageSize <= ADDRESSES && (pageSize & (pageSize - 1)) == 0;
+}
+
+//"0200,1,-2,3\n"
+template<class Count>
+char* csvLine(char* out, uint16_t addr, Count reads, Count writes, Count fetches) {
+    out = hex4(out, addr);
+    *out++ = ',';
+    out = decimal(out, reads);
+    *out++ = ',';
+    out = decimal(out, writes);
+    *out++ = ',';
+    out = decimal(out, fetches);
+    *out++ = '\n';
+    return out;
+}
+
+}
+
+Heatmap::Heatmap():
+    reads(ADDRESSES), writes(ADDRESSES), fetches(ADDRESSES)
+{}
+
+void Heatmap::clear() {
+    std::fill(reads.begin(), reads.end(), 0);
+    std::fill(writes.begin(), writes.end(), 0);
+    std::fill(fetches.begin(), fetches.end(), 0);
+}
+
+PageHeat Heatmap::page(uint16_t start, std::size_t pageSize) const {
+    PageHeat heat{start, 0, 0, 0};
+    for(std::size_t addr = start; addr < start + pageSize; ++addr) {
+        heat.reads += reads[addr];
+        heat.writes += writes[addr];
+        heat.fetches += fetches[addr];
+    }
+    return heat;
+}
+
+/**** Summary ****/
+std::vector<PageHeat> Heatmap::hottestPages(std::size_t count, std::size_t pageSize) const {
+    std::vector<PageHeat> pages;
+    if(!validPageSize(pageSize)) return pages;
+
+    for(std::size_t start = 0; start < ADDRESSES; start += pageSize) {
+        PageHeat heat = page(start, pageSize);
+        if(heat.total() > 0) pages.push_back(heat);
+    }
+
+    count = std::min(count, pages.size());
+    std::partial_sort(pages.begin(), pages.begin() + count, pages.end(),
+        [](PageHeat const & a, PageHeat const & b) {
+            return a.total() != b.total() ? a.total() > b.total() : a.start < b.start;
+        });
+    pages.resize(count);
+    return pages;
+}
+
+std::vector<PageChange> Heatmap::diffPages(Heatmap const & before, std::size_t count, std::size_t pageSize) const {
+    std::vector<PageChange> pages;
+    if(!validPageSize(pageSize)) return pages;
+
+    for(std::size_t start = 0; start < ADDRESSES; start += pageSize) {
+        PageHeat a = before.page(start, pageSize);
+        PageHeat b = page(start, pageSize);
+        PageChange change{b.start,
+                          static_cast<int64_t>(b.reads - a.reads),
+                          static_cast<int64_t>(b.writes - a.writes),
+                          static_cast<int64_t>(b.fetches - a.fetches)};
+        if(change.reads || change.writes || change.fetches) pages.push_back(change);
+    }
+
+    auto magnitude = [](PageChange const & change) {
+        int64_t total = change.total();
+        return total < 0 ? uint64_t{0} - static_cast<uint64_t>(total) : static_cast<uint64_t>(total);
+    };
+    count = std::min(count, pages.size());
+    std::partial_sort(pages.begin(), pages.begin() + count, pages.end(),
+        [&magnitude](PageChange const & a, PageChange const & b) {
+            return magnitude(a) != magnitude(b) ? magnitude(a) > magnitude(b) : a.start < b.start;
+        });
+    pages.resize(count);
+    return pages;
+}
+/*****************/
+
+/**** Export ****/
+bool Heatmap::save(int fd) const {
+    return writeAll(fd, &HEADER, sizeof(HEADER)) &&
+           writeAll(fd, reads.data(), ADDRESSES * sizeof(uint64_t)) &&
+           writeAll(fd, writes.data(), ADDRESSES * sizeof(uint64_t)) &&
+           writeAll(fd, fetches.data(), ADDRESSES * sizeof(uint64_t));
+}
+
+bool Heatmap::load(int fd) {
+    Header header;
+    if(!readAll(fd, &header, sizeof(header)) ||
+       std::memcmp(header.magic, HEADER.magic, sizeof(header.magic)) != 0 ||
+       header.version != HEADER.version) {
+        return false;
+    }
+
+    //Left cleared if the file is truncated
+    if(readAll(fd, reads.data(), ADDRESSES * sizeof(uint64_t)) &&
+       readAll(fd, writes.data(), ADDRESSES * sizeof(uint64_t)) &&
+       readAll(fd, fetches.data(), ADDRESSES * sizeof(uint64_t))) {
+        return true;
+    }
+    clear();
+    return false;
+}
+
+bool Heatmap::writeCSV(int fd) const {
+    char buffer[BUFFER_SIZE];
+    static constexpr char TITLE[] = "address,reads,writes,fetches\n";
+    std::memcpy(buffer, TITLE, sizeof(TITLE) - 1);
+    std::size_t used = sizeof(TITLE) - 1;
+
+    for(std::size_t addr = 0; addr < ADDRESSES; ++addr) {
+        if(!reads[addr] && !writes[addr] && !fetches[addr]) continue;
+        used = csvLine(buffer + used, addr, reads[addr], writes[addr], fetches[addr]) - buffer;
+        if(used > BUFFER_SIZE - MAX_LINE) {
+            if(!writeAll(fd, buffer, used)) return false;
+            used = 0;
+        }
+    }
+
+    return writeAll(fd, buffer, used);
+}
+
+bool Heatmap::writeDiffCSV(Heatmap const & before, int fd) const {
+    char buffer[BUFFER_SIZE];
+    static constexpr char TITLE[] = "address,reads,writes,fetches\n";
+    std::memcpy(buffer, TITLE, sizeof(TITLE) - 1);
+    std::size_t used = sizeof(TITLE) - 1;
+
+    for(std::size_t addr = 0; addr < ADDRESSES; ++addr) {
+        int64_t r = reads[addr] - before.reads[addr];
+        int64_t w = writes[addr] - before.writes[addr];
+        int64_t f = fetches[addr] - before.fetches[addr];
+        if(!r && !w && !f) continue;
+        used = csvLine(buffer + used, addr, r, w, f) - buffer;
+        if(used > BUFFER_SIZE - MAX_LINE) {
+            if(!writeAll(fd, buffer, used)) return false;
+            used = 0;
+        }
+    }
+
+    return writeAll(fd, buffer, used);
+}
+/****************/
@@ -0,0 +1,79 @@
+#ifndef HEATMAP_H
+#define HEATMAP_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "../cpu/Hooks.h"
+
+//Accesses to a page (or their change between two heatmaps)
+template<class Count>
+struct PageCounts {
+    uint16_t start;             //First address of the page
+    Count reads;
+    Count writes;
+    Count fetches;
+
+    Count total() const { return reads + writes + fetches; }
+};
+
+using PageHeat = PageCounts<uint64_t>;
+using PageChange = PageCounts<int64_t>;
+
+/*
+    Hooks counting the accesses to every address: data reads (stack
+    and vectors included), writes, and fetches (opcode and operand
+    bytes read through PC, immediate operands included).
+
+    The counters are only updated by the hooked interpreter, so the
+    CPU runs at full speed without them:
+
+        Heatmap heatmap;
+        cpu.setHooks(&heatmap);
+        cpu.execute(0x0400, 0xffff);
+        cpu.setHooks(nullptr);
+        for(PageHeat const & page : heatmap.hottestPages(10)) ...
+
+    Pages are pageSize bytes, a power of two up to 0x10000.
+
+    Export: save() writes the counters in binary (host byte order,
+    read back with load()), writeCSV() one line per address accessed:
+
+        address,reads,writes,fetches
+        0200,0,0,12
+*/
+class Heatmap : public CPUHooks {
+public:
+    Heatmap();
+
+    void memoryFetch(uint16_t addr, uint8_t) override { ++fetches[addr]; }
+    void memoryRead(uint16_t addr, uint8_t) override { ++reads[addr]; }
+    void memoryWrite(uint16_t addr, uint8_t) override { ++writes[addr]; }
+
+    uint64_t readCount(uint16_t addr) const { return reads[addr]; }
+    uint64_t writeCount(uint16_t addr) const { return writes[addr]; }
+    uint64_t fetchCount(uint16_t addr) const { return fetches[addr]; }
+
+    void clear();
+
+    //Pages with the most accesses, hottest first (no untouched page)
+    std::vector<PageHeat> hottestPages(std::size_t count, std::size_t pageSize = 0x100) const;
+    //Pages whose accesses changed the most from before to this heatmap
+    std::vector<PageChange> diffPages(Heatmap const & before, std::size_t count, std::size_t pageSize = 0x100) const;
+
+    //False on write error (load: on read error or bad header)
+    bool save(int fd) const;
+    bool load(int fd);
+    bool writeCSV(int fd) const;
+    //Lines of the addresses whose counters changed from before (signed)
+    bool writeDiffCSV(Heatmap const & before, int fd) const;
+
+private:
+    std::vector<uint64_t> reads;
+    std::vector<uint64_t> writes;
+    std::vector<uint64_t> fetches;
+
+    PageHeat page(uint16_t start, std::size_t pageSize) const;
+};
+
+#endif
@@ -0,0 +1,201 @@
+#include "Lockstep.h"
+#include <algorithm>
+#include <random>
+#include <cstring>
+
+namespace {
+
+bool sameState(CPUState const & a, CPUState const & b) {
+    return a.PC == b.PC && a.AC == b.AC && a.X == b.X && a.Y == b.Y &&
+           a.SR == b.SR && a.SP == b.SP && a.cycles == b.cycles;
+}
+
+//Pages written in either memory since the last sync()
+template<class F>
+void forWrittenPages(Memory const & a, Memory const & b, F f) {
+    for(unsigned i = 0; i < a.pages().dirty.size(); ++i) {
+        for(uint64_t bits = a.pages().dirty[i] | b.pages().dirty[i]; bits; bits &= bits - 1) {
+            f(static_cast<uint16_t>((i*64 + __builtin_ctzll(bits)) << 8));
+        }
+    }
+}
+
+}
+
+template<class Variant>
+Lockstep<Variant>::Lockstep():
+    cores{MOS6502Core<Variant>(memories[0].pages()), MOS6502Core<Variant>(memories[1].pages())},
+    image(SIZE)
+{}
+
+template<class Variant>
+MOS6502Core<Variant>& Lockstep<Variant>::reference() {
+    return cores[0];
+}
+
+template<class Variant>
+MOS6502Core<Variant>& Lockstep<Variant>::candidate() {
+    return cores[1];
+}
+
+template<class Variant>
+Memory& Lockstep<Variant>::referenceMemory() {
+    return memories[0];
+}
+
+template<class Variant>
+Memory& Lockstep<Variant>::candidateMemory() {
+    return memories[1];
+}
+
+template<class Variant>
+void Lockstep<Variant>::setEngine(Engine const & engine) {
+    this->engine = engine;
+}
+
+template<class Variant>
+void Lockstep<Variant>::load(uint16_t addr, uint8_t const * data, std::size_t size) {
+    size = std::min<std::size_t>(size, SIZE - addr);
+    for(Memory& memory : memories) {
+        std::memcpy(memory.data() + addr, data, size);
+        memory.markDirty(addr, size);
+    }
+}
+
+template<class Variant>
+void Lockstep<Variant>::start(CPUState const & state) {
+    std::memcpy(image.data(), memories[0].data(), SIZE);
+    std::memcpy(memories[1].data(), memories[0].data(), SIZE);
+    for(std::size_t i = 0; i < 2; ++i) {
+        memories[i].sync();
+        cores[i].setState(state);
+    }
+    agreed = state;
+    found = Divergence{};
+}
+
+template<class Variant>
+bool Lockstep<Variant>::run(uint64_t cycles, uint64_t blockCycles) {
+    blockCycles = std::max<uint64_t>(blockCycles, 1);
+    uint64_t end = cores[0].getCycles() + cycles;
+
+    while(cores[0].getCycles() < end) {
+        advance(std::min(cores[0].getCycles() + blockCycles, end));
+        if(!compare()) {
+            bisect(cores[0].getCycles() - agreed.cycles);
+            return false;
+        }
+        accept();
+    }
+    return true;
+}
+
+template<class Variant>
+Divergence const & Lockstep<Variant>::divergence() const {
+    return found;
+}
+
+template<class Variant>
+void Lockstep<Variant>::advance(uint64_t end) {
+    engine(end);
+
+    //An engine stopping early is caught by the comparison of the cycles
+    uint64_t target = std::max(cores[1].getCycles(), end);
+    while(cores[0].getCycles() < target) cores[0].step();
+}
+
+template<class Variant>
+bool Lockstep<Variant>::compare() const {
+    if(!sameState(cores[0].getState(), cores[1].getState())) return false;
+
+    bool same = true;
+    forWrittenPages(memories[0], memories[1], [this, &same](uint16_t addr) {
+        same = same && std::memcmp(memories[0].data() + addr, memories[1].data() + addr, 0x100) == 0;
+    });
+    return same;
+}
+
+template<class Variant>
+void Lockstep<Variant>::accept() {
+    forWrittenPages(memories[0], memories[1], [this](uint16_t addr) {
+        std::memcpy(image.data() + addr, memories[0].data() + addr, 0x100);
+    });
+    memories[0].sync();
+    memories[1].sync();
+    agreed = cores[0].getState();
+}
+
+template<class Variant>
+void Lockstep<Variant>::restore() {
+    forWrittenPages(memories[0], memories[1], [this](uint16_t addr) {
+        std::memcpy(memories[0].data() + addr, image.data() + addr, 0x100);
+        std::memcpy(memories[1].data() + addr, image.data() + addr, 0x100);
+    });
+    for(std::size_t i = 0; i < 2; ++i) {
+        memories[i].sync();
+        cores[i].setState(agreed);
+    }
+}
+
+/*
+    The cores agree after a budget of lo cycles from the agreed state
+    and differ after hi: halve the interval until a single instruction
+    separates the two runs.
+*/
+template<class Variant>
+void Lockstep<Variant>::bisect(uint64_t span) {
+    uint64_t lo = 0;
+    uint64_t hi = span;
+    CPUState before = agreed;
+
+    while(hi - lo > 1) {
+        uint64_t mid = lo + (hi - lo) / 2;
+        restore();
+        advance(agreed.cycles + mid);
+        if(compare()) {
+            lo = mid;
+            before = cores[0].getState();
+        } else {
+            hi = mid;
+        }
+    }
+
+    //Leave the cores after the diverging instruction
+    restore();
+    advance(agreed.cycles + hi);
+    record();
+    found.before = before;
+}
+
+template<class Variant>
+void Lockstep<Variant>::record() {
+    found.reference = cores[0].getState();
+    found.candidate = cores[1].getState();
+    found.memory = diff(memories[0].data(), memories[1].data(), SIZE);
+}
+
+template<class Variant>
+void randomInstructions(uint8_t* data, std::size_t size, uint32_t seed) {
+    std::vector<uint8_t> legal;
+    for(unsigned opcode = 0; opcode < 0x100; ++opcode) {
+        if(INSTRUCTIONS<Variant>[opcode].mnemonic != Mnemonic::ILL) legal.push_back(opcode);
+    }
+
+    std::mt19937 rng(seed);
+    std::size_t i = 0;
+    while(i < size) {
+        uint8_t opcode = legal[rng() % legal.size()];
+        data[i++] = opcode;
+        for(uint8_t k = 1; k < instructionLength(INSTRUCTIONS<Variant>[opcode].mode) && i < size; ++k) {
+            data[i++] = rng();
+        }
+    }
+}
+
+template class Lockstep<NMOS6502>;
+template class Lockstep<CMOS65C02>;
+template class Lockstep<RP2A03>;
+
+template void randomInstructions<NMOS6502>(uint8_t*, std::size_t, uint32_t);
+template void randomInstructions<CMOS65C02>(uint8_t*, std::size_t, uint32_t);
+template void randomInstructions<RP2A03>(uint8_t*, std::size_t, uint32_t);
@@ -0,0 +1,105 @@
+#ifndef LOCKSTEP_H
+#define LOCKSTEP_H
+
+#include <functional>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "../cpu/MOS6502.h"
+#include "../memory/Memory.h"
+
+//First difference found between the two engines
+struct Divergence {
+    CPUState before;                    //Last state on which they agreed
+    CPUState reference;                 //States after the diverging run
+    CPUState candidate;
+    std::vector<MemoryRange> memory;    //Bytes that differ
+};
+
+/*
+    Differential testing of an engine against the interpreter.
+
+    The harness owns two memories and two cores: the reference, run
+    by MOS6502Core::step(), and the candidate, run by the engine under
+    test (cycle-exact engine, recompiled code...). The engine is a
+    function running the candidate until its cycle counter reaches end,
+    one whole instruction at a time:
+
+        Lockstep<NMOS6502> lockstep;
+        CycleEngine<NMOS6502> engine(lockstep.candidate());
+        lockstep.setEngine([&](uint64_t end) {
+            while(lockstep.candidate().getCycles() < end) engine.step();
+        });
+        lockstep.load(0x0400, program, size);
+        lockstep.start(state);
+        if(!lockstep.run(1000000000, 1000)) report(lockstep.divergence());
+
+    run() gives the engine blockCycles at a time (1: every instruction),
+    runs the reference up to the same cycle, and compares registers,
+    flags, cycle counters and the memory pages written by either side
+    (the values in memory, not the sequence of bus writes). On a
+    difference it bisects the block, replaying it from the last state
+    on which they agreed with smaller budgets, down to the instruction
+    that diverges: divergence().before is the state before it (its PC
+    the address of the instruction), and the cores are left after it.
+
+    The engine must only keep its state in the core and the memory
+    between two calls, since bisection replays the blocks. The memories
+    are flat RAM (no I/O), accessed directly by both cores.
+*/
+template<class Variant>
+class Lockstep {
+public:
+    using Engine = std::function<void(uint64_t end)>;
+
+    Lockstep();
+
+    Lockstep(Lockstep const &) = delete;
+    Lockstep& operator=(Lockstep const &) = delete;
+
+    MOS6502Core<Variant>& reference();
+    MOS6502Core<Variant>& candidate();
+    Memory& referenceMemory();
+    Memory& candidateMemory();
+
+    void setEngine(Engine const & engine);
+
+    //Same bytes in both memories
+    void load(uint16_t addr, uint8_t const * data, std::size_t size);
+    //Both cores from state, the current memory as first agreed state
+    void start(CPUState const & state);
+
+    //Run for the given cycles, false at the first divergence
+    bool run(uint64_t cycles, uint64_t blockCycles = 1);
+    Divergence const & divergence() const;
+
+private:
+    Memory memories[2];                 //Reference, candidate
+    MOS6502Core<Variant> cores[2];
+    Engine engine;
+
+    //Last state on which the cores agreed
+    CPUState agreed{};
+    std::vector<uint8_t> image;
+    Divergence found{};
+
+    //Engine until end, then the reference up to the same cycle
+    void advance(uint64_t end);
+    bool compare() const;
+    //Make the current state the agreed one
+    void accept();
+    //Back to the agreed state
+    void restore();
+    void bisect(uint64_t span);
+    void record();
+};
+
+/*
+    Random instruction stream: size bytes of legal opcodes of the
+    variant, each followed by random operand bytes. Fill the whole
+    address space to let the jumps land anywhere.
+*/
+template<class Variant>
+void randomInstructions(uint8_t* data, std::size_t size, uint32_t seed);
+
+#endif
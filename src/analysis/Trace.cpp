@@ -0,0 +1,30 @@
+#include "Trace.h"
+#include "Format.h"
+
+TraceRecorder::TraceRecorder(int fd):
+    fd{fd}
+{}
+
+TraceRecorder::~TraceRecorder() {
+    flush();
+}
+
+void TraceRecorder::preInstruction(DecodedInstruction const & instruction, CPUState const & state) {
+    //Only the operand bytes of the instruction are valid
+    uint8_t length = instructionLength(instruction.info.mode);
+    TraceRecord& record = buffer[size++];
+    record = TraceRecord{state.cycles, instruction.PC, instruction.opcode,
+                         {length > 1 ? instruction.operand[0] : uint8_t{0},
+                          length > 2 ? instruction.operand[1] : uint8_t{0}},
+                         state.AC, state.X, state.Y, state.SR, state.SP, {}};
+
+    if(size == BUFFER_RECORDS) {
+        flush();
+    }
+}
+
+void TraceRecorder::flush() {
+    //The trace is lost if the file is not writable
+    Format::writeAll(fd, buffer.data(), size * sizeof(TraceRecord));
+    size = 0;
+}
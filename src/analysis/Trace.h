@@ -0,0 +1,58 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include "../cpu/Hooks.h"
+
+/*
+    Binary instruction trace: one fixed-size record per instruction,
+    in host byte order, with the registers before the instruction.
+    A trace file is a plain sequence of records (see
+    Disassembler::disassembleTrace() to turn it into text).
+*/
+struct TraceRecord {
+    uint64_t cycles;
+    uint16_t PC;
+    uint8_t opcode;
+    uint8_t operand[2];
+    uint8_t AC;
+    uint8_t X;
+    uint8_t Y;
+    uint8_t SR;
+    uint8_t SP;
+    uint8_t reserved[6];
+};
+
+static_assert(sizeof(TraceRecord) == 24, "TraceRecord must not be padded");
+
+/*
+    Hooks writing the trace of the executed instructions to a file
+    descriptor (buffered, one write per BUFFER_RECORDS records):
+
+        TraceRecorder recorder(fd);
+        cpu.setHooks(&recorder);
+*/
+class TraceRecorder : public CPUHooks {
+public:
+    explicit TraceRecorder(int fd);
+    ~TraceRecorder() override;
+
+    TraceRecorder(TraceRecorder const &) = delete;
+    TraceRecorder& operator=(TraceRecorder const &) = delete;
+
+    void preInstruction(DecodedInstruction const & instruction, CPUState const & state) override;
+
+    //Write the buffered records
+    void flush();
+
+    static constexpr std::size_t BUFFER_RECORDS{4096};
+
+private:
+    int fd;
+    std::array<TraceRecord, BUFFER_RECORDS> buffer;
+    std::size_t size{0};
+};
+
+#endif
@@ -0,0 +1,89 @@
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <vector>
+#include "../bus/Bus.h"
+#include "../bus/Devices.h"
+
+/*
+    Decode cost of the Bus compared to the usual chain of range checks
+    in a hand-written memoryRead()/memoryWrite() pair, on the same
+    memory map (NES-like: mirrored RAM, I/O registers, ROM).
+*/
+
+struct Registers : Device {
+    uint8_t registers[8] = {0};
+    uint8_t read(uint16_t offset) override { return registers[offset]; }
+    void write(uint16_t offset, uint8_t data) override { registers[offset] = data; }
+};
+
+static uint8_t ifRAM[0x0800];
+static uint8_t ifROM[0x8000];
+static uint8_t ifRegisters[8];
+
+static uint8_t ifChainRead(uint16_t addr) {
+    if(addr < 0x2000) return ifRAM[addr & 0x07ff];
+    else if(addr >= 0x2000 && addr < 0x4000) return ifRegisters[addr & 0x07];
+    else if(addr >= 0x8000) return ifROM[addr - 0x8000];
+    return 0xff;
+}
+
+static void ifChainWrite(uint16_t addr, uint8_t data) {
+    if(addr < 0x2000) ifRAM[addr & 0x07ff] = data;
+    else if(addr >= 0x2000 && addr < 0x4000) ifRegisters[addr & 0x07] = data;
+}
+
+template<class F>
+static double measure(F f, std::size_t accesses) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / accesses;
+}
+
+int main(void) {
+    constexpr std::size_t ACCESSES = 1 << 24;
+
+    //CPU-like mix: mostly RAM and ROM, some I/O
+    std::mt19937 rng(6502);
+    std::vector<uint16_t> addresses(ACCESSES);
+    for(auto & addr : addresses) {
+        unsigned r = rng() % 16;
+        if(r < 6)       addr = rng() % 0x2000;
+        else if(r < 7)  addr = 0x2000 + rng() % 8;
+        else            addr = 0x8000 + rng() % 0x8000;
+    }
+
+    RAM ram(0x0800);
+    Mirror mirror(ram, 0x0800);
+    ROM rom(std::vector<uint8_t>(0x8000, 0xea));
+    Registers registers;
+    Mirror registersMirror(registers, 8);
+
+    Bus bus;
+    bus.map(0x0000, 0x1fff, mirror);
+    bus.map(0x2000, 0x3fff, registersMirror);
+    bus.map(0x8000, 0xffff, rom);
+
+    unsigned sum = 0;
+    double ifChain = measure([&] {
+        for(uint16_t addr : addresses) {
+            uint8_t data = ifChainRead(addr);
+            ifChainWrite(addr, data + 1);
+            sum += data;
+        }
+    }, ACCESSES);
+    double decoder = measure([&] {
+        for(uint16_t addr : addresses) {
+            uint8_t data = bus.read(addr);
+            bus.write(addr, data + 1);
+            sum += data;
+        }
+    }, ACCESSES);
+
+    std::cout << "if-chain: " << ifChain << " ns/read+write\n"
+              << "Bus:      " << decoder << " ns/read+write\n"
+              << "(checksum " << sum << ")\n";
+
+    return 0;
+}
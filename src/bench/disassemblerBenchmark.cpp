@@ -0,0 +1,123 @@
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include "../analysis/Disassembler.h"
+
+/*
+    Throughput of the disassembler on a random 64 KiB image, compared
+    to the same lines formatted with std::ostringstream (as info()
+    formats the registers), and of the bulk functions to /dev/null.
+
+    The bulk rates are given per input byte (the image or the trace),
+    then per output byte. Images are disassembled without symbols, by
+    the line templates of disassemble().
+*/
+
+static std::string streamLine(uint16_t addr, uint8_t const * bytes) {
+    InstructionInfo const & info = INSTRUCTIONS<NMOS6502>[bytes[0]];
+    uint8_t length = instructionLength(info.mode);
+    std::ostringstream out;
+
+    out << std::hex << std::setfill('0') << std::setw(4) << addr << "  ";
+    for(uint8_t i = 0; i < 3; ++i) {
+        if(i < length) out << std::setw(2) << +bytes[i] << " ";
+        else           out << "   ";
+    }
+    out << " " << mnemonicName(info.mnemonic);
+    if(length == 2)      out << " $" << std::setw(2) << +bytes[1];
+    else if(length == 3) out << " $" << std::setw(4) << (bytes[1] | (bytes[2] << 8));
+    out << "\n";
+    return out.str();
+}
+
+template<class F>
+static double measure(F f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+int main(void) {
+    constexpr int ROUNDS = 20;
+
+    std::mt19937 rng(6502);
+    std::vector<uint8_t> image(0x10002);
+    for(auto & byte : image) byte = rng();
+
+    Disassembler<NMOS6502> disassembler;
+    int null = open("/dev/null", O_WRONLY);
+
+    std::size_t streamBytes = 0;
+    double stream = measure([&] {
+        for(int round = 0; round < ROUNDS; ++round) {
+            for(unsigned addr = 0; addr < 0x10000;) {
+                std::string line = streamLine(addr, &image[addr]);
+                streamBytes += line.size();
+                addr += instructionLength(INSTRUCTIONS<NMOS6502>[image[addr]].mode);
+            }
+        }
+    });
+
+    std::size_t lineBytes = 0;
+    double lines = measure([&] {
+        char out[Disassembler<NMOS6502>::MAX_LINE];
+        for(int round = 0; round < ROUNDS; ++round) {
+            for(unsigned addr = 0; addr < 0x10000;) {
+                lineBytes += disassembler.line(addr, &image[addr], out);
+                addr += instructionLength(INSTRUCTIONS<NMOS6502>[image[addr]].mode);
+            }
+        }
+    });
+
+    double bulk = measure([&] {
+        for(int round = 0; round < ROUNDS; ++round) {
+            disassembler.disassemble(image.data(), 0x10000, 0x0000, null);
+        }
+    });
+
+    //Random registers and instructions, from a temporary file
+    std::vector<TraceRecord> records(1 << 18);
+    std::size_t traceBytes = 0;
+    char out[Disassembler<NMOS6502>::MAX_LINE];
+    for(auto & record : records) {
+        record = TraceRecord{rng(), static_cast<uint16_t>(rng()), static_cast<uint8_t>(rng()),
+                             {static_cast<uint8_t>(rng()), static_cast<uint8_t>(rng())},
+                             static_cast<uint8_t>(rng()), static_cast<uint8_t>(rng()),
+                             static_cast<uint8_t>(rng()), static_cast<uint8_t>(rng()),
+                             static_cast<uint8_t>(rng()), {}};
+        traceBytes += disassembler.traceLine(record, out);
+    }
+    char traceFile[] = "/tmp/disassemblerBenchmarkXXXXXX";
+    int trace = mkstemp(traceFile);
+    std::size_t recordBytes = records.size() * sizeof(TraceRecord);
+    if(trace < 0 || write(trace, records.data(), recordBytes) != static_cast<ssize_t>(recordBytes)) {
+        std::cout << "ERROR: couldn't write the trace file\n";
+        return 1;
+    }
+    unlink(traceFile);
+
+    constexpr int TRACE_ROUNDS = 5;
+    double traced = measure([&] {
+        for(int round = 0; round < TRACE_ROUNDS; ++round) {
+            lseek(trace, 0, SEEK_SET);
+            disassembler.disassembleTrace(trace, null);
+        }
+    });
+
+    std::cout << "ostringstream:       " << streamBytes / stream / 1e6 << " MB/s of text\n"
+              << "line():              " << lineBytes / lines / 1e6 << " MB/s of text\n"
+              << "disassemble():       " << ROUNDS * 0x10000 / bulk / 1e6 << " MB/s of image, "
+              << lineBytes / bulk / 1e6 << " MB/s of text\n"
+              << "disassembleTrace():  " << TRACE_ROUNDS * recordBytes / traced / 1e6 << " MB/s of trace, "
+              << TRACE_ROUNDS * traceBytes / traced / 1e6 << " MB/s of text\n";
+
+    close(trace);
+    close(null);
+    return 0;
+}
@@ -0,0 +1,87 @@
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <vector>
+#include "../memory/Memory.h"
+
+/*
+    Dump of the whole 64 KiB with the previous std::ostringstream
+    formatting (up to 0xfffe: it never ended at 0xffff), Memory::dump()
+    and the hex/ASCII dumper, and throughput of the image diff.
+*/
+
+static std::string streamDump(Memory const & memory, uint16_t start, uint16_t end) {
+    std::ostringstream out;
+
+    for(uint16_t i = start; i <= end; ++i) {
+        if(i % 16 == 0) {
+            out << "\n" << std::hex
+                << std::setw(4) << std::setfill('0')
+                << +i << ": ";
+        }
+        out << std::hex
+            << std::setw(2) << std::setfill('0')
+            << +memory.read(i) << " ";
+    }
+    out << "\n";
+
+    return out.str();
+}
+
+template<class F>
+static double measure(F f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+int main(void) {
+    constexpr int ROUNDS = 20;
+
+    std::mt19937 rng(6502);
+    Memory memory;
+    for(uint32_t addr = 0; addr < 0x10000; ++addr) memory.write(addr, rng());
+
+    std::size_t streamBytes = 0;
+    double stream = measure([&] {
+        for(int round = 0; round < ROUNDS; ++round) {
+            streamBytes += streamDump(memory, 0x0000, 0xfffe).size();
+        }
+    });
+
+    std::size_t dumpBytes = 0;
+    double dump = measure([&] {
+        for(int round = 0; round < ROUNDS; ++round) {
+            dumpBytes += memory.dump(0x0000, 0xffff).size();
+        }
+    });
+
+    std::vector<char> out(dumpSize(0x10000));
+    std::size_t hexBytes = 0;
+    double hex = measure([&] {
+        for(int round = 0; round < ROUNDS; ++round) {
+            hexBytes += memory.hexDump(0x0000, 0xffff, out.data());
+        }
+    });
+
+    //A few scattered changes
+    std::vector<uint8_t> image(memory.data(), memory.data() + 0x10000);
+    for(int i = 0; i < 64; ++i) image[rng() & 0xffff] ^= 0x55;
+    std::size_t ranges = 0;
+    double compare = measure([&] {
+        for(int round = 0; round < ROUNDS * 100; ++round) {
+            ranges += diff(memory.data(), image.data(), 0x10000).size();
+        }
+    });
+
+    std::cout << "ostringstream: " << streamBytes / stream / 1e6 << " MB/s of text\n"
+              << "dump():        " << dumpBytes / dump / 1e6 << " MB/s of text\n"
+              << "hexDump():     " << hexBytes / hex / 1e6 << " MB/s of text (hex and ASCII)\n"
+              << "diff():        " << ROUNDS * 100 * 0x10000 / compare / 1e9 << " GB/s ("
+              << ranges / (ROUNDS * 100) << " ranges)\n";
+
+    return 0;
+}
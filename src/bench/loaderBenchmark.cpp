@@ -0,0 +1,156 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <cstdio>
+#include "../memory/Memory.h"
+#include "../memory/Loader.h"
+
+/*
+    Throughput of the streaming loaders on an 8 MiB image written as
+    whitespace hex, Intel HEX and S-records, compared to the previous
+    hex loader (operator>> into std::string, one byte at a time).
+*/
+
+static uint8_t legacyMemory[0x10000];
+
+//The previous strToByte(): by value, uppercase only
+static uint8_t strToByte(std::string str) {
+    uint8_t byte = 0x00;
+
+    for(int i = 0; i < 2; ++i) {
+        if(str[i] >= '0' && str[i] <= '9') {
+            byte += (str[i] - '0')*((1-i)*15+1);
+        }
+        else if(str[i] >= 'A' && str[i] <= 'F') {
+            byte += (str[i] - 'A' + 10)*((1-i)*15+1);
+        }
+        else {
+            std::cout << "ERROR: couldn't load program\n";
+            exit(1);
+        }
+    }
+
+    return byte;
+}
+
+static void legacyLoadFromFileHex(uint16_t addr, std::string fileName) {
+    std::ifstream file(fileName);
+    std::string charByte;
+
+    while(file >> charByte) {
+        legacyMemory[addr++] = strToByte(charByte);
+    }
+}
+
+static char const HEX[] = "0123456789ABCDEF";
+
+static void hexByte(std::string& out, uint8_t byte) {
+    out += HEX[byte >> 4];
+    out += HEX[byte & 0x0f];
+}
+
+static std::string toHex(std::vector<uint8_t> const & image) {
+    std::string out;
+    for(std::size_t i = 0; i < image.size(); ++i) {
+        hexByte(out, image[i]);
+        out += (i % 16 == 15) ? '\n' : ' ';
+    }
+    return out;
+}
+
+static std::string toIntelHex(std::vector<uint8_t> const & image) {
+    std::string out;
+    for(std::size_t i = 0; i < image.size(); i += 32) {
+        if(i % 0x10000 == 0) {
+            uint8_t record[] = {0x02, 0x00, 0x00, 0x04, uint8_t(i >> 24), uint8_t(i >> 16)};
+            uint8_t sum = 0;
+            out += ':';
+            for(uint8_t byte : record) { hexByte(out, byte); sum += byte; }
+            hexByte(out, -sum);
+            out += '\n';
+        }
+        uint8_t sum = 32 + uint8_t(i >> 8) + uint8_t(i);
+        out += ':';
+        hexByte(out, 32); hexByte(out, i >> 8); hexByte(out, i); hexByte(out, 0x00);
+        for(std::size_t j = i; j < i + 32; ++j) { hexByte(out, image[j]); sum += image[j]; }
+        hexByte(out, -sum);
+        out += '\n';
+    }
+    return out + ":00000001FF\n";
+}
+
+static std::string toSRecord(std::vector<uint8_t> const & image) {
+    std::string out;
+    for(std::size_t i = 0; i < image.size(); i += 32) {
+        uint8_t sum = 32 + 5;
+        out += "S3";
+        hexByte(out, 32 + 5);
+        for(int shift = 24; shift >= 0; shift -= 8) { hexByte(out, i >> shift); sum += uint8_t(i >> shift); }
+        for(std::size_t j = i; j < i + 32; ++j) { hexByte(out, image[j]); sum += image[j]; }
+        hexByte(out, ~sum);
+        out += '\n';
+    }
+    return out + "S70500000000FA\n";
+}
+
+template<class F>
+static double measure(F f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+static bool save(std::string const & fileName, std::string const & text) {
+    return static_cast<bool>(std::ofstream(fileName, std::ios::binary) << text);
+}
+
+int main(void) {
+    std::mt19937 rng(6502);
+    std::vector<uint8_t> image(8 << 20);
+    for(auto & byte : image) byte = rng();
+
+    std::string const hexFile = "/tmp/mos6502_loader_benchmark.txt";
+    std::string const intelFile = "/tmp/mos6502_loader_benchmark.hex";
+    std::string const sFile = "/tmp/mos6502_loader_benchmark.s37";
+    std::string hex = toHex(image);
+    if(!save(hexFile, hex) || !save(intelFile, toIntelHex(image)) || !save(sFile, toSRecord(image))) {
+        std::cout << "ERROR: couldn't write the benchmark files\n";
+        return 1;
+    }
+
+    Memory memory;
+    MemoryTarget target(memory);
+    LoadResult results[4];
+
+    double legacy = measure([&] { legacyLoadFromFileHex(0x0000, hexFile); });
+    double file = measure([&] { results[0] = loadFile(LoadFormat::hex, hexFile, target); });
+    double buffer = measure([&] {
+        results[1] = load(LoadFormat::hex, reinterpret_cast<uint8_t const *>(hex.data()), hex.size(), target);
+    });
+    double intel = measure([&] { results[2] = loadFile(LoadFormat::intelHex, intelFile, target); });
+    double srecord = measure([&] { results[3] = loadFile(LoadFormat::sRecord, sFile, target); });
+
+    for(LoadResult const & result : results) {
+        if(!result || result.bytes != image.size()) {
+            std::cout << "ERROR: " << loadErrorName(result.error) << " at line " << result.line << "\n";
+            return 1;
+        }
+    }
+
+    double mb = image.size() / 1e6;
+    std::cout << "Image: " << mb << " MB\n"
+              << "legacy hex loader:  " << mb / legacy << " MB/s\n"
+              << "hex (file):         " << mb / file << " MB/s\n"
+              << "hex (buffer):       " << mb / buffer << " MB/s\n"
+              << "Intel HEX (file):   " << mb / intel << " MB/s\n"
+              << "S-record (file):    " << mb / srecord << " MB/s\n";
+
+    std::remove(hexFile.c_str());
+    std::remove(intelFile.c_str());
+    std::remove(sFile.c_str());
+    return 0;
+}
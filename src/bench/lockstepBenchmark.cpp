@@ -0,0 +1,53 @@
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include "../analysis/Lockstep.h"
+#include "../cpu/CycleEngine.h"
+
+/*
+    Lockstep of the interpreter with itself and with the cycle-exact
+    engine on a random instruction stream, comparing after every
+    instruction and every 10000 cycles.
+*/
+
+template<class F>
+static double measure(F f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+static double run(Lockstep<NMOS6502>& lockstep, uint64_t cycles, uint64_t block) {
+    std::vector<uint8_t> program(0x10000);
+    randomInstructions<NMOS6502>(program.data(), program.size(), 6502);
+    lockstep.load(0x0000, program.data(), program.size());
+    lockstep.start(CPUState{0x0400, 0, 0, 0, 0x20, 0xff, 0});
+
+    double seconds = measure([&] {
+        if(!lockstep.run(cycles, block)) std::cout << "ERROR: divergence\n";
+    });
+    return cycles / seconds / 1e6;
+}
+
+int main(void) {
+    constexpr uint64_t CYCLES = 200000000;
+
+    Lockstep<NMOS6502> self;
+    self.setEngine([&self](uint64_t end) {
+        while(self.candidate().getCycles() < end) self.candidate().step();
+    });
+
+    Lockstep<NMOS6502> cycleExact;
+    CycleEngine<NMOS6502> engine(cycleExact.candidate());
+    cycleExact.setEngine([&cycleExact, &engine](uint64_t end) {
+        while(cycleExact.candidate().getCycles() < end) engine.step();
+    });
+
+    std::cout << "Interpreter, every instruction:    " << run(self, CYCLES, 1) << " MHz\n"
+              << "Interpreter, every 10000 cycles:   " << run(self, CYCLES, 10000) << " MHz\n"
+              << "Cycle-exact, every instruction:    " << run(cycleExact, CYCLES, 1) << " MHz\n"
+              << "Cycle-exact, every 10000 cycles:   " << run(cycleExact, CYCLES, 10000) << " MHz\n";
+
+    return 0;
+}
@@ -0,0 +1,65 @@
+#include <iostream>
+#include <chrono>
+#include "../cpu/MOS6502.h"
+#include "../memory/Memory.h"
+#include "../machine/Rewind.h"
+
+/*
+    Cost of recording for reverse execution: the functional test run
+    with execute() (the fast path, the reference), step() and
+    Rewind::run() (a snapshot every 100000 cycles, ring of 64).
+*/
+
+#define SUCCESS 0x36b9
+
+template<class F>
+static double measure(F f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+int main(void) {
+    constexpr int ROUNDS = 5;
+    double fast = 0, plain = 0, recorded = 0;
+    uint64_t cycles = 0;
+
+    for(int round = 0; round < ROUNDS; ++round) {
+        Memory memory;
+        if(!memory.loadFromFileBin(0x0400, "../test/6502_functional_test.bin")) {
+            std::cout << "ERROR: couldn't open ../test/6502_functional_test.bin\n";
+            return 1;
+        }
+        MOS6502 cpu(memory.pages());
+        cpu.setBreakpoint(SUCCESS);
+        fast += measure([&] { cpu.execute(0x0400, 0xffff); });
+        cycles = cpu.getCycles();
+
+        Memory stepMemory;
+        stepMemory.loadFromFileBin(0x0400, "../test/6502_functional_test.bin");
+        MOS6502 stepCpu(stepMemory.pages());
+        stepCpu.setPC(0x0400);
+        plain += measure([&] {
+            while(stepCpu.getPC() != SUCCESS) stepCpu.step();
+        });
+
+        Memory rewindMemory;
+        rewindMemory.loadFromFileBin(0x0400, "../test/6502_functional_test.bin");
+        Rewind<NMOS6502> rewind(rewindMemory, [](uint16_t, uint8_t) {}, [](uint16_t) { return uint8_t{0xff}; },
+                                100000, 64);
+        rewind.cpu().setPC(0x0400);
+        rewind.setBreakpoint(SUCCESS);
+        recorded += measure([&] { rewind.run(cycles); });
+        if(rewind.cpu().getPC() != SUCCESS || stepCpu.getCycles() != cycles) {
+            std::cout << "ERROR: the runs did not reach the success address together\n";
+            return 1;
+        }
+    }
+
+    std::cout << "execute():     " << ROUNDS * cycles / fast / 1e6 << " MHz\n"
+              << "step():        " << ROUNDS * cycles / plain / 1e6 << " MHz\n"
+              << "Rewind::run(): " << ROUNDS * cycles / recorded / 1e6 << " MHz ("
+              << (recorded / fast - 1) * 100 << "% overhead over execute())\n";
+    return 0;
+}
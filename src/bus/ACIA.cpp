@@ -0,0 +1,148 @@
+#include "ACIA.h"
+#include <algorithm>
+#include <cstring>
+
+ACIA::ACIA(Scheduler& scheduler, int inputFd, int outputFd, unsigned irqSource):
+    scheduler{scheduler}, fdLink{std::make_unique<FdLink>(inputFd, outputFd)},
+    link{*fdLink}, irqSource{irqSource}
+{}
+
+ACIA::ACIA(Scheduler& scheduler, HostLink& link, unsigned irqSource):
+    scheduler{scheduler}, link{link}, irqSource{irqSource}
+{}
+
+ACIA::~ACIA() {
+    flush();
+    scheduler.cancel(this);
+    scheduler.cancel(&input);
+    scheduler.setIRQLine(irqSource, false);
+}
+
+uint8_t ACIA::read(uint16_t offset) {
+    uint8_t data{0};
+
+    switch(offset & 0x03) {
+        case DATA:
+            receive(false);
+            if(inputSize > 0) {
+                data = input[inputHead];
+                inputHead = (inputHead + 1) % BUFFER_SIZE;
+                --inputSize;
+            }
+            update();
+            break;
+        case STATUS:
+            receive(false);
+            data = TDRE;
+            if(inputSize > 0) data |= RDRF;
+            if(inputSize > 0 && receiverIRQ()) data |= IRQ_FLAG;
+            break;
+        case COMMAND:
+            data = command;
+            break;
+        case CONTROL:
+            data = control;
+            break;
+    }
+
+    return data;
+}
+
+void ACIA::write(uint16_t offset, uint8_t data) {
+    switch(offset & 0x03) {
+        case DATA:
+            transmit(data);
+            break;
+        case STATUS:
+            //Programmed reset
+            command &= 0xe0;
+            update();
+            break;
+        case COMMAND:
+            command = data;
+            update();
+            break;
+        case CONTROL:
+            control = data;
+            break;
+    }
+}
+
+/**** Output ****/
+void ACIA::transmit(uint8_t data) {
+    if(outputSize == 0 && flushDelay > 0) {
+        scheduler.schedule(this, scheduler.getCycles() + flushDelay, [this] { flush(); });
+    }
+    if(outputSize < BUFFER_SIZE) {
+        output[outputSize++] = data;
+    }
+
+    if(outputSize >= flushThreshold || (flushOnNewline && data == '\n')) {
+        flush();
+    }
+}
+
+void ACIA::flush() {
+    std::size_t sent = link.send(output.data(), outputSize);
+
+    //Keep what the host could not take for the next flush
+    outputSize -= sent;
+    std::memmove(output.data(), output.data() + sent, outputSize);
+    if(outputSize == 0) {
+        scheduler.cancel(this);
+    } else if(flushDelay > 0) {
+        scheduler.schedule(this, scheduler.getCycles() + flushDelay, [this] { flush(); });
+    }
+}
+
+void ACIA::setFlushThreshold(std::size_t bytes) {
+    flushThreshold = std::min(std::max<std::size_t>(bytes, 1), BUFFER_SIZE);
+}
+
+void ACIA::setFlushOnNewline(bool enabled) {
+    flushOnNewline = enabled;
+}
+
+void ACIA::setFlushDelay(uint64_t cycles) {
+    flushDelay = cycles;
+}
+/****************/
+
+/**** Input ****/
+void ACIA::receive(bool force) {
+    if(inputSize > 0) return;
+
+    uint64_t now = scheduler.getCycles();
+    if(!force && !link.cheapReceive() && polled && now - lastPoll < pollInterval) return;
+    lastPoll = now;
+    polled = true;
+
+    //Empty ring buffer: restart from the beginning
+    inputHead = 0;
+    inputSize = link.receive(input.data(), BUFFER_SIZE);
+}
+
+void ACIA::setPollInterval(uint64_t cycles) {
+    pollInterval = cycles;
+}
+
+bool ACIA::receiverIRQ() const {
+    //DTR set (receiver enabled) and IRD clear
+    return (command & 0x03) == 0x01;
+}
+
+void ACIA::update() {
+    scheduler.setIRQLine(irqSource, inputSize > 0 && receiverIRQ());
+
+    //Look for input every pollInterval cycles while the interrupt is
+    //enabled and no byte is waiting
+    if(receiverIRQ() && inputSize == 0) {
+        scheduler.schedule(&input, scheduler.getCycles() + std::max<uint64_t>(pollInterval, 1), [this] {
+            receive(true);
+            update();
+        });
+    } else {
+        scheduler.cancel(&input);
+    }
+}
+/***************/
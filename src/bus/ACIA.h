@@ -0,0 +1,105 @@
+#ifndef ACIA_H
+#define ACIA_H
+
+#include <array>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+#include "Device.h"
+#include "HostLink.h"
+#include "../cpu/Scheduler.h"
+
+/*
+    6551 ACIA connected to host file descriptors (stdin/stdout by
+    default, or pipes, sockets, ptys...) or to any HostLink, e.g. the
+    lock-free queues of a host I/O thread (QueueLink, see HostLink.h).
+
+    The host I/O is buffered so that the emulated serial port does not
+    cost a system call per byte:
+     - transmitted bytes are collected in a buffer, written to the host
+       on a newline, when the buffer reaches the flush threshold, or
+       flushDelay cycles after the first byte was buffered (an event of
+       the CPU scheduler)
+     - received bytes are read from the host (non-blocking) into a ring
+       buffer; when it is empty the host is read at most once every
+       pollInterval cycles, so the status polling loops of a ROM waiting
+       for input do not turn into a system call per read (links
+       without system calls are read at every poll)
+     - if the host does not keep up, the output is kept in the buffer
+       (and the bytes that do not fit are dropped): the CPU never waits
+
+        ACIA acia(cpu.scheduler());
+        bus.map(0x8800, 0x8803, acia);
+
+    Baud rate, parity and handshake lines are not emulated: TDRE is
+    always set and bytes are transferred at once. With the receiver
+    interrupt enabled (DTR set, IRD clear in the command register) the
+    IRQ line is asserted while a byte is available.
+*/
+class ACIA : public Device {
+public:
+    //A negative fd disables the direction
+    explicit ACIA(Scheduler& scheduler, int inputFd = 0, int outputFd = 1,
+                  unsigned irqSource = 1);
+    ACIA(Scheduler& scheduler, HostLink& link, unsigned irqSource = 1);
+    ~ACIA() override;
+
+    uint8_t read(uint16_t offset) override;
+    void write(uint16_t offset, uint8_t data) override;
+
+    //Write the buffered output to the host
+    void flush();
+
+    void setFlushThreshold(std::size_t bytes);
+    void setFlushOnNewline(bool enabled);
+    void setFlushDelay(uint64_t cycles);
+    void setPollInterval(uint64_t cycles);
+
+    //Registers (offsets, mirrored every 4 bytes)
+    static constexpr uint8_t DATA{0x0};
+    static constexpr uint8_t STATUS{0x1};
+    static constexpr uint8_t COMMAND{0x2};
+    static constexpr uint8_t CONTROL{0x3};
+
+    //Status bits
+    static constexpr uint8_t RDRF{1U<<3};   //Receiver data register full
+    static constexpr uint8_t TDRE{1U<<4};   //Transmitter data register empty
+    static constexpr uint8_t IRQ_FLAG{1U<<7};
+
+    static constexpr std::size_t BUFFER_SIZE{4096};
+
+private:
+    Scheduler& scheduler;
+    std::unique_ptr<FdLink> fdLink;     //Owned link of the fd constructor
+    HostLink& link;
+    unsigned irqSource;
+
+    /**** Registers ****/
+    uint8_t command{0};
+    uint8_t control{0};
+
+    /**** Output ****/
+    std::array<uint8_t, BUFFER_SIZE> output;
+    std::size_t outputSize{0};
+    std::size_t flushThreshold{BUFFER_SIZE};
+    bool flushOnNewline{true};
+    uint64_t flushDelay{20000};
+
+    /**** Input (ring buffer) ****/
+    std::array<uint8_t, BUFFER_SIZE> input;
+    std::size_t inputHead{0};           //Next byte to read
+    std::size_t inputSize{0};
+    uint64_t pollInterval{10000};
+    uint64_t lastPoll{0};
+    bool polled{false};                 //lastPoll is valid
+
+    void transmit(uint8_t data);
+    //Read from the host if the ring buffer is empty (at most once per
+    //pollInterval cycles unless forced)
+    void receive(bool force);
+    bool receiverIRQ() const;
+    //Update the IRQ line and the receive polling event
+    void update();
+};
+
+#endif
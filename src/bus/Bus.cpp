@@ -0,0 +1,70 @@
+#include "Bus.h"
+
+namespace {
+
+//Device of the unmapped addresses
+class OpenBus : public Device {
+public:
+    uint8_t read(uint16_t) override { return 0xff; }
+    void write(uint16_t, uint8_t) override {}
+};
+
+OpenBus openBus;
+
+}
+
+Bus::Bus() {
+    unmap(0x0000, 0xffff);
+}
+
+void Bus::map(uint16_t start, uint16_t end, Device& device, uint16_t offset) {
+    Slot slot{&device, static_cast<uint16_t>(start - offset)};
+
+    for(unsigned page = start >> 8; page <= static_cast<unsigned>(end >> 8); ++page) {
+        unsigned first = (page == static_cast<unsigned>(start >> 8)) ? (start & 0xff) : 0x00;
+        unsigned last  = (page == static_cast<unsigned>(end >> 8))   ? (end & 0xff)   : 0xff;
+
+        if(first == 0x00 && last == 0xff) {
+            mapPage(page, slot);
+        } else {
+            mapSubPage(page, first, last, slot);
+        }
+    }
+}
+
+void Bus::unmap(uint16_t start, uint16_t end) {
+    map(start, end, openBus);
+}
+
+void Bus::mapPage(uint8_t page, Slot slot) {
+    Page & p = pages[page];
+    p.slot = slot;
+    p.sub = nullptr;
+    subPages[page].reset();
+
+    //Direct pointers are only possible if the page is aligned in the device
+    uint16_t offset = static_cast<uint16_t>((page << 8) - slot.base);
+    if((offset & 0xff) == 0) {
+        p.readData  = slot.device->readPage(offset);
+        p.writeData = slot.device->writePage(offset);
+    } else {
+        p.readData  = nullptr;
+        p.writeData = nullptr;
+    }
+}
+
+void Bus::mapSubPage(uint8_t page, uint8_t first, uint8_t last, Slot slot) {
+    Page & p = pages[page];
+
+    if(!subPages[page]) {
+        subPages[page] = std::make_unique<SubPage>();
+        subPages[page]->fill(p.slot);
+    }
+    for(unsigned i = first; i <= last; ++i) {
+        (*subPages[page])[i] = slot;
+    }
+
+    p.sub = subPages[page].get();
+    p.readData  = nullptr;
+    p.writeData = nullptr;
+}
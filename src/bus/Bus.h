@@ -0,0 +1,95 @@
+#ifndef BUS_H
+#define BUS_H
+
+#include <array>
+#include <memory>
+#include <cstdint>
+#include "Device.h"
+
+/*
+    Address decoder.
+
+    Devices register address ranges with map(); the ranges are compiled
+    into a table of 256 pages of 256 bytes, so an access is resolved by
+    indexing the table with the high byte of the address:
+     - pages served by plain memory (see Device::readPage()) hold a
+       direct pointer: the access is an array access
+     - pages owned by a single device hold the device and its base
+     - pages shared by several devices (e.g. I/O registers in the
+       middle of RAM) point to a sub-page table of 256 entries, indexed
+       with the low byte of the address
+
+    Later mappings override earlier ones, so the usual setup maps the
+    memory first and the I/O devices on top of it:
+
+        Bus bus;
+        bus.map(0x0000, 0xffff, ram);
+        bus.map(0xc000, 0xffff, rom);
+        bus.map(0x6000, 0x600f, via);
+
+        MOS6502 cpu = MOS6502(
+            [&bus](uint16_t addr, uint8_t data) { bus.write(addr, data); },
+            [&bus](uint16_t addr) { return bus.read(addr); });
+
+    Unmapped addresses read 0xff and ignore writes.
+*/
+class Bus {
+public:
+    Bus();
+
+    /*
+        Map [start, end] (endpoints included) to device: the access to
+        start is forwarded to the device with the given offset.
+    */
+    void map(uint16_t start, uint16_t end, Device& device, uint16_t offset = 0);
+    void unmap(uint16_t start, uint16_t end);
+
+    uint8_t read(uint16_t addr);
+    void write(uint16_t addr, uint8_t data);
+
+private:
+    struct Slot {
+        Device* device;
+        uint16_t base;          //Address of the device offset 0
+    };
+    using SubPage = std::array<Slot, 0x100>;
+
+    struct Page {
+        uint8_t* readData;      //Direct pointers (nullptr: use the device)
+        uint8_t* writeData;
+        Slot slot;              //Device of the whole page (sub == nullptr)
+        SubPage const* sub;     //Per-byte devices of a shared page
+    };
+
+    std::array<Page, 0x100> pages;
+    std::array<std::unique_ptr<SubPage>, 0x100> subPages;
+
+    void mapPage(uint8_t page, Slot slot);
+    void mapSubPage(uint8_t page, uint8_t first, uint8_t last, Slot slot);
+
+    Slot const & slot(uint16_t addr) const;
+};
+
+inline Bus::Slot const & Bus::slot(uint16_t addr) const {
+    Page const & page = pages[addr >> 8];
+    return page.sub ? (*page.sub)[addr & 0xff] : page.slot;
+}
+
+inline uint8_t Bus::read(uint16_t addr) {
+    Page const & page = pages[addr >> 8];
+    if(page.readData) return page.readData[addr & 0xff];
+    Slot const & s = slot(addr);
+    return s.device->read(static_cast<uint16_t>(addr - s.base));
+}
+
+inline void Bus::write(uint16_t addr, uint8_t data) {
+    Page const & page = pages[addr >> 8];
+    if(page.writeData) {
+        page.writeData[addr & 0xff] = data;
+        return;
+    }
+    Slot const & s = slot(addr);
+    s.device->write(static_cast<uint16_t>(addr - s.base), data);
+}
+
+#endif
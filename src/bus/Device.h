@@ -0,0 +1,30 @@
+#ifndef DEVICE_H
+#define DEVICE_H
+
+#include <cstdint>
+
+/*
+    Memory-mapped device.
+
+    Devices are addressed by offset: the Bus passes addr-base, where base
+    is the address the device was mapped at (see Bus::map()), so a device
+    does not depend on where it is mapped.
+*/
+class Device {
+public:
+    virtual ~Device() = default;
+
+    virtual uint8_t read(uint16_t offset) = 0;
+    virtual void write(uint16_t offset, uint8_t data) = 0;
+
+    /*
+        Direct access to the 256 bytes starting at offset (offset is a
+        multiple of 0x100), or nullptr if the accesses must go through
+        read()/write(). Plain memory returns a pointer so that the Bus
+        can serve the page without a virtual call.
+    */
+    virtual uint8_t* readPage(uint16_t) { return nullptr; }
+    virtual uint8_t* writePage(uint16_t) { return nullptr; }
+};
+
+#endif
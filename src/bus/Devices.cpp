@@ -0,0 +1,80 @@
+#include "Devices.h"
+#include <utility>
+
+/**** RAM ****/
+RAM::RAM(std::size_t size): memory(size, 0x00) {}
+
+uint8_t RAM::read(uint16_t offset) {
+    return offset < memory.size() ? memory[offset] : 0xff;
+}
+
+void RAM::write(uint16_t offset, uint8_t data) {
+    if(offset < memory.size()) memory[offset] = data;
+}
+
+uint8_t* RAM::readPage(uint16_t offset) {
+    return offset + 0x100u <= memory.size() ? &memory[offset] : nullptr;
+}
+
+uint8_t* RAM::writePage(uint16_t offset) {
+    return readPage(offset);
+}
+
+uint8_t* RAM::data() {
+    return memory.data();
+}
+
+std::size_t RAM::size() const {
+    return memory.size();
+}
+/*************/
+
+/**** ROM ****/
+ROM::ROM(std::vector<uint8_t> image): memory(std::move(image)) {}
+
+uint8_t ROM::read(uint16_t offset) {
+    return offset < memory.size() ? memory[offset] : 0xff;
+}
+
+void ROM::write(uint16_t, uint8_t) {}
+
+uint8_t* ROM::readPage(uint16_t offset) {
+    return offset + 0x100u <= memory.size() ? &memory[offset] : nullptr;
+}
+
+uint8_t* ROM::writePage(uint16_t offset) {
+    //Writes are dropped without calling write()
+    return readPage(offset) ? discard : nullptr;
+}
+
+std::size_t ROM::size() const {
+    return memory.size();
+}
+/*************/
+
+/**** Mirror ****/
+Mirror::Mirror(Device& target, uint16_t size, uint16_t offset):
+    target{target}, size{size}, offset{offset} {}
+
+uint16_t Mirror::targetOffset(uint16_t offset) const {
+    return static_cast<uint16_t>(this->offset + offset % size);
+}
+
+uint8_t Mirror::read(uint16_t offset) {
+    return target.read(targetOffset(offset));
+}
+
+void Mirror::write(uint16_t offset, uint8_t data) {
+    target.write(targetOffset(offset), data);
+}
+
+uint8_t* Mirror::readPage(uint16_t offset) {
+    uint16_t t = targetOffset(offset);
+    return (size & 0xff) == 0 && (t & 0xff) == 0 ? target.readPage(t) : nullptr;
+}
+
+uint8_t* Mirror::writePage(uint16_t offset) {
+    uint16_t t = targetOffset(offset);
+    return (size & 0xff) == 0 && (t & 0xff) == 0 ? target.writePage(t) : nullptr;
+}
+/****************/
@@ -0,0 +1,75 @@
+#ifndef DEVICES_H
+#define DEVICES_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "Device.h"
+
+/*
+    Standard devices. RAM and ROM expose their pages to the Bus (direct
+    pointers), so mapping them costs nothing over a plain array.
+*/
+
+//Read/write memory of the given size (zero-filled)
+class RAM : public Device {
+public:
+    explicit RAM(std::size_t size);
+
+    uint8_t read(uint16_t offset) override;
+    void write(uint16_t offset, uint8_t data) override;
+    uint8_t* readPage(uint16_t offset) override;
+    uint8_t* writePage(uint16_t offset) override;
+
+    uint8_t* data();
+    std::size_t size() const;
+
+private:
+    std::vector<uint8_t> memory;
+};
+
+//Read-only memory: writes are ignored
+class ROM : public Device {
+public:
+    explicit ROM(std::vector<uint8_t> image);
+
+    uint8_t read(uint16_t offset) override;
+    void write(uint16_t offset, uint8_t data) override;
+    uint8_t* readPage(uint16_t offset) override;
+    uint8_t* writePage(uint16_t offset) override;
+
+    std::size_t size() const;
+
+private:
+    std::vector<uint8_t> memory;
+    uint8_t discard[0x100];     //Target of the direct writes
+};
+
+/*
+    Incomplete address decoding: the offsets of the mapped range wrap
+    every size bytes, e.g. 2KiB of RAM seen four times in $0000-$1FFF:
+
+        Mirror mirror(ram, 0x0800);
+        bus.map(0x0000, 0x1fff, mirror);
+
+    If size is a multiple of 0x100 the pages of the target are exposed
+    to the Bus, so a mirrored RAM is as fast as the RAM itself.
+*/
+class Mirror : public Device {
+public:
+    Mirror(Device& target, uint16_t size, uint16_t offset = 0);
+
+    uint8_t read(uint16_t offset) override;
+    void write(uint16_t offset, uint8_t data) override;
+    uint8_t* readPage(uint16_t offset) override;
+    uint8_t* writePage(uint16_t offset) override;
+
+private:
+    Device& target;
+    uint16_t size;
+    uint16_t offset;            //Offset of the mirrored range in target
+
+    uint16_t targetOffset(uint16_t offset) const;
+};
+
+#endif
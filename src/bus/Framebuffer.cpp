@@ -0,0 +1,241 @@
+#include "Framebuffer.h"
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+
+namespace {
+
+//Pixels packed whole into bytes, 8 bits for any other depth
+unsigned validDepth(unsigned bitsPerPixel) {
+    switch(bitsPerPixel) {
+        case 1: case 2: case 4: case 8: return bitsPerPixel;
+        default: return 8;
+    }
+}
+
+}
+
+Framebuffer::Framebuffer(unsigned width, unsigned height, unsigned bitsPerPixel):
+    width{width}, height{height}, bitsPerPixel{validDepth(bitsPerPixel)},
+    bytesPerLine{(static_cast<std::size_t>(width) * this->bitsPerPixel + 7) / 8},
+    memory(bytesPerLine * height, 0x00),
+    dirty((height + 63) / 64, 0),
+    image(static_cast<std::size_t>(width) * height * 4, 0x00)
+{
+    //Default palette: gray levels spread over the available indexes
+    unsigned colors = 1U << this->bitsPerPixel;
+    for(unsigned i = 0; i < 0x100; ++i) {
+        uint8_t level = (i < colors) ? static_cast<uint8_t>(i * 0xff / (colors - 1)) : 0xff;
+        palette[i] = {level, level, level, 0xff};
+    }
+
+    //First frame: everything
+    for(unsigned line = 0; line < height; ++line) {
+        dirty[line / 64] |= (1ULL << (line % 64));
+    }
+}
+
+uint8_t Framebuffer::read(uint16_t offset) {
+    return offset < memory.size() ? memory[offset] : 0xff;
+}
+
+void Framebuffer::write(uint16_t offset, uint8_t data) {
+    if(offset >= memory.size() || memory[offset] == data) return;
+    memory[offset] = data;
+    std::size_t line = offset / bytesPerLine;
+    dirty[line / 64] |= (1ULL << (line % 64));
+}
+
+uint8_t* Framebuffer::readPage(uint16_t offset) {
+    return offset + 0x100u <= memory.size() ? &memory[offset] : nullptr;
+}
+
+void Framebuffer::setPalette(uint8_t index, uint8_t r, uint8_t g, uint8_t b, uint8_t a) {
+    palette[index] = {r, g, b, a};
+    //Every pixel may use the entry
+    for(unsigned line = 0; line < height; ++line) {
+        dirty[line / 64] |= (1ULL << (line % 64));
+    }
+}
+
+/**** Rendering ****/
+unsigned Framebuffer::render() {
+    unsigned rendered = 0;
+
+    for(std::size_t w = 0; w < dirty.size(); ++w) {
+        //Only visit the set bits
+        while(dirty[w] != 0) {
+            unsigned bit = __builtin_ctzll(dirty[w]);
+            dirty[w] &= dirty[w] - 1;
+            renderLine(w * 64 + bit);
+            ++rendered;
+        }
+    }
+
+    return rendered;
+}
+
+void Framebuffer::renderLine(unsigned line) {
+    uint8_t const * src = &memory[line * bytesPerLine];
+    uint8_t* dst = &image[static_cast<std::size_t>(line) * width * 4];
+
+    if(bitsPerPixel == 8) {
+        for(unsigned x = 0; x < width; ++x) {
+            std::memcpy(dst + x*4, palette[src[x]].data(), 4);
+        }
+        return;
+    }
+
+    unsigned pixelsPerByte = 8 / bitsPerPixel;
+    uint8_t mask = static_cast<uint8_t>((1U << bitsPerPixel) - 1);
+    for(unsigned x = 0; x < width; ++x) {
+        unsigned shift = 8 - bitsPerPixel * (x % pixelsPerByte + 1);
+        uint8_t index = (src[x / pixelsPerByte] >> shift) & mask;
+        std::memcpy(dst + x*4, palette[index].data(), 4);
+    }
+}
+
+uint8_t const * Framebuffer::pixels() const {
+    return image.data();
+}
+
+unsigned Framebuffer::getWidth() const {
+    return width;
+}
+
+unsigned Framebuffer::getHeight() const {
+    return height;
+}
+
+std::size_t Framebuffer::size() const {
+    return memory.size();
+}
+/*******************/
+
+/**** Image files ****/
+namespace {
+
+void put32(std::vector<uint8_t>& out, uint32_t value) {
+    out.push_back(value >> 24);
+    out.push_back(value >> 16);
+    out.push_back(value >> 8);
+    out.push_back(value);
+}
+
+uint32_t crc32(uint8_t const * data, std::size_t size, uint32_t crc = 0) {
+    static const std::array<uint32_t, 0x100> TABLE = [] {
+        std::array<uint32_t, 0x100> table{};
+        for(uint32_t i = 0; i < 0x100; ++i) {
+            uint32_t c = i;
+            for(int k = 0; k < 8; ++k) {
+                c = (c & 1) ? 0xedb88320U ^ (c >> 1) : c >> 1;
+            }
+            table[i] = c;
+        }
+        return table;
+    }();
+
+    crc = ~crc;
+    for(std::size_t i = 0; i < size; ++i) {
+        crc = TABLE[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+void chunk(std::vector<uint8_t>& out, char const * type, std::vector<uint8_t> const & data) {
+    put32(out, data.size());
+    std::size_t start = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data.begin(), data.end());
+    put32(out, crc32(&out[start], out.size() - start));
+}
+
+}
+
+bool Framebuffer::savePPM(std::string const & fileName) const {
+    std::ofstream file(fileName, std::ios::binary);
+    if(!file) return false;
+
+    file << "P6\n" << width << " " << height << "\n255\n";
+    std::vector<uint8_t> rgb(static_cast<std::size_t>(width) * height * 3);
+    for(std::size_t i = 0, n = static_cast<std::size_t>(width) * height; i < n; ++i) {
+        std::memcpy(&rgb[i*3], &image[i*4], 3);
+    }
+    file.write(reinterpret_cast<char const *>(rgb.data()), rgb.size());
+
+    return static_cast<bool>(file);
+}
+
+/*
+    The image data is stored in uncompressed deflate blocks: no zlib
+    dependency, and writing a frame is a copy.
+*/
+bool Framebuffer::savePNG(std::string const & fileName) const {
+    std::ofstream file(fileName, std::ios::binary);
+    if(!file) return false;
+
+    std::vector<uint8_t> png{0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+
+    std::vector<uint8_t> header;
+    put32(header, width);
+    put32(header, height);
+    header.insert(header.end(), {8, 6, 0, 0, 0});   //8 bits RGBA, no interlace
+    chunk(png, "IHDR", header);
+
+    //Scanlines with filter type 0
+    std::size_t stride = static_cast<std::size_t>(width) * 4;
+    std::vector<uint8_t> raw;
+    raw.reserve((stride + 1) * height);
+    for(unsigned line = 0; line < height; ++line) {
+        raw.push_back(0);
+        raw.insert(raw.end(), &image[line * stride], &image[line * stride] + stride);
+    }
+
+    std::vector<uint8_t> zlib{0x78, 0x01};
+    uint32_t a = 1, b = 0;
+    for(uint8_t byte : raw) {
+        a = (a + byte) % 65521;
+        b = (b + a) % 65521;
+    }
+    for(std::size_t pos = 0; pos < raw.size() || pos == 0; ) {
+        std::size_t len = std::min<std::size_t>(raw.size() - pos, 0xffff);
+        bool last = (pos + len == raw.size());
+        zlib.push_back(last ? 1 : 0);
+        zlib.push_back(len & 0xff);
+        zlib.push_back(len >> 8);
+        zlib.push_back(~len & 0xff);
+        zlib.push_back((~len >> 8) & 0xff);
+        zlib.insert(zlib.end(), raw.begin() + pos, raw.begin() + pos + len);
+        pos += len;
+        if(last) break;
+    }
+    put32(zlib, (b << 16) | a);
+    chunk(png, "IDAT", zlib);
+    chunk(png, "IEND", {});
+
+    file.write(reinterpret_cast<char const *>(png.data()), png.size());
+    return static_cast<bool>(file);
+}
+
+long Framebuffer::compare(std::string const & goldenFileName) const {
+    std::ifstream file(goldenFileName, std::ios::binary);
+    std::string magic;
+    unsigned w, h, maxValue;
+    if(!(file >> magic >> w >> h >> maxValue) || magic != "P6" ||
+       w != width || h != height || maxValue != 255) {
+        return -1;
+    }
+    file.get();     //Single whitespace before the data
+
+    std::vector<uint8_t> rgb(static_cast<std::size_t>(width) * height * 3);
+    if(!file.read(reinterpret_cast<char*>(rgb.data()), rgb.size())) {
+        return -1;
+    }
+
+    long different = 0;
+    for(std::size_t i = 0, n = static_cast<std::size_t>(width) * height; i < n; ++i) {
+        different += (std::memcmp(&rgb[i*3], &image[i*4], 3) != 0);
+    }
+    return different;
+}
+/*********************/
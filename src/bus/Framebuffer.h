@@ -0,0 +1,76 @@
+#ifndef FRAMEBUFFER_H
+#define FRAMEBUFFER_H
+
+#include <array>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include "Device.h"
+
+/*
+    Memory-mapped framebuffer.
+
+    The video memory is a linear array of height lines of width pixels,
+    each pixel an index of bitsPerPixel bits (1, 2, 4 or 8, any other
+    depth gives 8; the leftmost pixel in the high bits of a byte) into a
+    256-entry RGBA palette.
+
+    Every write marks its scanline dirty in a bitmap; render(), called at
+    frame boundaries, converts only the dirty lines into the host RGBA
+    buffer, so the cost of a frame depends on what changed, not on the
+    size of the screen. Reads are served by the Bus directly from the
+    video memory.
+
+        Framebuffer screen(320, 200, 1);
+        bus.map(0x2000, 0x3f3f, screen);
+        ...
+        screen.render();
+        screen.savePNG("frame.png");
+
+    Headless tests can compare a frame against a golden image with
+    compare() (binary PPM, as written by savePPM()).
+*/
+class Framebuffer : public Device {
+public:
+    Framebuffer(unsigned width, unsigned height, unsigned bitsPerPixel = 8);
+
+    uint8_t read(uint16_t offset) override;
+    void write(uint16_t offset, uint8_t data) override;
+    uint8_t* readPage(uint16_t offset) override;
+
+    void setPalette(uint8_t index, uint8_t r, uint8_t g, uint8_t b, uint8_t a = 0xff);
+
+    //Convert the dirty lines, returns the number of lines rendered
+    unsigned render();
+    //Host image: width*height pixels, 4 bytes (R, G, B, A) per pixel
+    uint8_t const * pixels() const;
+
+    unsigned getWidth() const;
+    unsigned getHeight() const;
+    std::size_t size() const;           //Bytes of video memory
+
+    //Headless output of the host image (alpha is ignored by PPM)
+    bool savePPM(std::string const & fileName) const;
+    bool savePNG(std::string const & fileName) const;
+    /*
+        Number of pixels that differ from the golden image (binary PPM),
+        or -1 if the file cannot be read or has a different size.
+    */
+    long compare(std::string const & goldenFileName) const;
+
+private:
+    unsigned width;
+    unsigned height;
+    unsigned bitsPerPixel;
+    std::size_t bytesPerLine;
+
+    std::vector<uint8_t> memory;        //Video memory
+    std::vector<uint64_t> dirty;        //One bit per line
+    std::vector<uint8_t> image;         //Host RGBA image
+    std::array<std::array<uint8_t, 4>, 0x100> palette;
+
+    void renderLine(unsigned line);
+};
+
+#endif
@@ -0,0 +1,68 @@
+#include "HostLink.h"
+#include <unistd.h>
+#include <poll.h>
+#include <cerrno>
+
+/**** FdLink ****/
+FdLink::FdLink(int inputFd, int outputFd):
+    inputFd{inputFd}, outputFd{outputFd}
+{}
+
+std::size_t FdLink::send(uint8_t const * data, std::size_t size) {
+    if(outputFd < 0) return size;
+
+    std::size_t written = 0;
+    while(written < size) {
+        ssize_t n = ::write(outputFd, data + written, size - written);
+        if(n < 0 && errno == EINTR) continue;
+        //Non-blocking fd full: the rest is sent by the next flush
+        if(n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return written;
+        //The host closed the stream: drop the output
+        if(n <= 0) return size;
+        written += n;
+    }
+    return written;
+}
+
+std::size_t FdLink::receive(uint8_t* data, std::size_t size) {
+    if(inputFd < 0) return 0;
+
+    //Only read what is there, whatever the flags of the fd
+    pollfd fd{inputFd, POLLIN, 0};
+    int ready;
+    do {
+        ready = ::poll(&fd, 1, 0);
+    } while(ready < 0 && errno == EINTR);
+    if(ready <= 0 || !(fd.revents & POLLIN)) return 0;
+
+    ssize_t n;
+    do {
+        n = ::read(inputFd, data, size);
+    } while(n < 0 && errno == EINTR);
+    return n > 0 ? n : 0;
+}
+/****************/
+
+/**** QueueLink ****/
+QueueLink::QueueLink(ByteQueue* input, ByteQueue* output, Wakeup* outputReady):
+    input{input}, output{output}, outputReady{outputReady}
+{}
+
+std::size_t QueueLink::send(uint8_t const * data, std::size_t size) {
+    if(!output) return size;
+
+    std::size_t sent = output->push(data, size);
+    if(sent > 0 && outputReady) {
+        outputReady->notify();
+    }
+    return sent;
+}
+
+std::size_t QueueLink::receive(uint8_t* data, std::size_t size) {
+    return input ? input->pop(data, size) : 0;
+}
+
+bool QueueLink::cheapReceive() const {
+    return true;
+}
+/*******************/
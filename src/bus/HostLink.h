@@ -0,0 +1,78 @@
+#ifndef HOST_LINK_H
+#define HOST_LINK_H
+
+#include <cstdint>
+#include <cstddef>
+#include "SPSCQueue.h"
+
+/*
+    Byte stream between a device (emulator thread) and the host.
+
+    send() and receive() never block the emulator: they transfer what
+    they can and return the number of bytes transferred.
+*/
+class HostLink {
+public:
+    virtual ~HostLink() = default;
+
+    virtual std::size_t send(uint8_t const * data, std::size_t size) = 0;
+    virtual std::size_t receive(uint8_t* data, std::size_t size) = 0;
+
+    //True if receive() does not make a system call (no need to
+    //rate-limit the polling)
+    virtual bool cheapReceive() const { return false; }
+};
+
+/*
+    File descriptors (a negative fd disables the direction: the output
+    is discarded, nothing is received). Their flags are left as they
+    are (stdin shares them with stdout and the shell): the input is
+    polled before each read, so receive() never blocks. Writes block
+    on a blocking output fd; what a non-blocking one cannot take is
+    left to the caller (send() returns less than size).
+*/
+class FdLink : public HostLink {
+public:
+    FdLink(int inputFd, int outputFd);
+
+    std::size_t send(uint8_t const * data, std::size_t size) override;
+    std::size_t receive(uint8_t* data, std::size_t size) override;
+
+private:
+    int inputFd;
+    int outputFd;
+};
+
+using ByteQueue = SPSCQueue<uint8_t, 4096>;
+
+/*
+    Lock-free queues to host I/O threads: the emulator thread is the
+    producer of output and the consumer of input (either may be
+    nullptr). Every send() is one batch: it rings outputReady, which
+    only costs a system call if the host thread is asleep in
+    outputReady.wait().
+
+        ByteQueue toHost, fromHost;
+        Wakeup outputReady;
+        QueueLink link(&fromHost, &toHost, &outputReady);
+        ACIA acia(cpu.scheduler(), link);
+
+        //Host thread
+        outputReady.wait([&] { return !toHost.empty(); });
+        n = toHost.pop(buffer, sizeof(buffer));
+*/
+class QueueLink : public HostLink {
+public:
+    QueueLink(ByteQueue* input, ByteQueue* output, Wakeup* outputReady = nullptr);
+
+    std::size_t send(uint8_t const * data, std::size_t size) override;
+    std::size_t receive(uint8_t* data, std::size_t size) override;
+    bool cheapReceive() const override;
+
+private:
+    ByteQueue* input;
+    ByteQueue* output;
+    Wakeup* outputReady;
+};
+
+#endif
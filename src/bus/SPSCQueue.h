@@ -0,0 +1,153 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <algorithm>
+#include <cstddef>
+
+/*
+    Wait-free single-producer/single-consumer ring queue.
+
+    One thread pushes, one thread pops; neither ever blocks or takes a
+    lock. The indexes live on their own cache lines and each side keeps
+    a cached copy of the other side's index, so the shared cache lines
+    are only touched when the cached view says the queue looks full
+    (producer) or empty (consumer).
+
+    Capacity must be a power of two.
+*/
+template<class T, std::size_t Capacity>
+class SPSCQueue {
+    static_assert(Capacity != 0 && (Capacity & (Capacity - 1)) == 0,
+                  "Capacity must be a power of two");
+public:
+    /**** Producer ****/
+    bool push(T const & value);
+    //Push up to count values, returns the number pushed
+    std::size_t push(T const * values, std::size_t count);
+
+    /**** Consumer ****/
+    bool pop(T& value);
+    //Pop up to count values, returns the number popped
+    std::size_t pop(T* values, std::size_t count);
+
+    //Exact on the consumer side (may only grow concurrently)
+    bool empty() const;
+    std::size_t size() const;
+    static constexpr std::size_t capacity() { return Capacity; }
+
+private:
+    static constexpr std::size_t CACHE_LINE{64};
+    static constexpr std::size_t MASK{Capacity - 1};
+
+    alignas(CACHE_LINE) std::atomic<std::size_t> head{0};  //Next value to pop
+    alignas(CACHE_LINE) std::size_t cachedTail{0};         //Consumer's view of tail
+    alignas(CACHE_LINE) std::atomic<std::size_t> tail{0};  //Next free slot
+    alignas(CACHE_LINE) std::size_t cachedHead{0};         //Producer's view of head
+    alignas(CACHE_LINE) std::array<T, Capacity> buffer;
+};
+
+template<class T, std::size_t Capacity>
+bool SPSCQueue<T, Capacity>::push(T const & value) {
+    return push(&value, 1) == 1;
+}
+
+template<class T, std::size_t Capacity>
+std::size_t SPSCQueue<T, Capacity>::push(T const * values, std::size_t count) {
+    std::size_t t = tail.load(std::memory_order_relaxed);
+    if(Capacity - (t - cachedHead) < count) {
+        cachedHead = head.load(std::memory_order_acquire);
+    }
+    count = std::min(count, Capacity - (t - cachedHead));
+
+    for(std::size_t i = 0; i < count; ++i) {
+        buffer[(t + i) & MASK] = values[i];
+    }
+    tail.store(t + count, std::memory_order_release);
+    return count;
+}
+
+template<class T, std::size_t Capacity>
+bool SPSCQueue<T, Capacity>::pop(T& value) {
+    return pop(&value, 1) == 1;
+}
+
+template<class T, std::size_t Capacity>
+std::size_t SPSCQueue<T, Capacity>::pop(T* values, std::size_t count) {
+    std::size_t h = head.load(std::memory_order_relaxed);
+    if(cachedTail - h < count) {
+        cachedTail = tail.load(std::memory_order_acquire);
+    }
+    count = std::min(count, cachedTail - h);
+
+    for(std::size_t i = 0; i < count; ++i) {
+        values[i] = buffer[(h + i) & MASK];
+    }
+    head.store(h + count, std::memory_order_release);
+    return count;
+}
+
+template<class T, std::size_t Capacity>
+bool SPSCQueue<T, Capacity>::empty() const {
+    return size() == 0;
+}
+
+template<class T, std::size_t Capacity>
+std::size_t SPSCQueue<T, Capacity>::size() const {
+    return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+}
+
+/*
+    Batched wakeups of a sleeping consumer.
+
+    The consumer sleeps in wait() until its condition holds; the
+    producer calls notify() once per batch (not per value). notify() is
+    a load of an atomic flag while the consumer is awake: the mutex and
+    the system call are only paid to wake up a sleeping consumer.
+*/
+class Wakeup {
+public:
+    void notify();
+
+    //Sleep until ready() (timeout: return false if it still does not hold)
+    template<class F> void wait(F ready);
+    template<class F, class Duration> bool waitFor(F ready, Duration timeout);
+
+private:
+    std::atomic<bool> sleeping{false};
+    std::mutex mutex;
+    std::condition_variable condition;
+};
+
+inline void Wakeup::notify() {
+    //Pairs with the fence of waitFor(): either the producer sees the
+    //consumer asleep, or the consumer sees the values
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if(sleeping.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(mutex);
+        condition.notify_one();
+    }
+}
+
+template<class F>
+void Wakeup::wait(F ready) {
+    while(!waitFor(ready, std::chrono::hours(1))) {}
+}
+
+template<class F, class Duration>
+bool Wakeup::waitFor(F ready, Duration timeout) {
+    if(ready()) return true;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    sleeping.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    bool result = condition.wait_for(lock, timeout, ready);
+    sleeping.store(false, std::memory_order_relaxed);
+    return result;
+}
+
+#endif
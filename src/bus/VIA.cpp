@@ -0,0 +1,166 @@
+#include "VIA.h"
+#include <algorithm>
+
+VIA::VIA(Scheduler& scheduler, unsigned irqSource):
+    scheduler{scheduler}, irqSource{irqSource}
+{}
+
+VIA::~VIA() {
+    scheduler.cancel(this);
+    scheduler.setIRQLine(irqSource, false);
+}
+
+uint8_t VIA::read(uint16_t offset) {
+    uint64_t now = scheduler.getCycles();
+    update();
+
+    uint8_t data;
+    switch(offset & 0x0f) {
+        case ORB:    data = getPortB(); break;
+        case ORA:
+        case ORA_NH: data = getPortA(); break;
+        case T1CL:
+            ifr &= ~T1_FLAG;
+            data = timer1(now);
+            break;
+        case T1CH:   data = timer1(now) >> 8; break;
+        case T1LL:   data = t1Latch; break;
+        case T1LH:   data = t1Latch >> 8; break;
+        case T2CL:
+            ifr &= ~T2_FLAG;
+            data = timer2(now);
+            break;
+        case T2CH:   data = timer2(now) >> 8; break;
+        case IFR:    data = ifr | ((ifr & ier & 0x7f) ? 0x80 : 0x00); break;
+        case IER:    data = ier | 0x80; break;
+        default:     data = registers[offset & 0x0f]; break;
+    }
+
+    update();
+    return data;
+}
+
+void VIA::write(uint16_t offset, uint8_t data) {
+    uint64_t now = scheduler.getCycles();
+    update();
+
+    switch(offset & 0x0f) {
+        case T1CL:
+        case T1LL:
+            t1Latch = (t1Latch & 0xff00) | data;
+            break;
+        case T1CH:
+            //Load and start timer 1
+            t1Latch = (t1Latch & 0x00ff) | (data << 8);
+            t1Count = t1Latch;
+            t1Start = now;
+            t1Next = now + t1Count + 1;
+            t1Armed = true;
+            ifr &= ~T1_FLAG;
+            break;
+        case T1LH:
+            t1Latch = (t1Latch & 0x00ff) | (data << 8);
+            ifr &= ~T1_FLAG;
+            break;
+        case T2CL:
+            t2LatchLow = data;
+            break;
+        case T2CH:
+            //Load and start timer 2
+            t2Count = (data << 8) | t2LatchLow;
+            t2Start = now;
+            t2Next = now + t2Count + 1;
+            t2Armed = true;
+            ifr &= ~T2_FLAG;
+            break;
+        case IFR:
+            //Writing 1 clears the flag
+            ifr &= ~data;
+            break;
+        case IER:
+            if(data & 0x80) {
+                ier |= data & 0x7f;
+            } else {
+                ier &= ~data;
+            }
+            break;
+        default:
+            registers[offset & 0x0f] = data;
+            break;
+    }
+
+    update();
+}
+
+/**** Ports ****/
+void VIA::setPortA(uint8_t pins) {
+    inputA = pins;
+}
+
+void VIA::setPortB(uint8_t pins) {
+    inputB = pins;
+}
+
+uint8_t VIA::getPortA() const {
+    uint8_t ddr = registers[DDRA];
+    return (registers[ORA] & ddr) | (inputA & ~ddr);
+}
+
+uint8_t VIA::getPortB() const {
+    uint8_t ddr = registers[DDRB];
+    return (registers[ORB] & ddr) | (inputB & ~ddr);
+}
+/***************/
+
+/**** Timers ****/
+bool VIA::freeRun() const {
+    return registers[ACR] & (1U<<6);
+}
+
+uint16_t VIA::timer1(uint64_t now) const {
+    uint64_t elapsed = now - t1Start;
+    if(!freeRun()) {
+        //Keeps counting down after the underflow
+        return static_cast<uint16_t>(t1Count - elapsed);
+    }
+    //N, N-1, ..., 0, 0xFFFF, N, ...
+    uint64_t phase = elapsed % (t1Count + 2);
+    return phase <= t1Count ? static_cast<uint16_t>(t1Count - phase) : 0xffff;
+}
+
+uint16_t VIA::timer2(uint64_t now) const {
+    return static_cast<uint16_t>(t2Count - (now - t2Start));
+}
+
+void VIA::update() {
+    uint64_t now = scheduler.getCycles();
+
+    if(t1Armed && now >= t1Next) {
+        ifr |= T1_FLAG;
+        if(freeRun()) {
+            uint64_t period = t1Count + 2;
+            t1Next += period * ((now - t1Next) / period + 1);
+        } else {
+            t1Armed = false;
+        }
+    }
+    if(t2Armed && now >= t2Next) {
+        ifr |= T2_FLAG;
+        t2Armed = false;
+    }
+
+    scheduler.setIRQLine(irqSource, (ifr & ier & 0x7f) != 0);
+
+    //Only the underflows that raise an IRQ need an event: the flags of
+    //the others are set when the registers are read
+    bool t1Event = t1Armed && (ier & T1_FLAG);
+    bool t2Event = t2Armed && (ier & T2_FLAG);
+    if(t1Event || t2Event) {
+        uint64_t cycle = (t1Event && t2Event) ? std::min(t1Next, t2Next)
+                                              : (t1Event ? t1Next : t2Next);
+        scheduler.schedule(this, cycle, [this] { update(); });
+    } else {
+        scheduler.cancel(this);
+    }
+}
+/****************/
@@ -0,0 +1,96 @@
+#ifndef VIA_H
+#define VIA_H
+
+#include <cstdint>
+#include "Device.h"
+#include "../cpu/Scheduler.h"
+
+/*
+    6522 VIA: timers 1 and 2, interrupt registers and I/O ports.
+
+    The timers are not ticked: a counter is computed from the CPU cycle
+    counter when it is read, and the VIA schedules an event for the next
+    underflow of an enabled timer, so the IRQ line is asserted at the
+    exact cycle without polling.
+
+        VIA via(cpu.scheduler());
+        bus.map(0x6000, 0x600f, via);
+
+    Timer 1 is loaded (and started) by writing T1C-H: it underflows
+    N+1 cycles later, then every N+2 cycles in free-run mode (ACR bit 6).
+    Timer 2 is one-shot only (no pulse counting). Handshake lines (CA/CB),
+    the shift register and the latching of the ports are not emulated:
+    the shift register is a plain register, PCR is stored.
+*/
+class VIA : public Device {
+public:
+    //irqSource: bit of the IRQ line of the scheduler (see Scheduler.h)
+    explicit VIA(Scheduler& scheduler, unsigned irqSource = 0);
+    ~VIA() override;
+
+    uint8_t read(uint16_t offset) override;
+    void write(uint16_t offset, uint8_t data) override;
+
+    //Input pins of the ports (bits configured as inputs by DDRA/DDRB)
+    void setPortA(uint8_t pins);
+    void setPortB(uint8_t pins);
+    //Pins as driven by the VIA (outputs) and by setPort*() (inputs)
+    uint8_t getPortA() const;
+    uint8_t getPortB() const;
+
+    //Registers (offsets, mirrored every 16 bytes)
+    static constexpr uint8_t ORB{0x0};
+    static constexpr uint8_t ORA{0x1};
+    static constexpr uint8_t DDRB{0x2};
+    static constexpr uint8_t DDRA{0x3};
+    static constexpr uint8_t T1CL{0x4};
+    static constexpr uint8_t T1CH{0x5};
+    static constexpr uint8_t T1LL{0x6};
+    static constexpr uint8_t T1LH{0x7};
+    static constexpr uint8_t T2CL{0x8};
+    static constexpr uint8_t T2CH{0x9};
+    static constexpr uint8_t SR{0xa};
+    static constexpr uint8_t ACR{0xb};
+    static constexpr uint8_t PCR{0xc};
+    static constexpr uint8_t IFR{0xd};
+    static constexpr uint8_t IER{0xe};
+    static constexpr uint8_t ORA_NH{0xf};
+
+    //Interrupt flags
+    static constexpr uint8_t T1_FLAG{1U<<6};
+    static constexpr uint8_t T2_FLAG{1U<<5};
+
+private:
+    Scheduler& scheduler;
+    unsigned irqSource;
+
+    /**** Registers ****/
+    uint8_t registers[16] = {0};        //ORB..ORA_NH as last written
+    uint8_t ifr{0};
+    uint8_t ier{0};
+    uint8_t inputA{0xff};
+    uint8_t inputB{0xff};
+
+    /**** Timers ****/
+    uint16_t t1Latch{0};
+    uint64_t t1Start{0};                //Cycle of the last load
+    uint16_t t1Count{0};                //Value loaded
+    bool t1Armed{false};                //The next underflow sets the flag
+    uint64_t t1Next{0};                 //Cycle of the next underflow
+
+    uint8_t t2LatchLow{0};
+    uint64_t t2Start{0};
+    uint16_t t2Count{0};
+    bool t2Armed{false};
+    uint64_t t2Next{0};
+
+    uint16_t timer1(uint64_t now) const;
+    uint16_t timer2(uint64_t now) const;
+    bool freeRun() const;
+
+    //Set the flags of the underflows up to now, then update the IRQ
+    //line and the scheduled event
+    void update();
+};
+
+#endif
@@ -0,0 +1,511 @@
+#include "CycleEngine.h"
+#include "Operations.h"
+
+using BYTE = uint8_t;
+using WORD = uint16_t;
+
+/*
+    Bus access sequences:
+     - http://www.6502.org/tutorials/6502opcodes.html
+     - "64doc" (John West, Marko Mäkelä), section "6510 Instruction Timing"
+    65C02 differences: indexed page-crossing and read-modify-write dummy
+    accesses are reads of the last instruction byte / of the operand
+    instead of reads of the invalid address / writes.
+*/
+
+template<class Variant>
+CycleEngine<Variant>::CycleEngine(MOS6502Core<Variant>& cpu):
+    cpu{cpu}
+{}
+
+template<class Variant>
+void CycleEngine<Variant>::tick() {
+    using Core = MOS6502Core<Variant>;
+
+    //Device events due before this cycle
+    if(t == 0 && cpu.cycles >= cpu.events.nextCycle()) {
+        cpu.events.runEvents();
+    }
+
+    //Every cycle of the 6502 is a bus cycle
+    ++cpu.cycles;
+
+    if(t != 0) {
+        if(vector != 0) {
+            interruptCycle();
+        } else {
+            (this->*CYCLES[opcode])();
+        }
+        return;
+    }
+
+    /**** Instruction boundary ****/
+    bool irq = irqPending || cpu.events.irqAsserted();
+    if(nmiPending || (irq && cpu.SR[Core::IF] == 0)) {
+        vector = nmiPending ? 0xfffa : 0xfffe;
+        hardwareInterrupt = true;
+        nmiPending = false;
+        irqPending = false;
+        //Opcode fetch is replaced by a dummy read, PC is not incremented
+        read(cpu.PC);
+        t = 1;
+        return;
+    }
+    irqPending = false;
+
+    opcode = fetch();
+    //The 65C02 one-byte NOPs end with their opcode fetch
+    t = INSTRUCTIONS<Variant>[opcode].cycles == 1 ? 0 : 1;
+}
+
+template<class Variant>
+void CycleEngine<Variant>::step() {
+    do {
+        tick();
+    } while(t != 0);
+}
+
+template<class Variant>
+void CycleEngine<Variant>::execute(WORD init_PC, WORD end_PC) {
+    cpu.PC = init_PC;
+
+    while(cpu.PC <= end_PC) {
+        // Debugging
+        if(cpu.breakpoint != 0 && cpu.PC == cpu.breakpoint) {
+            break;
+        }
+
+        step();
+    }
+}
+
+template<class Variant>
+bool CycleEngine<Variant>::atInstructionBoundary() const {
+    return t == 0;
+}
+
+template<class Variant>
+void CycleEngine<Variant>::IRQ() {
+    irqPending = true;
+}
+
+template<class Variant>
+void CycleEngine<Variant>::NMI() {
+    nmiPending = true;
+}
+
+/**** Bus ****/
+template<class Variant>
+uint8_t CycleEngine<Variant>::read(WORD addr) {
+    return cpu.readMemory(addr);
+}
+
+template<class Variant>
+void CycleEngine<Variant>::write(WORD addr, BYTE value) {
+    cpu.writeMemory(addr, value);
+}
+
+template<class Variant>
+uint8_t CycleEngine<Variant>::fetch() {
+    return read(cpu.PC++);
+}
+
+template<class Variant>
+void CycleEngine<Variant>::done() {
+    t = 0;
+}
+/*************/
+
+/**** Microcode ****/
+template<class Variant>
+template<uint8_t opcode>
+void CycleEngine<Variant>::cycle() {
+    constexpr Mnemonic M{INSTRUCTIONS<Variant>[opcode].mnemonic};
+    constexpr AddrMode A{INSTRUCTIONS<Variant>[opcode].mode};
+
+    if constexpr ((accessType(M) != Access::none || M == Mnemonic::NOP) && A != AddrMode::imp) {
+        memoryOperandCycle<opcode>();
+    } else if constexpr (A == AddrMode::rel) {
+        branchCycle<opcode>();
+    } else if constexpr (M == Mnemonic::PHA || M == Mnemonic::PHP ||
+                         M == Mnemonic::PHX || M == Mnemonic::PHY) {
+        pushCycle<opcode>();
+    } else if constexpr (M == Mnemonic::PLA || M == Mnemonic::PLP ||
+                         M == Mnemonic::PLX || M == Mnemonic::PLY) {
+        pullCycle<opcode>();
+    } else if constexpr (M == Mnemonic::JSR) {
+        jsrCycle();
+    } else if constexpr (M == Mnemonic::RTS) {
+        rtsCycle();
+    } else if constexpr (M == Mnemonic::RTI) {
+        rtiCycle();
+    } else if constexpr (M == Mnemonic::JMP) {
+        jmpCycle(A);
+    } else if constexpr (M == Mnemonic::BRK) {
+        //Padding byte, then same sequence of an interrupt
+        fetch();
+        vector = 0xfffe;
+        hardwareInterrupt = false;
+        t = 2;
+    } else {
+        //Implied (and accumulator): dummy read of the next byte
+        read(cpu.PC);
+        cpu.template operation<opcode, NoHooks>(0, false);
+        done();
+    }
+}
+
+template<class Variant>
+template<uint8_t opcode>
+void CycleEngine<Variant>::memoryOperandCycle() {
+    constexpr InstructionInfo info{INSTRUCTIONS<Variant>[opcode]};
+    constexpr Mnemonic M{info.mnemonic};
+    constexpr AddrMode A{info.mode};
+    //Indexed modes without page crossing penalty always pay the fix-up cycle
+    constexpr bool alwaysFixup{info.pagePenalty == 0};
+
+    /**** Addressing ****/
+    if(t == 1) {
+        //Number of addressing cycles (indexed modes may add a fix-up cycle)
+        switch(A) {
+            case AddrMode::imm: accessStart = 1; break;
+            case AddrMode::zpg: accessStart = 2; break;
+            case AddrMode::zpx:
+            case AddrMode::zpy:
+            case AddrMode::abs:
+            case AddrMode::abx:
+            case AddrMode::aby: accessStart = 3; break;
+            case AddrMode::iny:
+            case AddrMode::izp: accessStart = 4; break;
+            case AddrMode::xin: accessStart = 5; break;
+            default:            accessStart = 1; break;
+        }
+    }
+
+    if(t < accessStart) {
+        if constexpr (A == AddrMode::zpg) {
+            address = fetch();
+        } else if constexpr (A == AddrMode::zpx || A == AddrMode::zpy) {
+            if(t == 1) {
+                address = fetch();
+            } else {
+                //Dummy read of the unindexed address
+                read(address);
+                BYTE index = (A == AddrMode::zpx) ? cpu.X : cpu.Y;
+                address = static_cast<uint8_t>(address + index);
+            }
+        } else if constexpr (A == AddrMode::abs) {
+            if(t == 1) {
+                address = fetch();
+            } else {
+                address |= fetch()*16*16;
+            }
+        } else if constexpr (A == AddrMode::abx || A == AddrMode::aby) {
+            if(t == 1) {
+                base = fetch();
+            } else if(t == 2) {
+                base |= fetch()*16*16;
+                BYTE index = (A == AddrMode::abx) ? cpu.X : cpu.Y;
+                address = base + index;
+                if(alwaysFixup || (address/(16*16)) != (base/(16*16))) {
+                    accessStart = 4;
+                }
+            } else {
+                //Fix-up cycle
+                if constexpr (Variant::cmos) {
+                    read(cpu.PC-1);
+                } else {
+                    read((base & 0xff00) | (address & 0x00ff));
+                }
+            }
+        } else if constexpr (A == AddrMode::xin) {
+            if(t == 1) {
+                pointer = fetch();
+            } else if(t == 2) {
+                read(pointer);
+                pointer += cpu.X;
+            } else if(t == 3) {
+                address = read(pointer);
+            } else {
+                address |= read(static_cast<uint8_t>(pointer+1))*16*16;
+            }
+        } else if constexpr (A == AddrMode::iny) {
+            if(t == 1) {
+                pointer = fetch();
+            } else if(t == 2) {
+                base = read(pointer);
+            } else if(t == 3) {
+                base |= read(static_cast<uint8_t>(pointer+1))*16*16;
+                address = base + cpu.Y;
+                if(alwaysFixup || (address/(16*16)) != (base/(16*16))) {
+                    accessStart = 5;
+                }
+            } else {
+                //Fix-up cycle
+                if constexpr (Variant::cmos) {
+                    read(cpu.PC-1);
+                } else {
+                    read((base & 0xff00) | (address & 0x00ff));
+                }
+            }
+        } else if constexpr (A == AddrMode::izp) {
+            if(t == 1) {
+                pointer = fetch();
+            } else if(t == 2) {
+                address = read(pointer);
+            } else {
+                address |= read(static_cast<uint8_t>(pointer+1))*16*16;
+            }
+        }
+        ++t;
+        return;
+    }
+
+    /**** Operand access ****/
+    BYTE s = t - accessStart;
+
+    if constexpr (M == Mnemonic::NOP) {
+        //65C02 undefined opcodes: reads of the operand until the end
+        if constexpr (A == AddrMode::imm) {
+            if(s == 0) address = cpu.PC++;
+        }
+        read(address);
+        if(t + 1 < info.cycles) {
+            ++t;
+        } else {
+            done();
+        }
+    } else if constexpr (accessType(M) == Access::read) {
+        if(s == 0) {
+            if constexpr (A == AddrMode::imm) {
+                address = cpu.PC++;
+            }
+            cpu.template readOperation<M, A>(read(address));
+
+            //The 65C02 takes one more cycle for ADC/SBC in decimal mode
+            if constexpr (Variant::cmos && Variant::decimalMode &&
+                          (M == Mnemonic::ADC || M == Mnemonic::SBC)) {
+                if(cpu.SR[MOS6502Core<Variant>::DF] == 1) {
+                    ++t;
+                    return;
+                }
+            }
+            done();
+        } else {
+            read(address);
+            done();
+        }
+    } else if constexpr (accessType(M) == Access::write) {
+        write(address, cpu.template writeOperation<M>());
+        done();
+    } else {
+        //Read-modify-write
+        if(s == 0) {
+            data = read(address);
+            ++t;
+        } else if(s == 1) {
+            if constexpr (Variant::cmos) {
+                read(address);
+            } else {
+                //The NMOS 6502 writes back the unmodified value
+                write(address, data);
+            }
+            ++t;
+        } else {
+            write(address, cpu.template modifyOperation<M>(data));
+            done();
+        }
+    }
+}
+
+template<class Variant>
+template<uint8_t opcode>
+void CycleEngine<Variant>::branchCycle() {
+    constexpr Mnemonic M{INSTRUCTIONS<Variant>[opcode].mnemonic};
+
+    if(t == 1) {
+        data = fetch();
+        if(!cpu.template branchTaken<M>()) {
+            done();
+            return;
+        }
+        address = cpu.PC + static_cast<int8_t>(data);
+        ++t;
+    } else if(t == 2) {
+        read(cpu.PC);
+        if((address/(16*16)) == (cpu.PC/(16*16))) {
+            cpu.PC = address;
+            done();
+            return;
+        }
+        //PCL is fixed first, PCH in the next cycle
+        cpu.PC = (cpu.PC & 0xff00) | (address & 0x00ff);
+        ++t;
+    } else {
+        read(cpu.PC);
+        cpu.PC = address;
+        done();
+    }
+}
+
+template<class Variant>
+template<uint8_t opcode>
+void CycleEngine<Variant>::pushCycle() {
+    if(t == 1) {
+        read(cpu.PC);
+        ++t;
+    } else {
+        cpu.template operation<opcode, NoHooks>(0, false);
+        done();
+    }
+}
+
+template<class Variant>
+template<uint8_t opcode>
+void CycleEngine<Variant>::pullCycle() {
+    if(t == 1) {
+        read(cpu.PC);
+        ++t;
+    } else if(t == 2) {
+        read(0x0100+cpu.SP);
+        ++t;
+    } else {
+        cpu.template operation<opcode, NoHooks>(0, false);
+        done();
+    }
+}
+
+template<class Variant>
+void CycleEngine<Variant>::interruptCycle() {
+    using Core = MOS6502Core<Variant>;
+
+    switch(t) {
+        case 1:
+            //Hardware interrupts only (BRK fetches its padding byte)
+            read(cpu.PC);
+            break;
+        case 2:
+            cpu.template push<NoHooks>(cpu.PC/(16*16));
+            break;
+        case 3:
+            cpu.template push<NoHooks>(cpu.PC);
+            break;
+        case 4:
+            //BFlag is set only in the pushed copy, and only by BRK
+            cpu.SR[Core::BF] = !hardwareInterrupt;
+            cpu.template push<NoHooks>(cpu.SR.to_ulong());
+            cpu.SR[Core::BF] = 0;
+            cpu.SR[Core::IF] = 1;
+            if constexpr (Variant::cmos) {
+                cpu.SR[Core::DF] = 0;
+            }
+            break;
+        case 5:
+            address = read(vector);
+            break;
+        default:
+            cpu.PC = read(vector+1)*16*16+address;
+            vector = 0;
+            done();
+            return;
+    }
+    ++t;
+}
+
+template<class Variant>
+void CycleEngine<Variant>::jsrCycle() {
+    switch(t) {
+        case 1: address = fetch(); break;
+        case 2: read(0x0100+cpu.SP); break;
+        case 3: cpu.template push<NoHooks>(cpu.PC/(16*16)); break;
+        case 4: cpu.template push<NoHooks>(cpu.PC); break;
+        default:
+            cpu.PC = read(cpu.PC)*16*16+address;
+            done();
+            return;
+    }
+    ++t;
+}
+
+template<class Variant>
+void CycleEngine<Variant>::rtsCycle() {
+    switch(t) {
+        case 1: read(cpu.PC); break;
+        case 2: read(0x0100+cpu.SP); break;
+        case 3: address = cpu.template pull<NoHooks>(); break;
+        case 4: address |= cpu.template pull<NoHooks>()*16*16; break;
+        default:
+            read(address);
+            cpu.PC = address+1;
+            done();
+            return;
+    }
+    ++t;
+}
+
+template<class Variant>
+void CycleEngine<Variant>::rtiCycle() {
+    switch(t) {
+        case 1: read(cpu.PC); break;
+        case 2: read(0x0100+cpu.SP); break;
+        case 3: cpu.template pullSR<NoHooks>(); break;
+        case 4: address = cpu.template pull<NoHooks>(); break;
+        default:
+            cpu.PC = cpu.template pull<NoHooks>()*16*16+address;
+            done();
+            return;
+    }
+    ++t;
+}
+
+template<class Variant>
+void CycleEngine<Variant>::jmpCycle(AddrMode mode) {
+    //Extra cycle of the 65C02 JMP (ind) and of JMP (abs,X)
+    constexpr bool cmosIndirect{Variant::cmos};
+    BYTE last = (mode == AddrMode::abs) ? 2
+              : (mode == AddrMode::ind && !cmosIndirect) ? 4 : 5;
+
+    if(t == 1) {
+        address = fetch();
+    } else if(t == 2) {
+        address |= fetch()*16*16;
+        if(mode == AddrMode::abs) {
+            cpu.PC = address;
+            done();
+            return;
+        }
+    } else if(t == 3 && last == 5) {
+        read(cpu.PC-1);
+        if(mode == AddrMode::axi) {
+            address += cpu.X;
+        }
+    } else if(t < last) {
+        base = read(address);
+    } else {
+        WORD high = address+1;
+        if constexpr (Variant::jmpIndirectPageWrap) {
+            //NMOS bug: (address+1) does not carry into the high byte
+            high = (address & 0xff00) | static_cast<uint8_t>(address+1);
+        }
+        cpu.PC = read(high)*16*16+base;
+        done();
+        return;
+    }
+    ++t;
+}
+/*******************/
+
+template<class Variant>
+template<std::size_t... opcodes>
+constexpr typename CycleEngine<Variant>::CycleTable
+CycleEngine<Variant>::makeCycleTable(std::index_sequence<opcodes...>) {
+    return {{ &CycleEngine::cycle<opcodes>... }};
+}
+
+template<class Variant>
+const typename CycleEngine<Variant>::CycleTable CycleEngine<Variant>::CYCLES =
+    CycleEngine<Variant>::makeCycleTable(std::make_index_sequence<0x100>());
+
+template class CycleEngine<NMOS6502>;
+template class CycleEngine<CMOS65C02>;
+template class CycleEngine<RP2A03>;
@@ -0,0 +1,100 @@
+#ifndef CYCLE_ENGINE_H
+#define CYCLE_ENGINE_H
+
+#include <array>
+#include <utility>
+#include <cstdint>
+#include "MOS6502.h"
+
+/*
+    Cycle-exact engine.
+
+    MOS6502Core::execute()/step() run one whole instruction at a time and
+    only perform the logical memory accesses. CycleEngine drives the same
+    core (same registers, same cycle counter, same memory functions) one
+    bus cycle at a time: every tick() performs exactly the bus access
+    the real CPU performs in that cycle, including the dummy reads of the
+    indexed addressing modes and the double write of the read-modify-write
+    instructions.
+
+    The engine only adds state while an instruction is in flight, so it
+    is possible to switch between the two engines at every instruction
+    boundary (see atInstructionBoundary()):
+
+        MOS6502 cpu(memory.pages());
+        CycleEngine<NMOS6502> engine(cpu);
+
+        cpu.step();         //Fast engine
+        engine.tick();      //Cycle-exact engine
+        ...
+
+    Machines that do not need cycle-exact accesses just never instantiate
+    a CycleEngine: the fast engine is not affected by its existence.
+
+    Note: ticks do not emulate the clock speed (no delay), the caller is
+    expected to drive tick() from its own clock.
+*/
+template<class Variant>
+class CycleEngine {
+public:
+    explicit CycleEngine(MOS6502Core<Variant>& cpu);
+
+    //Execute one bus cycle
+    void tick();
+    //Execute cycles up to the next instruction boundary
+    void step();
+    //Same as MOS6502Core::execute() (breakpoint included)
+    void execute(uint16_t init_PC, uint16_t end_PC);
+    //True if the next tick() fetches an opcode (or starts an interrupt)
+    bool atInstructionBoundary() const;
+
+    //Interrupts are serviced at the next instruction boundary
+    //(a masked IRQ is dropped, as in MOS6502Core::IRQ())
+    void IRQ();
+    void NMI();
+
+private:
+    MOS6502Core<Variant>& cpu;
+
+    /**** Instruction in flight ****/
+    uint8_t opcode{0};
+    uint8_t t{0};                   //Cycle of the current instruction (0: opcode fetch)
+    uint8_t accessStart{0};         //First cycle of the operand access
+    uint16_t address{0};            //Effective address
+    uint16_t base{0};               //Address before indexing
+    uint8_t pointer{0};             //Zeropage pointer (xin, iny, izp)
+    uint8_t data{0};                //Operand
+
+    /**** Interrupts ****/
+    bool irqPending{false};
+    bool nmiPending{false};
+    uint16_t vector{0};             //!=0 while an interrupt sequence is running
+    bool hardwareInterrupt{false};  //IRQ/NMI (false: BRK)
+
+    /**** Bus ****/
+    uint8_t read(uint16_t addr);
+    void write(uint16_t addr, uint8_t value);
+    uint8_t fetch();
+    void done();
+
+    /**** Microcode ****/
+    template<uint8_t opcode> void cycle();
+    template<uint8_t opcode> void memoryOperandCycle();
+    template<uint8_t opcode> void branchCycle();
+    template<uint8_t opcode> void pushCycle();
+    template<uint8_t opcode> void pullCycle();
+    void interruptCycle();
+    void jsrCycle();
+    void rtsCycle();
+    void rtiCycle();
+    void jmpCycle(AddrMode mode);
+
+    /**** Jump Table ****/
+    typedef void (CycleEngine::*cyc)();
+    using CycleTable = std::array<cyc, 0x100>;
+    static const CycleTable CYCLES;
+    template<std::size_t... opcodes>
+    static constexpr CycleTable makeCycleTable(std::index_sequence<opcodes...>);
+};
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef HOOKS_H
+#define HOOKS_H
+
+#include <cstdint>
+#include "Instructions.h"
+
+/*
+    Instruction and memory hooks.
+
+    The interpreter is instantiated twice, once per hook policy:
+     - NoHooks:      no hook is called, the code is the same as the
+                     interpreter without hooks
+     - ToolingHooks: every instruction and every memory access is
+                     reported to the CPUHooks object set with
+                     MOS6502Core::setHooks()
+
+    Both instantiations live in the same binary: setHooks(&hooks) and
+    setHooks(nullptr) switch between them at the next instruction
+    boundary.
+*/
+
+struct NoHooks {
+    static constexpr bool enabled{false};
+};
+
+struct ToolingHooks {
+    static constexpr bool enabled{true};
+};
+
+//Registers and cycle counter
+struct CPUState {
+    uint16_t PC;
+    uint8_t AC;
+    uint8_t X;
+    uint8_t Y;
+    uint8_t SR;
+    uint8_t SP;
+    uint64_t cycles;
+};
+
+//Instruction about to be (or just) executed
+struct DecodedInstruction {
+    uint16_t PC;                //Address of the opcode
+    uint8_t opcode;
+    uint8_t operand[2];         //Only instructionLength(info.mode)-1 bytes are valid
+    InstructionInfo info;
+};
+
+/*
+    Override the functions of interest. Memory accesses done to
+    decode the instruction reported to preInstruction() are not
+    reported.
+*/
+class CPUHooks {
+public:
+    virtual ~CPUHooks() = default;
+
+    virtual void preInstruction(DecodedInstruction const &, CPUState const &) {}
+    virtual void postInstruction(DecodedInstruction const &, CPUState const &) {}
+
+    //Opcode and operand bytes read through PC (immediate operands included)
+    virtual void memoryFetch(uint16_t, uint8_t) {}
+    //Data accesses (stack and vectors included)
+    virtual void memoryRead(uint16_t, uint8_t) {}
+    virtual void memoryWrite(uint16_t, uint8_t) {}
+};
+
+#endif
@@ -0,0 +1,474 @@
+#ifndef INSTRUCTIONS_H
+#define INSTRUCTIONS_H
+
+#include <array>
+#include <cstdint>
+
+/*
+    Single-source description of the instruction set.
+
+    For every opcode the table below gives the mnemonic, the
+    addressing mode, the base number of cycles, the penalty paid when
+    the effective address crosses a page boundary and the flags
+    affected by the instruction.
+
+    The interpreter generates its opcode handlers from this table (see
+    MOS6502Core::instruction()), and the same table is meant to feed
+    every other tool that needs to know about instructions
+    (disassembler, tracer, static analysis...), so that there is only
+    one cycle table to verify.
+
+    https://www.masswerk.at/6502/6502_instruction_set.html
+    https://www.westerndesigncenter.com/wdc/documentation/w65c02s.pdf
+*/
+
+enum class Mnemonic : uint8_t {
+    ADC, AND, ASL, BCC, BCS, BEQ, BIT, BMI,
+    BNE, BPL, BRA, BRK, BVC, BVS, CLC, CLD,
+    CLI, CLV, CMP, CPX, CPY, DEC, DEX, DEY,
+    EOR, INC, INX, INY, JMP, JSR, LDA, LDX,
+    LDY, LSR, NOP, ORA, PHA, PHP, PHX, PHY,
+    PLA, PLP, PLX, PLY, ROL, ROR, RTI, RTS,
+    SBC, SEC, SED, SEI, STA, STX, STY, STZ,
+    TAX, TAY, TRB, TSB, TSX, TXA, TXS, TYA,
+    ILL     //Illegal opcode (executed as a NOP)
+};
+
+/*
+    Addressing modes:
+      imp: implied/accumulator      imm: immediate
+      zpg: zeropage                 zpx: zeropage,X indexed
+      zpy: zeropage,Y indexed       abs: absolute
+      abx: absolute,X indexed       aby: absolute,Y indexed
+      ind: indirect                 xin: X indexed,indirect
+      iny: indirect,Y indexed       rel: relative
+      izp: zeropage,indirect (65C02)
+      axi: absolute,X indexed,indirect (65C02)
+*/
+enum class AddrMode : uint8_t {
+    imp, imm, zpg, zpx, zpy, abs, abx, aby,
+    ind, xin, iny, rel, izp, axi
+};
+
+//Flags affected by an instruction (same bit positions of the status register)
+namespace Flag {
+    constexpr uint8_t C{1U<<0};
+    constexpr uint8_t Z{1U<<1};
+    constexpr uint8_t I{1U<<2};
+    constexpr uint8_t D{1U<<3};
+    constexpr uint8_t V{1U<<6};
+    constexpr uint8_t N{1U<<7};
+}
+
+//How an instruction accesses its memory operand
+enum class Access : uint8_t {
+    none,   //No memory operand (implied, stack, control flow)
+    read,   //LDA, ADC, CMP, BIT...
+    write,  //STA, STX, STY, STZ
+    rmw     //Read-modify-write: ASL, INC, TSB...
+};
+
+constexpr Access accessType(Mnemonic mnemonic) {
+    switch(mnemonic) {
+        case Mnemonic::LDA: case Mnemonic::LDX: case Mnemonic::LDY:
+        case Mnemonic::AND: case Mnemonic::EOR: case Mnemonic::ORA:
+        case Mnemonic::ADC: case Mnemonic::SBC: case Mnemonic::BIT:
+        case Mnemonic::CMP: case Mnemonic::CPX: case Mnemonic::CPY:
+            return Access::read;
+        case Mnemonic::STA: case Mnemonic::STX: case Mnemonic::STY:
+        case Mnemonic::STZ:
+            return Access::write;
+        case Mnemonic::ASL: case Mnemonic::LSR: case Mnemonic::ROL:
+        case Mnemonic::ROR: case Mnemonic::INC: case Mnemonic::DEC:
+        case Mnemonic::TRB: case Mnemonic::TSB:
+            return Access::rmw;
+        default:
+            return Access::none;
+    }
+}
+
+struct InstructionInfo {
+    Mnemonic mnemonic;
+    AddrMode mode;
+    uint8_t cycles;         //Base cycles
+    uint8_t pagePenalty;    //Extra cycles when a page boundary is crossed
+                            //(branches: paid only if the branch is taken)
+    uint8_t flags;          //Flags affected
+};
+
+using InstructionTable = std::array<InstructionInfo, 0x100>;
+
+constexpr const char* MNEMONIC_NAMES[] = {
+    "ADC", "AND", "ASL", "BCC", "BCS", "BEQ", "BIT", "BMI",
+    "BNE", "BPL", "BRA", "BRK", "BVC", "BVS", "CLC", "CLD",
+    "CLI", "CLV", "CMP", "CPX", "CPY", "DEC", "DEX", "DEY",
+    "EOR", "INC", "INX", "INY", "JMP", "JSR", "LDA", "LDX",
+    "LDY", "LSR", "NOP", "ORA", "PHA", "PHP", "PHX", "PHY",
+    "PLA", "PLP", "PLX", "PLY", "ROL", "ROR", "RTI", "RTS",
+    "SBC", "SEC", "SED", "SEI", "STA", "STX", "STY", "STZ",
+    "TAX", "TAY", "TRB", "TSB", "TSX", "TXA", "TXS", "TYA",
+    "???"
+};
+
+constexpr const char* mnemonicName(Mnemonic mnemonic) {
+    return MNEMONIC_NAMES[static_cast<uint8_t>(mnemonic)];
+}
+
+//Instruction length in bytes (opcode included)
+constexpr uint8_t instructionLength(AddrMode mode) {
+    switch(mode) {
+        case AddrMode::imp:
+            return 1;
+        case AddrMode::abs: case AddrMode::abx: case AddrMode::aby:
+        case AddrMode::ind: case AddrMode::axi:
+            return 3;
+        default:
+            return 2;
+    }
+}
+
+template<class Variant>
+constexpr InstructionTable makeInstructionTable() {
+    using M = Mnemonic;
+    using A = AddrMode;
+    constexpr uint8_t NZ{Flag::N|Flag::Z};
+    constexpr uint8_t NZC{NZ|Flag::C};
+    constexpr uint8_t NVZ{NZ|Flag::V};
+    constexpr uint8_t NVZC{NVZ|Flag::C};
+    constexpr uint8_t ALL{NVZC|Flag::D|Flag::I};
+    constexpr InstructionInfo ill{M::ILL, A::imp, 2, 0, 0};
+
+    InstructionTable t = {{
+        /*0-*/
+        /*00*/ {M::BRK, A::imp, 7, 0, Flag::I},
+        /*01*/ {M::ORA, A::xin, 6, 0, NZ},
+        /*02*/ ill,
+        /*03*/ ill,
+        /*04*/ ill,
+        /*05*/ {M::ORA, A::zpg, 3, 0, NZ},
+        /*06*/ {M::ASL, A::zpg, 5, 0, NZC},
+        /*07*/ ill,
+        /*08*/ {M::PHP, A::imp, 3, 0, 0},
+        /*09*/ {M::ORA, A::imm, 2, 0, NZ},
+        /*0A*/ {M::ASL, A::imp, 2, 0, NZC},
+        /*0B*/ ill,
+        /*0C*/ ill,
+        /*0D*/ {M::ORA, A::abs, 4, 0, NZ},
+        /*0E*/ {M::ASL, A::abs, 6, 0, NZC},
+        /*0F*/ ill,
+        /*1-*/
+        /*10*/ {M::BPL, A::rel, 2, 1, 0},
+        /*11*/ {M::ORA, A::iny, 5, 1, NZ},
+        /*12*/ ill,
+        /*13*/ ill,
+        /*14*/ ill,
+        /*15*/ {M::ORA, A::zpx, 4, 0, NZ},
+        /*16*/ {M::ASL, A::zpx, 6, 0, NZC},
+        /*17*/ ill,
+        /*18*/ {M::CLC, A::imp, 2, 0, Flag::C},
+        /*19*/ {M::ORA, A::aby, 4, 1, NZ},
+        /*1A*/ ill,
+        /*1B*/ ill,
+        /*1C*/ ill,
+        /*1D*/ {M::ORA, A::abx, 4, 1, NZ},
+        /*1E*/ {M::ASL, A::abx, 7, 0, NZC},
+        /*1F*/ ill,
+        /*2-*/
+        /*20*/ {M::JSR, A::abs, 6, 0, 0},
+        /*21*/ {M::AND, A::xin, 6, 0, NZ},
+        /*22*/ ill,
+        /*23*/ ill,
+        /*24*/ {M::BIT, A::zpg, 3, 0, NVZ},
+        /*25*/ {M::AND, A::zpg, 3, 0, NZ},
+        /*26*/ {M::ROL, A::zpg, 5, 0, NZC},
+        /*27*/ ill,
+        /*28*/ {M::PLP, A::imp, 4, 0, ALL},
+        /*29*/ {M::AND, A::imm, 2, 0, NZ},
+        /*2A*/ {M::ROL, A::imp, 2, 0, NZC},
+        /*2B*/ ill,
+        /*2C*/ {M::BIT, A::abs, 4, 0, NVZ},
+        /*2D*/ {M::AND, A::abs, 4, 0, NZ},
+        /*2E*/ {M::ROL, A::abs, 6, 0, NZC},
+        /*2F*/ ill,
+        /*3-*/
+        /*30*/ {M::BMI, A::rel, 2, 1, 0},
+        /*31*/ {M::AND, A::iny, 5, 1, NZ},
+        /*32*/ ill,
+        /*33*/ ill,
+        /*34*/ ill,
+        /*35*/ {M::AND, A::zpx, 4, 0, NZ},
+        /*36*/ {M::ROL, A::zpx, 6, 0, NZC},
+        /*37*/ ill,
+        /*38*/ {M::SEC, A::imp, 2, 0, Flag::C},
+        /*39*/ {M::AND, A::aby, 4, 1, NZ},
+        /*3A*/ ill,
+        /*3B*/ ill,
+        /*3C*/ ill,
+        /*3D*/ {M::AND, A::abx, 4, 1, NZ},
+        /*3E*/ {M::ROL, A::abx, 7, 0, NZC},
+        /*3F*/ ill,
+        /*4-*/
+        /*40*/ {M::RTI, A::imp, 6, 0, ALL},
+        /*41*/ {M::EOR, A::xin, 6, 0, NZ},
+        /*42*/ ill,
+        /*43*/ ill,
+        /*44*/ ill,
+        /*45*/ {M::EOR, A::zpg, 3, 0, NZ},
+        /*46*/ {M::LSR, A::zpg, 5, 0, NZC},
+        /*47*/ ill,
+        /*48*/ {M::PHA, A::imp, 3, 0, 0},
+        /*49*/ {M::EOR, A::imm, 2, 0, NZ},
+        /*4A*/ {M::LSR, A::imp, 2, 0, NZC},
+        /*4B*/ ill,
+        /*4C*/ {M::JMP, A::abs, 3, 0, 0},
+        /*4D*/ {M::EOR, A::abs, 4, 0, NZ},
+        /*4E*/ {M::LSR, A::abs, 6, 0, NZC},
+        /*4F*/ ill,
+        /*5-*/
+        /*50*/ {M::BVC, A::rel, 2, 1, 0},
+        /*51*/ {M::EOR, A::iny, 5, 1, NZ},
+        /*52*/ ill,
+        /*53*/ ill,
+        /*54*/ ill,
+        /*55*/ {M::EOR, A::zpx, 4, 0, NZ},
+        /*56*/ {M::LSR, A::zpx, 6, 0, NZC},
+        /*57*/ ill,
+        /*58*/ {M::CLI, A::imp, 2, 0, Flag::I},
+        /*59*/ {M::EOR, A::aby, 4, 1, NZ},
+        /*5A*/ ill,
+        /*5B*/ ill,
+        /*5C*/ ill,
+        /*5D*/ {M::EOR, A::abx, 4, 1, NZ},
+        /*5E*/ {M::LSR, A::abx, 7, 0, NZC},
+        /*5F*/ ill,
+        /*6-*/
+        /*60*/ {M::RTS, A::imp, 6, 0, 0},
+        /*61*/ {M::ADC, A::xin, 6, 0, NVZC},
+        /*62*/ ill,
+        /*63*/ ill,
+        /*64*/ ill,
+        /*65*/ {M::ADC, A::zpg, 3, 0, NVZC},
+        /*66*/ {M::ROR, A::zpg, 5, 0, NZC},
+        /*67*/ ill,
+        /*68*/ {M::PLA, A::imp, 4, 0, NZ},
+        /*69*/ {M::ADC, A::imm, 2, 0, NVZC},
+        /*6A*/ {M::ROR, A::imp, 2, 0, NZC},
+        /*6B*/ ill,
+        /*6C*/ {M::JMP, A::ind, 5, 0, 0},
+        /*6D*/ {M::ADC, A::abs, 4, 0, NVZC},
+        /*6E*/ {M::ROR, A::abs, 6, 0, NZC},
+        /*6F*/ ill,
+        /*7-*/
+        /*70*/ {M::BVS, A::rel, 2, 1, 0},
+        /*71*/ {M::ADC, A::iny, 5, 1, NVZC},
+        /*72*/ ill,
+        /*73*/ ill,
+        /*74*/ ill,
+        /*75*/ {M::ADC, A::zpx, 4, 0, NVZC},
+        /*76*/ {M::ROR, A::zpx, 6, 0, NZC},
+        /*77*/ ill,
+        /*78*/ {M::SEI, A::imp, 2, 0, Flag::I},
+        /*79*/ {M::ADC, A::aby, 4, 1, NVZC},
+        /*7A*/ ill,
+        /*7B*/ ill,
+        /*7C*/ ill,
+        /*7D*/ {M::ADC, A::abx, 4, 1, NVZC},
+        /*7E*/ {M::ROR, A::abx, 7, 0, NZC},
+        /*7F*/ ill,
+        /*8-*/
+        /*80*/ ill,
+        /*81*/ {M::STA, A::xin, 6, 0, 0},
+        /*82*/ ill,
+        /*83*/ ill,
+        /*84*/ {M::STY, A::zpg, 3, 0, 0},
+        /*85*/ {M::STA, A::zpg, 3, 0, 0},
+        /*86*/ {M::STX, A::zpg, 3, 0, 0},
+        /*87*/ ill,
+        /*88*/ {M::DEY, A::imp, 2, 0, NZ},
+        /*89*/ ill,
+        /*8A*/ {M::TXA, A::imp, 2, 0, NZ},
+        /*8B*/ ill,
+        /*8C*/ {M::STY, A::abs, 4, 0, 0},
+        /*8D*/ {M::STA, A::abs, 4, 0, 0},
+        /*8E*/ {M::STX, A::abs, 4, 0, 0},
+        /*8F*/ ill,
+        /*9-*/
+        /*90*/ {M::BCC, A::rel, 2, 1, 0},
+        /*91*/ {M::STA, A::iny, 6, 0, 0},
+        /*92*/ ill,
+        /*93*/ ill,
+        /*94*/ {M::STY, A::zpx, 4, 0, 0},
+        /*95*/ {M::STA, A::zpx, 4, 0, 0},
+        /*96*/ {M::STX, A::zpy, 4, 0, 0},
+        /*97*/ ill,
+        /*98*/ {M::TYA, A::imp, 2, 0, NZ},
+        /*99*/ {M::STA, A::aby, 5, 0, 0},
+        /*9A*/ {M::TXS, A::imp, 2, 0, 0},
+        /*9B*/ ill,
+        /*9C*/ ill,
+        /*9D*/ {M::STA, A::abx, 5, 0, 0},
+        /*9E*/ ill,
+        /*9F*/ ill,
+        /*A-*/
+        /*A0*/ {M::LDY, A::imm, 2, 0, NZ},
+        /*A1*/ {M::LDA, A::xin, 6, 0, NZ},
+        /*A2*/ {M::LDX, A::imm, 2, 0, NZ},
+        /*A3*/ ill,
+        /*A4*/ {M::LDY, A::zpg, 3, 0, NZ},
+        /*A5*/ {M::LDA, A::zpg, 3, 0, NZ},
+        /*A6*/ {M::LDX, A::zpg, 3, 0, NZ},
+        /*A7*/ ill,
+        /*A8*/ {M::TAY, A::imp, 2, 0, NZ},
+        /*A9*/ {M::LDA, A::imm, 2, 0, NZ},
+        /*AA*/ {M::TAX, A::imp, 2, 0, NZ},
+        /*AB*/ ill,
+        /*AC*/ {M::LDY, A::abs, 4, 0, NZ},
+        /*AD*/ {M::LDA, A::abs, 4, 0, NZ},
+        /*AE*/ {M::LDX, A::abs, 4, 0, NZ},
+        /*AF*/ ill,
+        /*B-*/
+        /*B0*/ {M::BCS, A::rel, 2, 1, 0},
+        /*B1*/ {M::LDA, A::iny, 5, 1, NZ},
+        /*B2*/ ill,
+        /*B3*/ ill,
+        /*B4*/ {M::LDY, A::zpx, 4, 0, NZ},
+        /*B5*/ {M::LDA, A::zpx, 4, 0, NZ},
+        /*B6*/ {M::LDX, A::zpy, 4, 0, NZ},
+        /*B7*/ ill,
+        /*B8*/ {M::CLV, A::imp, 2, 0, Flag::V},
+        /*B9*/ {M::LDA, A::aby, 4, 1, NZ},
+        /*BA*/ {M::TSX, A::imp, 2, 0, NZ},
+        /*BB*/ ill,
+        /*BC*/ {M::LDY, A::abx, 4, 1, NZ},
+        /*BD*/ {M::LDA, A::abx, 4, 1, NZ},
+        /*BE*/ {M::LDX, A::aby, 4, 1, NZ},
+        /*BF*/ ill,
+        /*C-*/
+        /*C0*/ {M::CPY, A::imm, 2, 0, NZC},
+        /*C1*/ {M::CMP, A::xin, 6, 0, NZC},
+        /*C2*/ ill,
+        /*C3*/ ill,
+        /*C4*/ {M::CPY, A::zpg, 3, 0, NZC},
+        /*C5*/ {M::CMP, A::zpg, 3, 0, NZC},
+        /*C6*/ {M::DEC, A::zpg, 5, 0, NZ},
+        /*C7*/ ill,
+        /*C8*/ {M::INY, A::imp, 2, 0, NZ},
+        /*C9*/ {M::CMP, A::imm, 2, 0, NZC},
+        /*CA*/ {M::DEX, A::imp, 2, 0, NZ},
+        /*CB*/ ill,
+        /*CC*/ {M::CPY, A::abs, 4, 0, NZC},
+        /*CD*/ {M::CMP, A::abs, 4, 0, NZC},
+        /*CE*/ {M::DEC, A::abs, 6, 0, NZ},
+        /*CF*/ ill,
+        /*D-*/
+        /*D0*/ {M::BNE, A::rel, 2, 1, 0},
+        /*D1*/ {M::CMP, A::iny, 5, 1, NZC},
+        /*D2*/ ill,
+        /*D3*/ ill,
+        /*D4*/ ill,
+        /*D5*/ {M::CMP, A::zpx, 4, 0, NZC},
+        /*D6*/ {M::DEC, A::zpx, 6, 0, NZ},
+        /*D7*/ ill,
+        /*D8*/ {M::CLD, A::imp, 2, 0, Flag::D},
+        /*D9*/ {M::CMP, A::aby, 4, 1, NZC},
+        /*DA*/ ill,
+        /*DB*/ ill,
+        /*DC*/ ill,
+        /*DD*/ {M::CMP, A::abx, 4, 1, NZC},
+        /*DE*/ {M::DEC, A::abx, 7, 0, NZ},
+        /*DF*/ ill,
+        /*E-*/
+        /*E0*/ {M::CPX, A::imm, 2, 0, NZC},
+        /*E1*/ {M::SBC, A::xin, 6, 0, NVZC},
+        /*E2*/ ill,
+        /*E3*/ ill,
+        /*E4*/ {M::CPX, A::zpg, 3, 0, NZC},
+        /*E5*/ {M::SBC, A::zpg, 3, 0, NVZC},
+        /*E6*/ {M::INC, A::zpg, 5, 0, NZ},
+        /*E7*/ ill,
+        /*E8*/ {M::INX, A::imp, 2, 0, NZ},
+        /*E9*/ {M::SBC, A::imm, 2, 0, NVZC},
+        /*EA*/ {M::NOP, A::imp, 2, 0, 0},
+        /*EB*/ ill,
+        /*EC*/ {M::CPX, A::abs, 4, 0, NZC},
+        /*ED*/ {M::SBC, A::abs, 4, 0, NVZC},
+        /*EE*/ {M::INC, A::abs, 6, 0, NZ},
+        /*EF*/ ill,
+        /*F-*/
+        /*F0*/ {M::BEQ, A::rel, 2, 1, 0},
+        /*F1*/ {M::SBC, A::iny, 5, 1, NVZC},
+        /*F2*/ ill,
+        /*F3*/ ill,
+        /*F4*/ ill,
+        /*F5*/ {M::SBC, A::zpx, 4, 0, NVZC},
+        /*F6*/ {M::INC, A::zpx, 6, 0, NZ},
+        /*F7*/ ill,
+        /*F8*/ {M::SED, A::imp, 2, 0, Flag::D},
+        /*F9*/ {M::SBC, A::aby, 4, 1, NVZC},
+        /*FA*/ ill,
+        /*FB*/ ill,
+        /*FC*/ ill,
+        /*FD*/ {M::SBC, A::abx, 4, 1, NVZC},
+        /*FE*/ {M::INC, A::abx, 7, 0, NZ},
+        /*FF*/ ill
+    }};
+
+    if constexpr (Variant::cmos) {
+        t[0x04] = {M::TSB, A::zpg, 5, 0, Flag::Z};
+        t[0x0C] = {M::TSB, A::abs, 6, 0, Flag::Z};
+        t[0x12] = {M::ORA, A::izp, 5, 0, NZ};
+        t[0x14] = {M::TRB, A::zpg, 5, 0, Flag::Z};
+        t[0x1A] = {M::INC, A::imp, 2, 0, NZ};
+        t[0x1C] = {M::TRB, A::abs, 6, 0, Flag::Z};
+        t[0x1E] = {M::ASL, A::abx, 6, 1, NZC};
+        t[0x32] = {M::AND, A::izp, 5, 0, NZ};
+        t[0x34] = {M::BIT, A::zpx, 4, 0, NVZ};
+        t[0x3A] = {M::DEC, A::imp, 2, 0, NZ};
+        t[0x3C] = {M::BIT, A::abx, 4, 1, NVZ};
+        t[0x3E] = {M::ROL, A::abx, 6, 1, NZC};
+        t[0x52] = {M::EOR, A::izp, 5, 0, NZ};
+        t[0x5A] = {M::PHY, A::imp, 3, 0, 0};
+        t[0x5E] = {M::LSR, A::abx, 6, 1, NZC};
+        t[0x64] = {M::STZ, A::zpg, 3, 0, 0};
+        t[0x6C] = {M::JMP, A::ind, 6, 0, 0};
+        t[0x72] = {M::ADC, A::izp, 5, 0, NVZC};
+        t[0x74] = {M::STZ, A::zpx, 4, 0, 0};
+        t[0x7A] = {M::PLY, A::imp, 4, 0, NZ};
+        t[0x7C] = {M::JMP, A::axi, 6, 0, 0};
+        t[0x7E] = {M::ROR, A::abx, 6, 1, NZC};
+        t[0x80] = {M::BRA, A::rel, 2, 1, 0};
+        t[0x89] = {M::BIT, A::imm, 2, 0, Flag::Z};
+        t[0x92] = {M::STA, A::izp, 5, 0, 0};
+        t[0x9C] = {M::STZ, A::abs, 4, 0, 0};
+        t[0x9E] = {M::STZ, A::abx, 5, 0, 0};
+        t[0xB2] = {M::LDA, A::izp, 5, 0, NZ};
+        t[0xD2] = {M::CMP, A::izp, 5, 0, NZC};
+        t[0xDA] = {M::PHX, A::imp, 3, 0, 0};
+        t[0xF2] = {M::SBC, A::izp, 5, 0, NVZC};
+        t[0xFA] = {M::PLX, A::imp, 4, 0, NZ};
+        t[0x00] = {M::BRK, A::imp, 7, 0, Flag::D|Flag::I};
+
+        //The other undefined opcodes are NOPs of fixed length and timing
+        for(unsigned opcode : {0x02, 0x22, 0x42, 0x62, 0x82, 0xC2, 0xE2}) {
+            t[opcode] = {M::NOP, A::imm, 2, 0, 0};
+        }
+        for(unsigned opcode = 0x03; opcode < 0x100; opcode += 4) {
+            //x3, x7, xB and xF
+            t[opcode] = {M::NOP, A::imp, 1, 0, 0};
+        }
+        t[0x44] = {M::NOP, A::zpg, 3, 0, 0};
+        t[0x54] = {M::NOP, A::zpx, 4, 0, 0};
+        t[0xD4] = {M::NOP, A::zpx, 4, 0, 0};
+        t[0xF4] = {M::NOP, A::zpx, 4, 0, 0};
+        t[0x5C] = {M::NOP, A::abs, 8, 0, 0};
+        t[0xDC] = {M::NOP, A::abs, 4, 0, 0};
+        t[0xFC] = {M::NOP, A::abs, 4, 0, 0};
+    }
+
+    return t;
+}
+
+template<class Variant>
+inline constexpr InstructionTable INSTRUCTIONS = makeInstructionTable<Variant>();
+
+#endif
@@ -1,4 +1,5 @@
 #include "MOS6502.h"
+#include "Operations.h"
 #include <sstream>
 #include <iomanip>
 #include <chrono>
@@ -7,54 +8,143 @@
 using BYTE = uint8_t;
 using WORD = uint16_t;
 
-MOS6502::MOS6502(fWrite const & w, fRead const & r):
-    memoryWrite{w}, memoryRead{r}
+template<class Variant>
+MOS6502Core<Variant>::MOS6502Core(fWrite const & w, fRead const & r):
+    memoryWrite{w}, memoryRead{r}, pages{&flatPages}
 {
     reset();
 }
 
-void MOS6502::IRQ() {
+template<class Variant>
+MOS6502Core<Variant>::MOS6502Core(uint8_t* memory):
+    memoryWrite{[memory](uint16_t addr, uint8_t data) { memory[addr] = data; }},
+    memoryRead{[memory](uint16_t addr) { return memory[addr]; }},
+    pages{&flatPages}
+{
+    for(std::size_t i = 0; i < PageTable::PAGES; ++i) {
+        flatPages.read[i] = flatPages.write[i] = memory + i*PageTable::PAGE_SIZE;
+    }
+    reset();
+}
+
+template<class Variant>
+MOS6502Core<Variant>::MOS6502Core(PageTable const & pages, fWrite const & w, fRead const & r):
+    memoryWrite{w}, memoryRead{r}, pages{&pages}
+{
+    reset();
+}
+
+template<class Variant>
+MOS6502Core<Variant>::MOS6502Core(PageTable const & pages):
+    MOS6502Core(pages, [](uint16_t, uint8_t) {}, [](uint16_t) { return uint8_t{0xff}; })
+{}
+
+template<class Variant>
+void MOS6502Core<Variant>::IRQ() {
     if(SR[IF] != 1) {
         waitForCycles(7);
-        push(PC/(16*16));
-        push(PC);
-        push(SR.to_ulong());
-        PC = memoryRead(0xffff)*16*16+memoryRead(0xfffe);
-        SR[IF] = 1;
+        if(hooks) interrupt<ToolingHooks>(0xfffe, false);
+        else      interrupt<NoHooks>(0xfffe, false);
     }
 }
-void MOS6502::NMI() {
+template<class Variant>
+void MOS6502Core<Variant>::NMI() {
     waitForCycles(7);
-    push(PC/(16*16));
-    push(PC);
-    push(SR.to_ulong());
-    PC = memoryRead(0xfffb)*16*16+memoryRead(0xfffa);
-    SR[IF] = 1;
+    if(hooks) interrupt<ToolingHooks>(0xfffa, false);
+    else      interrupt<NoHooks>(0xfffa, false);
 }
 
-void MOS6502::reset() {
+template<class Variant>
+void MOS6502Core<Variant>::reset() {
     PC = 0x0000; AC = 0x00; X  = 0x00;
     Y  = 0x00;   SR = 0x20; SP = 0xff;
 }
 
-void MOS6502::execute(WORD init_PC, WORD end_PC) {
+template<class Variant>
+void MOS6502Core<Variant>::execute(WORD init_PC, WORD end_PC) {
     PC = init_PC;
 
+    //run() returns true when setHooks() switched the hook policy
+    while(hooks ? run<ToolingHooks>(end_PC) : run<NoHooks>(end_PC)) {}
+}
+
+template<class Variant>
+template<class Hooks>
+bool MOS6502Core<Variant>::run(WORD end_PC) {
     while(PC <= end_PC) {
+        //Devices (a single comparison when no event is due)
+        if(cycles >= events.nextCycle() && serviceEvents<Hooks>()) {
+            continue;
+        }
+
         // Debugging
         if(breakpoint != 0 && PC == breakpoint) {
             break;
         }
 
+        if constexpr (Hooks::enabled) {
+            hookedStep();
+            if(!hooks) return true;
+            continue;
+        }
+
+        //High-level emulation (the only code that can call setHooks())
+        if(trapMap[PC]) {
+            callTrap();
+            if(hooks) return true;
+            continue;
+        }
+
         //Fetch instruction from memory
-        BYTE inst{memoryRead(PC++)};
+        BYTE inst{fetch<Hooks>()};
 
         //Execute
-        callOpCode(inst);
+        callOpCode<Hooks>(inst);
     }
+    return false;
 }
 
-std::string MOS6502::info() const {
+template<class Variant>
+void MOS6502Core<Variant>::step() {
+    //Taking an IRQ counts as a step
+    if(cycles >= events.nextCycle() &&
+       (hooks ? serviceEvents<ToolingHooks>() : serviceEvents<NoHooks>())) {
+        return;
+    }
+
+    if(hooks) {
+        hookedStep();
+        return;
+    }
+
+    //High-level emulation
+    if(trapMap[PC]) {
+        callTrap();
+        return;
+    }
+
+    //Fetch instruction from memory
+    BYTE inst{fetch<NoHooks>()};
+
+    //Execute
+    callOpCode<NoHooks>(inst);
+}
+
+template<class Variant>
+void MOS6502Core<Variant>::runUntil(uint64_t end, std::bitset<0x10000> const & stops, uint64_t& steps) {
+    while(cycles < end && cycles < events.nextCycle() && !stops[PC]) {
+        if(hooks || trapMap[PC]) {
+            step();
+        } else {
+            BYTE inst{fetch<NoHooks>()};
+            callOpCode<NoHooks>(inst);
+        }
+        ++steps;
+    }
+}
+
+template<class Variant>
+std::string MOS6502Core<Variant>::info() const {
     std::ostringstream out;
 
     out << "SR:" << std::setw(8) << SR << " | "
@@ -69,122 +159,277 @@ std::string MOS6502::info() const {
 }
 
 // TODO: make possible to add more than one breakpoint
-void MOS6502::setBreakpoint(uint16_t addr) {
+template<class Variant>
+void MOS6502Core<Variant>::setBreakpoint(uint16_t addr) {
     this->breakpoint = addr;
 }
 
+/**** High-level emulation ****/
+template<class Variant>
+void MOS6502Core<Variant>::setTrap(uint16_t addr, fTrap const & handler, uint32_t cycles) {
+    traps[addr] = Trap{handler, cycles};
+    trapMap[addr] = 1;
+}
+
+template<class Variant>
+void MOS6502Core<Variant>::removeTrap(uint16_t addr) {
+    traps.erase(addr);
+    trapMap[addr] = 0;
+}
+
+template<class Variant>
+Scheduler& MOS6502Core<Variant>::scheduler() {
+    return events;
+}
+
+/**** Hooks ****/
+template<class Variant>
+void MOS6502Core<Variant>::setHooks(CPUHooks* hooks) {
+    this->hooks = hooks;
+}
+
+template<class Variant>
+CPUState MOS6502Core<Variant>::getState() const {
+    return CPUState{PC, AC, X, Y, static_cast<uint8_t>(SR.to_ulong()), SP, cycles};
+}
+
+template<class Variant>
+void MOS6502Core<Variant>::setState(CPUState const & state) {
+    PC = state.PC; AC = state.AC; X = state.X;
+    Y = state.Y;   SR = state.SR; SP = state.SP;
+    cycles = state.cycles;
+}
+
+template<class Variant>
+void MOS6502Core<Variant>::hookedStep() {
+    //Decode without reporting the accesses
+    DecodedInstruction decoded;
+    decoded.PC = PC;
+    decoded.opcode = readMemory(PC);
+    decoded.info = INSTRUCTIONS<Variant>[decoded.opcode];
+    for(uint8_t i = 1; i < instructionLength(decoded.info.mode); ++i) {
+        decoded.operand[i-1] = readMemory(static_cast<WORD>(PC+i));
+    }
+
+    CPUHooks& h{*hooks};
+    h.preInstruction(decoded, getState());
+
+    if(trapMap[PC]) {
+        callTrap();
+    } else {
+        BYTE inst{fetch<ToolingHooks>()};
+        callOpCode<ToolingHooks>(inst);
+    }
+
+    //Reported to the same hooks even if a trap called setHooks()
+    h.postInstruction(decoded, getState());
+}
+
+template<class Variant>
+void MOS6502Core<Variant>::callTrap() {
+    Trap const & trap = traps.find(PC)->second;
+    trap.handler(*this);
+    waitForCycles(trap.cycles);
+    //Return to the caller (the handler may have called setHooks())
+    if(hooks) operation<0x60, ToolingHooks>(0, false);
+    else      operation<0x60, NoHooks>(0, false);
+}
+/********************************/
+
 /**** Getter and Setter ****/
-void MOS6502::setPC(uint16_t PC) {
+template<class Variant>
+void MOS6502Core<Variant>::setPC(uint16_t PC) {
     this->PC = PC;
 }
 
-void MOS6502::setAC(uint8_t AC) {
+template<class Variant>
+void MOS6502Core<Variant>::setAC(uint8_t AC) {
     this->AC = AC;
 }
 
-void MOS6502::setX(uint8_t X) {
+template<class Variant>
+void MOS6502Core<Variant>::setX(uint8_t X) {
     this->X = X;
 }
 
-void MOS6502::setY(uint8_t Y) {
+template<class Variant>
+void MOS6502Core<Variant>::setY(uint8_t Y) {
     this->Y = Y;
 }
 
-void MOS6502::setSR(uint8_t SR) {
+template<class Variant>
+void MOS6502Core<Variant>::setSR(uint8_t SR) {
     this->SR = SR;
 }
 
-void MOS6502::setSP(uint8_t SP) {
+template<class Variant>
+void MOS6502Core<Variant>::setSP(uint8_t SP) {
     this->SP = SP;
 }
 
 
-uint16_t MOS6502::getPC() const {
+template<class Variant>
+uint16_t MOS6502Core<Variant>::getPC() const {
     return PC;
 }
 
-uint8_t MOS6502::getAC() const {
+template<class Variant>
+uint8_t MOS6502Core<Variant>::getAC() const {
     return AC;
 }
 
-uint8_t MOS6502::getX() const {
+template<class Variant>
+uint8_t MOS6502Core<Variant>::getX() const {
     return X;
 }
 
-uint8_t MOS6502::getY() const {
+template<class Variant>
+uint8_t MOS6502Core<Variant>::getY() const {
     return Y;
 }
 
-uint8_t MOS6502::getSR() const {
+template<class Variant>
+uint8_t MOS6502Core<Variant>::getSR() const {
     return SR.to_ulong();
 }
 
-uint8_t MOS6502::getSP() const {
+template<class Variant>
+uint8_t MOS6502Core<Variant>::getSP() const {
     return SP;
 }
+
+template<class Variant>
+uint64_t MOS6502Core<Variant>::getCycles() const {
+    return cycles;
+}
 /***************************/
 
 
 /**** Addressing Modes  ****/
-uint16_t MOS6502::absolute() {
-    BYTE LB = memoryRead(PC++);
-    BYTE HB = memoryRead(PC++);
+template<class Variant>
+template<AddrMode mode, class Hooks>
+uint16_t MOS6502Core<Variant>::effectiveAddress(bool& page_crossed) {
+    if constexpr (mode == AddrMode::imp) return 0;
+    else if constexpr (mode == AddrMode::imm) return PC++;
+    else if constexpr (mode == AddrMode::zpg) return zeropage<Hooks>();
+    else if constexpr (mode == AddrMode::zpx) return zeropageX<Hooks>();
+    else if constexpr (mode == AddrMode::zpy) return zeropageY<Hooks>();
+    else if constexpr (mode == AddrMode::abs) return absolute<Hooks>();
+    else if constexpr (mode == AddrMode::abx) return absoluteX<Hooks>(page_crossed);
+    else if constexpr (mode == AddrMode::aby) return absoluteY<Hooks>(page_crossed);
+    else if constexpr (mode == AddrMode::ind) return indirect<Hooks>();
+    else if constexpr (mode == AddrMode::xin) return Xindirect<Hooks>();
+    else if constexpr (mode == AddrMode::iny) return indirectY<Hooks>(page_crossed);
+    else if constexpr (mode == AddrMode::rel) return relative<Hooks>(page_crossed);
+    else if constexpr (mode == AddrMode::izp) return zeropageIndirect<Hooks>();
+    else if constexpr (mode == AddrMode::axi) return absoluteXindirect<Hooks>();
+}
+
+template<class Variant>
+template<class Hooks>
+uint16_t MOS6502Core<Variant>::absolute() {
+    BYTE LB = fetch<Hooks>();
+    BYTE HB = fetch<Hooks>();
     return (HB*16*16+LB);
 }
 
-uint16_t MOS6502::absoluteX(bool& page_crossed) {
-    BYTE LB = memoryRead(PC++);
-    BYTE HB = memoryRead(PC++);
+template<class Variant>
+template<class Hooks>
+uint16_t MOS6502Core<Variant>::absoluteX(bool& page_crossed) {
+    BYTE LB = fetch<Hooks>();
+    BYTE HB = fetch<Hooks>();
     page_crossed = (static_cast<uint8_t>(LB+X) < LB);
     return (HB*16*16+LB)+X;
 }
 
-uint16_t MOS6502::absoluteY(bool& page_crossed) {
-    BYTE LB = memoryRead(PC++);
-    BYTE HB = memoryRead(PC++);
+template<class Variant>
+template<class Hooks>
+uint16_t MOS6502Core<Variant>::absoluteY(bool& page_crossed) {
+    BYTE LB = fetch<Hooks>();
+    BYTE HB = fetch<Hooks>();
     page_crossed = (static_cast<uint8_t>(LB+Y) < LB);
     return (HB*16*16+LB)+Y;
 }
 
-uint16_t MOS6502::indirect() {
-    BYTE LB = memoryRead(PC++);
-    BYTE HB = memoryRead(PC++);
+template<class Variant>
+template<class Hooks>
+uint16_t MOS6502Core<Variant>::indirect() {
+    BYTE LB = fetch<Hooks>();
+    BYTE HB = fetch<Hooks>();
 
     WORD target = HB*16*16+LB;
 
-    BYTE LB_effective = memoryRead(target);
-    BYTE HB_effective = memoryRead(target+1);
+    BYTE LB_effective = read<Hooks>(target);
+    BYTE HB_effective;
+    if constexpr (Variant::jmpIndirectPageWrap) {
+        //NMOS bug: (target+1) does not carry into the high byte
+        HB_effective = read<Hooks>(HB*16*16+static_cast<uint8_t>(LB+1));
+    } else {
+        HB_effective = read<Hooks>(target+1);
+    }
 
     return HB_effective*16*16+LB_effective;
 }
 
-uint16_t MOS6502::Xindirect() {
-    BYTE LB = memoryRead(PC++);
+template<class Variant>
+template<class Hooks>
+uint16_t MOS6502Core<Variant>::Xindirect() {
+    BYTE LB = fetch<Hooks>();
 
     //target remain in zeropage
     BYTE target = LB + X;
 
-    BYTE LB_effective = memoryRead(target);
+    BYTE LB_effective = read<Hooks>(target);
     //(target+1) remain in zeropage
-    BYTE HB_effective = memoryRead(static_cast<uint8_t>(target+1));
+    BYTE HB_effective = read<Hooks>(static_cast<uint8_t>(target+1));
 
     return HB_effective*16*16+LB_effective;
 }
 
-uint16_t MOS6502::indirectY(bool& page_crossed) {
-    BYTE LB = memoryRead(PC++);
+template<class Variant>
+template<class Hooks>
+uint16_t MOS6502Core<Variant>::indirectY(bool& page_crossed) {
+    BYTE LB = fetch<Hooks>();
 
-    BYTE LB_effective = memoryRead(LB);
+    BYTE LB_effective = read<Hooks>(LB);
     //(LB+1) remain in zeropage
-    BYTE HB_effective = memoryRead(static_cast<uint8_t>(LB+1));
+    BYTE HB_effective = read<Hooks>(static_cast<uint8_t>(LB+1));
 
     page_crossed = (static_cast<uint8_t>(LB_effective+Y) < LB_effective);
 
     return (HB_effective*16*16+LB_effective)+Y;
 }
 
-uint16_t MOS6502::relative(bool& page_crossed) {
-    BYTE REL = memoryRead(PC++);
+template<class Variant>
+template<class Hooks>
+uint16_t MOS6502Core<Variant>::zeropageIndirect() {
+    BYTE LB = fetch<Hooks>();
+
+    BYTE LB_effective = read<Hooks>(LB);
+    //(LB+1) remain in zeropage
+    BYTE HB_effective = read<Hooks>(static_cast<uint8_t>(LB+1));
+
+    return HB_effective*16*16+LB_effective;
+}
+
+template<class Variant>
+template<class Hooks>
+uint16_t MOS6502Core<Variant>::absoluteXindirect() {
+    BYTE LB = fetch<Hooks>();
+    BYTE HB = fetch<Hooks>();
+
+    WORD target = HB*16*16+LB+X;
+
+    BYTE LB_effective = read<Hooks>(target);
+    BYTE HB_effective = read<Hooks>(static_cast<uint16_t>(target+1));
+
+    return HB_effective*16*16+LB_effective;
+}
+
+template<class Variant>
+template<class Hooks>
+uint16_t MOS6502Core<Variant>::relative(bool& page_crossed) {
+    BYTE REL = fetch<Hooks>();
 
     WORD effective_address;
 
@@ -208,46 +453,46 @@ uint16_t MOS6502::relative(bool& page_crossed) {
     return effective_address;
 }
 
-uint8_t MOS6502::zeropage() {
-    return memoryRead(PC++);
+template<class Variant>
+template<class Hooks>
+uint8_t MOS6502Core<Variant>::zeropage() {
+    return fetch<Hooks>();
 }
 
-uint8_t MOS6502::zeropageX() {
+template<class Variant>
+template<class Hooks>
+uint8_t MOS6502Core<Variant>::zeropageX() {
     //remain in zeropage
-    return memoryRead(PC++) + X;
+    return fetch<Hooks>() + X;
 }
 
-uint8_t MOS6502::zeropageY() {
+template<class Variant>
+template<class Hooks>
+uint8_t MOS6502Core<Variant>::zeropageY() {
     //remain in zeropage
-    return memoryRead(PC++) + Y;
+    return fetch<Hooks>() + Y;
 }
 /***************************/
 
 /**** Utility ****/
-void MOS6502::callOpCode(BYTE index) {
-    (this->*OPCODES[index])();
+template<class Variant>
+template<class Hooks>
+void MOS6502Core<Variant>::callOpCode(BYTE index) {
+    (this->*OPCODES<Hooks>[index])();
 }
 
-void MOS6502::waitForCycles(BYTE c) {
-    #ifndef _NO_DELAY_
+template<class Variant>
+void MOS6502Core<Variant>::waitForCycles(uint32_t c) {
     cycles += c;
+    #ifndef _NO_DELAY_
     std::this_thread::sleep_for(std::chrono::nanoseconds(500*c));
     #endif
 }
 /*****************/
 
-/**** Stack Operations ****/
-void MOS6502::push(uint8_t data) {
-    memoryWrite(0x0100+(SP--), data);
-}
-
-uint8_t MOS6502::pull() {
-    return memoryRead(0x0100+(++SP));
-}
-/**************************/
-
 /**** Comparison ****/
-void MOS6502::compareRM(uint8_t reg, uint8_t memory) {
+template<class Variant>
+void MOS6502Core<Variant>::compareRM(uint8_t reg, uint8_t memory) {
     if(reg < memory) {
         SR[ZF] = 0;
         SR[CF] = 0;
@@ -266,26 +511,25 @@ void MOS6502::compareRM(uint8_t reg, uint8_t memory) {
 /********************/
 
 /**** Addition and Subtraction ****/
-void MOS6502::addWithCarry(uint8_t memory) {
-    if(SR[DF] == 0) { //Binary Mode
-        //The result is saved on a 16 bits unsigned integer (WORD) to check
-        //for a possible carry
-        WORD tmp = AC + memory + SR[CF];
-        //Overflow check (if AC and memory have the same sign, but tmp don't => overflow)
-        SR[VF] = (AC^static_cast<uint8_t>(tmp))&(memory^static_cast<uint8_t>(tmp))&(1U<<7);
-        // | Downcast to 8 bits
-        // v
-        AC = tmp;
-        SR[ZF] = (AC==0);
-        SR[NF] = (AC & (1U<<7));
-        //Carry check
-        SR[CF] = (tmp & (1U<<8));
-    } else { //Decimal Mode
-        //To be implemented
+template<class Variant>
+void MOS6502Core<Variant>::addWithCarry(uint8_t memory) {
+    if constexpr (Variant::decimalMode) {
+        if(SR[DF] == 1) { //Decimal Mode
+            addDecimal(memory);
+            return;
+        }
     }
+    addBinary(memory);
 }
 
-void MOS6502::subWithBorrow(uint8_t memory) {
+template<class Variant>
+void MOS6502Core<Variant>::subWithBorrow(uint8_t memory) {
+    if constexpr (Variant::decimalMode) {
+        if(SR[DF] == 1) { //Decimal Mode
+            subDecimal(memory);
+            return;
+        }
+    }
     /*
      How does it work?
       1. In two's complement a negative number is obtained
@@ -300,982 +544,121 @@ void MOS6502::subWithBorrow(uint8_t memory) {
       3. So, basically an ADC with ~memory in place of
          memory.
     */
-    addWithCarry(~memory);
-}
-/********************************/
-
-/**** Istructions ****/
-void MOS6502::BRKimp() { //
-    waitForCycles(7);
-
-    //Push HB first
-    push((PC+1)/(16*16));
-    //Push LB
-    push(PC+1);
-    //Set Bflag
-    SR[BF] = 1;
-    //Push Status register
-    push(SR.to_ulong());
-    //Unset BFlag (BFlag must be set only in the copy of the SR into the stack)
-    SR[BF] = 0;
-    //Modify the program counter to jump at the istruction poninted by the IRQ vector
-    PC = memoryRead(0xffff)*16*16+memoryRead(0xfffe);
-        /*     HB      */      /*     LB      */
-    //Set the IFlag
-    SR[IF] = 1;
-}
-void MOS6502::ORAxin() { //
-    waitForCycles(6);
-    ORA(Xindirect());
-}
-void MOS6502::ORAzpg() { //
-    waitForCycles(3);
-    ORA(zeropage());
-}
-void MOS6502::ASLzpg() { //
-    waitForCycles(5);
-    ASL(zeropage());
-} 
-void MOS6502::PHPimp() { //
-    waitForCycles(3);
-    BYTE tmpBF{SR[BF]};
-    SR[BF] = 1;
-    push(SR.to_ulong());
-    SR[BF] = tmpBF;
-}
-void MOS6502::ORAimm() { //
-    waitForCycles(2);
-    ORA(PC++);
-} 
-void MOS6502::ASLimp() { //
-    waitForCycles(2);
-    SR[CF] = (AC & (1U<<7));
-    AC*=2;
+    addBinary(~memory);
+}
+
+template<class Variant>
+void MOS6502Core<Variant>::addBinary(uint8_t memory) {
+    //The result is saved on a 16 bits unsigned integer (WORD) to check
+    //for a possible carry
+    WORD tmp = AC + memory + SR[CF];
+    //Overflow check (if AC and memory have the same sign, but tmp don't => overflow)
+    SR[VF] = (AC^static_cast<uint8_t>(tmp))&(memory^static_cast<uint8_t>(tmp))&(1U<<7);
+    // | Downcast to 8 bits
+    // v
+    AC = tmp;
     SR[ZF] = (AC==0);
     SR[NF] = (AC & (1U<<7));
-}
-void MOS6502::ORAabs() { //
-    waitForCycles(4);
-    ORA(absolute());
-} 
-void MOS6502::ASLabs() {
-    waitForCycles(6);
-    ASL(absolute());
+    //Carry check
+    SR[CF] = (tmp & (1U<<8));
 }
 
-void MOS6502::BPLrel() { //
-    waitForCycles(2);
-    bool page_cross{false};
+//http://www.6502.org/tutorials/decimal_mode.html (Appendix A)
+template<class Variant>
+void MOS6502Core<Variant>::addDecimal(uint8_t memory) {
+    int carry = SR[CF];
 
-    if(SR[NF] == 0) {
-        PC = relative(page_cross);
-        if(page_cross) {
-            waitForCycles(2);
-        } else {
-            waitForCycles(1);
-        }
-    } else {
-        ++PC;
+    //Low nibble, adjusted if it is not a valid BCD digit
+    int lo = (AC & 0x0f) + (memory & 0x0f) + carry;
+    if(lo >= 0x0a) {
+        lo = ((lo + 0x06) & 0x0f) + 0x10;
     }
-}
-void MOS6502::ORAiny() { //
-    bool page_cross{false};
-    WORD effective_address{indirectY(page_cross)};
-    if(page_cross) waitForCycles(6);
-    else           waitForCycles(5);
-    ORA(effective_address);
-} 
-void MOS6502::ORAzpx() { //
-    waitForCycles(4);
-    ORA(zeropageX());
-}
-void MOS6502::ASLzpx() { //
-    waitForCycles(6);
-    ASL(zeropageX());
-} 
-void MOS6502::CLCimp() { //
-    waitForCycles(2);
-    SR[CF] = 0;
-}
-void MOS6502::ORAaby() { //
-    bool page_cross{false};
-    WORD effective_address{absoluteY(page_cross)};
-    if(page_cross) waitForCycles(5);
-    else           waitForCycles(4);
-    ORA(effective_address);
-} 
-void MOS6502::ORAabx() { //
-    bool page_cross{false};
-    WORD effective_address{absoluteX(page_cross)};
-    if(page_cross) waitForCycles(5);
-    else           waitForCycles(4);
-    ORA(effective_address);
-}
-void MOS6502::ASLabx() { //
-    waitForCycles(7);
-    bool page_cross;
-    ASL(absoluteX(page_cross));
-}
-
-void MOS6502::JSRabs() { //
-    waitForCycles(6);
-    push((PC+1)/(16*16)); //push HB first
-    push(PC+1);           //push LB
-    PC = absolute();
-}
-void MOS6502::ANDxin() { //
-    waitForCycles(6);
-    AND(Xindirect());
-} 
-void MOS6502::BITzpg() { //
-    waitForCycles(3);
-    BIT(zeropage());
-}
-void MOS6502::ANDzpg() { //
-    waitForCycles(3);
-    AND(zeropage());
-} 
-void MOS6502::ROLzpg() { //
-    waitForCycles(5);
-    ROL(zeropage());
-}
-void MOS6502::PLPimp() { //
-    waitForCycles(4);
-
-    BYTE tmpBF{SR[BF]};
-    BYTE tmpBit5{SR[5]};
-    SR = pull();
-    //ignore break flag
-    SR[BF] = tmpBF;
-    //ignore bit 5
-    SR[5] = tmpBit5;
-} 
-void MOS6502::ANDimm() { //
-    waitForCycles(2);
-    AND(PC++);
-}
-void MOS6502::ROLimp() { //
-    waitForCycles(2);
-    BYTE tmpCF{SR[CF]};
-    SR[CF] = (AC & (1U<<7));
-    AC <<= 1;
-    AC+=tmpCF;
-    SR[ZF] = (AC==0);
-    SR[NF] = (AC & (1U<<7));
-} 
-void MOS6502::BITabs() { //
-    waitForCycles(4);
-    BIT(absolute());
-}
-void MOS6502::ANDabs() { //
-    waitForCycles(4);
-    AND(absolute());
-} 
-void MOS6502::ROLabs() { //
-    waitForCycles(6);
-    ROL(absolute());
-}
 
-void MOS6502::BMIrel() { //
-    waitForCycles(2);
-    bool page_cross{false};
-
-    if(SR[NF] == 1) {
-        PC = relative(page_cross);
-        if(page_cross) {
-            waitForCycles(2);
-        } else {
-            waitForCycles(1);
-        }
-    } else {
-        ++PC;
+    //N and V are computed on the signed intermediate result
+    int sresult = static_cast<int8_t>(AC & 0xf0) + static_cast<int8_t>(memory & 0xf0) + lo;
+    int result = (AC & 0xf0) + (memory & 0xf0) + lo;
+    if(result >= 0xa0) {
+        result += 0x60;
     }
-}
-void MOS6502::ANDiny() { //
-    bool page_cross{false};
-    WORD effective_address{indirectY(page_cross)};
-    if(page_cross) waitForCycles(6);
-    else           waitForCycles(5);
-    AND(effective_address);
-} 
-void MOS6502::ANDzpx() { //
-    waitForCycles(4);
-    AND(zeropageX());
-}
-void MOS6502::ROLzpx() { //
-    waitForCycles(6);
-    ROL(zeropageX());
-}
-void MOS6502::SECimp() { //
-    waitForCycles(2);
-    SR[CF] = 1;
-}
-void MOS6502::ANDaby() { //
-    bool page_cross{false};
-    WORD effective_address{absoluteY(page_cross)};
-    if(page_cross) waitForCycles(5);
-    else           waitForCycles(4);
-    AND(effective_address);
-} 
-void MOS6502::ANDabx() { //
-    bool page_cross{false};
-    WORD effective_address{absoluteX(page_cross)};
-    if(page_cross) waitForCycles(5);
-    else           waitForCycles(4);
-    AND(effective_address);
-}
-void MOS6502::ROLabx() { //
-    waitForCycles(7);
-    bool page_cross;
-    ROL(absoluteX(page_cross));
-}
 
-void MOS6502::RTIimp() { //
-    waitForCycles(6);
+    SR[VF] = (sresult < -128 || sresult > 127);
+    SR[CF] = (result >= 0x100);
 
-    BYTE tmpBF{SR[BF]};
-    SR = pull();
-    SR[BF] = tmpBF;
-
-    BYTE LB{pull()};
-    BYTE HB{pull()};
-    PC = HB*16*16+LB;
-}
-void MOS6502::EORxin() { //
-    waitForCycles(6);
-    EOR(Xindirect());
-} 
-void MOS6502::EORzpg() { //
-    waitForCycles(3);
-    EOR(zeropage());
-}
-void MOS6502::LSRzpg() { //
-    waitForCycles(5);
-    LSR(zeropage());
-} 
-void MOS6502::PHAimp() { //
-    waitForCycles(3);
-    push(AC);
-}
-void MOS6502::EORimm() { //
-    waitForCycles(2);
-    EOR(PC++);
-} 
-void MOS6502::LSRimp() { //
-    waitForCycles(2);
-    SR[CF] = (AC & 1U);
-    AC/=2;
-    SR[ZF] = (AC==0);
-    SR[NF] = 0;
-}
-void MOS6502::JMPabs() { //
-    waitForCycles(3);
-    PC = absolute();
-} 
-void MOS6502::EORabs() { //
-    waitForCycles(4);
-    EOR(absolute());
-}
-void MOS6502::LSRabs() { //
-    waitForCycles(6);
-    LSR(absolute());
-}
-
-void MOS6502::BVCrel() { //
-    waitForCycles(2);
-    bool page_cross{false};
-
-    if(SR[VF] == 0) {
-        PC = relative(page_cross);
-        if(page_cross) {
-            waitForCycles(2);
-        } else {
-            waitForCycles(1);
-        }
-    } else {
-        ++PC;
-    }
-}
-void MOS6502::EORiny() { //
-    bool page_cross{false};
-    WORD effective_address{indirectY(page_cross)};
-    if(page_cross) waitForCycles(6);
-    else           waitForCycles(5);
-    EOR(effective_address);  
-} 
-void MOS6502::EORzpx() { //
-    waitForCycles(4);
-    EOR(zeropageX());
-}
-void MOS6502::LSRzpx() { //
-    waitForCycles(6);
-    LSR(zeropageX());
-} 
-void MOS6502::CLIimp() { //
-    waitForCycles(2);
-    SR[IF] = 0;
-}
-void MOS6502::EORaby() { //
-    bool page_cross{false};
-    WORD effective_address{absoluteY(page_cross)};
-    if(page_cross) waitForCycles(5);
-    else           waitForCycles(4);
-    EOR(effective_address);
-} 
-void MOS6502::EORabx() { //
-    bool page_cross{false};
-    WORD effective_address{absoluteX(page_cross)};
-    if(page_cross) waitForCycles(5);
-    else           waitForCycles(4);
-    EOR(effective_address);
-}
-void MOS6502::LSRabx() { //
-    waitForCycles(7);
-    bool page_cross;
-    LSR(absoluteX(page_cross));
-}
-
-void MOS6502::RTSimp() { //
-    waitForCycles(6);
-
-    BYTE LB{pull()};
-    BYTE HB{pull()};
-    WORD address = HB*16*16+LB;
-
-    PC = address+1;
-}
-void MOS6502::ADCxin() { //
-    waitForCycles(6);
-    addWithCarry(memoryRead(Xindirect()));
-}
-void MOS6502::ADCzpg() { //
-    waitForCycles(3);
-    addWithCarry(memoryRead(zeropage()));
-}
-void MOS6502::RORzpg() { //
-    waitForCycles(5);
-    ROR(zeropage());
-}
-void MOS6502::PLAimp() { //
-    waitForCycles(4);
-
-    AC = pull();
-
-    SR[ZF] = (AC==0);
-    SR[NF] = (AC & (1U<<7));
-}
-void MOS6502::ADCimm() { //
-    waitForCycles(2);
-    addWithCarry(memoryRead(PC++));
-}
-void MOS6502::RORimp() { //
-    waitForCycles(2);
-    BYTE tmpCF{SR[CF]};
-    SR[CF] = (AC & 1U);
-    AC >>= 1;
-    AC += (tmpCF<<7);
-    SR[ZF] = (AC==0);
-    SR[NF] = (AC & (1U<<7));
-}
-void MOS6502::JMPind() { //
-    waitForCycles(5);
-    PC = indirect();
-} 
-void MOS6502::ADCabs() { //
-    waitForCycles(4);
-    addWithCarry(memoryRead(absolute()));
-}
-void MOS6502::RORabs() { //
-    waitForCycles(6);
-    ROR(absolute());
-}
-
-void MOS6502::BVSrel() { //
-    waitForCycles(2);
-    bool page_cross{false};
-
-    if(SR[VF] == 1) {
-        PC = relative(page_cross);
-        if(page_cross) {
-            waitForCycles(2);
-        } else {
-            waitForCycles(1);
-        }
-    } else {
-        ++PC;
-    }
-}
-void MOS6502::ADCiny() { //
-    bool page_cross{false};
-    BYTE memory{memoryRead(indirectY(page_cross))};
-
-    if(page_cross) waitForCycles(6);
-    else           waitForCycles(5);
-
-    addWithCarry(memory);
-}
-void MOS6502::ADCzpx() { //
-    waitForCycles(4);
-    addWithCarry(memoryRead(zeropageX()));
-}
-void MOS6502::RORzpx() { //
-    waitForCycles(6);
-    ROR(zeropageX());
-} 
-void MOS6502::SEIimp() { //
-    waitForCycles(2);
-    SR[IF] = 1;
-}
-void MOS6502::ADCaby() { //
-    bool page_cross{false};
-    BYTE memory{memoryRead(absoluteY(page_cross))};
-    
-    if(page_cross) waitForCycles(5);
-    else           waitForCycles(4);
-
-    addWithCarry(memory);
-}
-void MOS6502::ADCabx() { //
-    bool page_cross{false};
-    BYTE memory{memoryRead(absoluteX(page_cross))};
-    
-    if(page_cross) waitForCycles(5);
-    else           waitForCycles(4);
-
-    addWithCarry(memory);
-}
-void MOS6502::RORabx() { //
-    waitForCycles(7);
-    bool page_cross;
-    ROR(absoluteX(page_cross));
-}
-
-void MOS6502::STAxin() { //
-    waitForCycles(6);
-    memoryWrite(Xindirect(), AC);
-}
-void MOS6502::STYzpg() { //
-    waitForCycles(3);
-    memoryWrite(zeropage(), Y);
-} 
-void MOS6502::STAzpg() { //
-    waitForCycles(3);
-    memoryWrite(zeropage(), AC);
-}
-void MOS6502::STXzpg() { //
-    waitForCycles(3);
-    memoryWrite(zeropage(), X);
-} 
-void MOS6502::DEYimp() { //
-    waitForCycles(2);
-    --Y;
-    SR[ZF] = (Y==0);
-    SR[NF] = (Y & (1U<<7));
-}
-void MOS6502::TXAimp() { //
-    waitForCycles(2);
-    AC = X;
-
-    SR[ZF] = (AC==0);
-    SR[NF] = (AC & (1U<<7));
-}
-void MOS6502::STYabs() { //
-    waitForCycles(4);
-    memoryWrite(absolute(), Y);
-}
-void MOS6502::STAabs() { //
-    waitForCycles(4);
-    memoryWrite(absolute(), AC);
-} 
-void MOS6502::STXabs() { //
-    waitForCycles(4);
-    memoryWrite(absolute(), X);
-}
-
-void MOS6502::BCCrel() { //
-    waitForCycles(2);
-    bool page_cross{false};
-
-    if(SR[CF] == 0) {
-        PC = relative(page_cross);
-        if(page_cross) {
-            waitForCycles(2);
-        } else {
-            waitForCycles(1);
-        }
+    if constexpr (Variant::cmos) {
+        //65C02: N and Z are valid (one more cycle, see instructionCycles())
+        AC = result;
+        SR[ZF] = (AC==0);
+        SR[NF] = (AC & (1U<<7));
     } else {
-        ++PC;
+        //NMOS: Z comes from the binary sum
+        SR[ZF] = (static_cast<uint8_t>(AC + memory + carry) == 0);
+        SR[NF] = (sresult & (1U<<7));
+        AC = result;
     }
 }
-void MOS6502::STAiny() { //
-    waitForCycles(6);
-    bool page_cross;
-    memoryWrite(indirectY(page_cross), AC);
-}
-void MOS6502::STYzpx() { //
-    waitForCycles(4);
-    memoryWrite(zeropageX(), Y);
-}
-void MOS6502::STAzpx() { //
-    waitForCycles(4);
-    memoryWrite(zeropageX(), AC);
-} 
-void MOS6502::STXzpy() { //
-    waitForCycles(4);
-    memoryWrite(zeropageY(), X);
-}
-void MOS6502::TYAimp() { //
-    waitForCycles(2);
-    AC = Y;
 
-    SR[ZF] = (AC==0);
-    SR[NF] = (AC & (1U<<7));
-}
-void MOS6502::STAaby() { //
-    waitForCycles(5);
-    bool page_cross;
-    memoryWrite(absoluteY(page_cross), AC);
-}
-void MOS6502::TXSimp() { //
-    waitForCycles(2);
-    SP = X;
-}
-void MOS6502::STAabx() { //
-    waitForCycles(5);
-    bool page_cross;
-    memoryWrite(absoluteX(page_cross), AC);
-}
+template<class Variant>
+void MOS6502Core<Variant>::subDecimal(uint8_t memory) {
+    int carry = SR[CF];
+    int lo = (AC & 0x0f) - (memory & 0x0f) + carry - 1;
+    int result;
 
-void MOS6502::LDYimm() { //
-    waitForCycles(2);
-    LDY(PC++);
-} 
-void MOS6502::LDAxin() { //
-    waitForCycles(6);
-    LDA(Xindirect());
-}
-void MOS6502::LDXimm() { //
-    waitForCycles(2);
-    LDX(PC++);
-}
-void MOS6502::LDYzpg() { //
-    waitForCycles(3);
-    LDY(zeropage());
-} 
-void MOS6502::LDAzpg() { //
-    waitForCycles(3);
-    LDA(zeropage());
-} 
-void MOS6502::LDXzpg() { //
-    waitForCycles(3);
-    LDX(zeropage());
-} 
-void MOS6502::TAYimp() { //
-    waitForCycles(2);
-    Y = AC;
-    SR[ZF] = (Y==0);
-    SR[NF] = (Y & (1U<<7));
-}
-void MOS6502::LDAimm() { //
-    waitForCycles(2);
-    LDA(PC++);
-} 
-void MOS6502::TAXimp() { //
-    waitForCycles(2);
-    X = AC;
-    SR[ZF] = (X==0);
-    SR[NF] = (X & (1U<<7));
-}
-void MOS6502::LDYabs() { //
-    waitForCycles(4);
-    LDY(absolute());
-} 
-void MOS6502::LDAabs() { //
-    waitForCycles(4);
-    LDA(absolute());
-}
-void MOS6502::LDXabs() { //
-    waitForCycles(4);
-    LDX(absolute());
-}
-
-void MOS6502::BCSrel() { //
-    waitForCycles(2);
-    bool page_cross{false};
-
-    if(SR[CF] == 1) {
-        PC = relative(page_cross);
-        if(page_cross) {
-            waitForCycles(2);
-        } else {
-            waitForCycles(1);
-        }
+    if constexpr (Variant::cmos) {
+        result = AC - memory + carry - 1;
+        if(result < 0) result -= 0x60;
+        if(lo < 0)     result -= 0x06;
     } else {
-        ++PC;
-    }
-}
-void MOS6502::LDAiny() { //
-    bool page_cross{false};
-    WORD effective_address = indirectY(page_cross);
-    if(page_cross) waitForCycles(6);
-    else           waitForCycles(5);
-    LDA(effective_address);
-}
-void MOS6502::LDYzpx() { //
-    waitForCycles(4);
-    LDY(zeropageX());
-} 
-void MOS6502::LDAzpx() { //
-    waitForCycles(4);
-    LDA(zeropageX());
-} 
-void MOS6502::LDXzpy() { //
-    waitForCycles(4);
-    LDX(zeropageY());
-} 
-void MOS6502::CLVimp() { //
-    waitForCycles(2);
-    SR[VF] = 0;
-}
-void MOS6502::LDAaby() { //
-    bool page_cross{false};
-    WORD effective_address = absoluteY(page_cross);
-    if(page_cross) waitForCycles(5);
-    else           waitForCycles(4);
-    LDA(effective_address);
-} 
-void MOS6502::TSXimp() { //
-    waitForCycles(2);
-    X = SP;
-    SR[ZF] = (X==0);
-    SR[NF] = (X & (1U<<7));
-}
-void MOS6502::LDYabx() { //
-    bool page_cross{false};
-    WORD effective_address = absoluteX(page_cross);
-    if(page_cross) waitForCycles(5);
-    else           waitForCycles(4);
-    LDY(effective_address);
-} 
-void MOS6502::LDAabx() { //
-    bool page_cross{false};
-    WORD effective_address = absoluteX(page_cross);
-    if(page_cross) waitForCycles(5);
-    else           waitForCycles(4);
-    LDA(effective_address);
-}
-void MOS6502::LDXaby() { //
-    bool page_cross{false};
-    WORD effective_address = absoluteY(page_cross);
-    if(page_cross) waitForCycles(5);
-    else           waitForCycles(4);
-    LDX(effective_address);
-}
-
-void MOS6502::CPYimm() { //
-    waitForCycles(2);
-    compareRM(Y, memoryRead(PC++));
-}
-void MOS6502::CMPxin() { //
-    waitForCycles(6);
-    compareRM(AC, memoryRead(Xindirect()));
-} 
-void MOS6502::CPYzpg() { //
-    waitForCycles(3);
-    compareRM(Y, memoryRead(zeropage()));
-} 
-void MOS6502::CMPzpg() { //
-    waitForCycles(3);
-    compareRM(AC, memoryRead(zeropage()));
-} 
-void MOS6502::DECzpg() { //
-    waitForCycles(5);
-    DEC(zeropage());
-}
-void MOS6502::INYimp() { //
-    waitForCycles(2);
-    ++Y;
-    SR[ZF] = (Y==0);
-    SR[NF] = (Y & (1U<<7));
-} 
-void MOS6502::CMPimm() { //
-    waitForCycles(2);
-    compareRM(AC, memoryRead(PC++));
-} 
-void MOS6502::DEXimp() { //
-    waitForCycles(2);
-    --X;
-    SR[ZF] = (X==0);
-    SR[NF] = (X & (1U<<7));
-} 
-void MOS6502::CPYabs() { //
-    waitForCycles(2);
-    compareRM(Y, memoryRead(absolute()));
-} 
-void MOS6502::CMPabs() { //
-    waitForCycles(4);
-    compareRM(AC, memoryRead(absolute()));
-} 
-void MOS6502::DECabs() { //
-    waitForCycles(6);
-    DEC(absolute());
-}
-
-void MOS6502::BNErel() { //
-    waitForCycles(2);
-    bool page_cross{false};
-
-    if(SR[ZF] == 0) {
-        PC = relative(page_cross);
-        if(page_cross) {
-            waitForCycles(2);
-        } else {
-            waitForCycles(1);
+        if(lo < 0) {
+            lo = ((lo - 0x06) & 0x0f) - 0x10;
         }
-    } else {
-        ++PC;
+        result = (AC & 0xf0) - (memory & 0xf0) + lo;
+        if(result < 0) result -= 0x60;
     }
-}
-void MOS6502::CMPiny() { //
-    bool page_cross{false};
-    BYTE memory{memoryRead(indirectY(page_cross))};
-    if(page_cross) waitForCycles(6);
-    else           waitForCycles(5);
-    compareRM(AC, memory);
-}
-void MOS6502::CMPzpx() { //
-    waitForCycles(4);
-    compareRM(AC, memoryRead(zeropageX()));
-} 
-void MOS6502::DECzpx() { //
-    waitForCycles(6);
-    DEC(zeropageX());
-}
-void MOS6502::CLDimp() { //
-    waitForCycles(2);
-    SR[DF] = 0;
-}
-void MOS6502::CMPaby() { //
-    bool page_cross{false};
-    BYTE memory{memoryRead(absoluteY(page_cross))};
-    if(page_cross) waitForCycles(5);
-    else           waitForCycles(4);
-    compareRM(AC, memory);
-} 
-void MOS6502::CMPabx() { //
-    bool page_cross{false};
-    BYTE memory{memoryRead(absoluteX(page_cross))};
-    if(page_cross) waitForCycles(5);
-    else           waitForCycles(4);
-    compareRM(AC, memory);
-} 
-void MOS6502::DECabx() { //
-    waitForCycles(7);
-    bool page_cross;
-    DEC(absoluteX(page_cross));
-}
 
-void MOS6502::CPXimm() { //
-    waitForCycles(2);
-    compareRM(X, memoryRead(PC++));
-} 
-void MOS6502::SBCxin() { //
-    waitForCycles(6);
-    subWithBorrow(memoryRead(Xindirect()));
-}
-void MOS6502::CPXzpg() { //
-    waitForCycles(3);
-    compareRM(X, memoryRead(zeropage()));
-} 
-void MOS6502::SBCzpg() { //
-    waitForCycles(3);
-    subWithBorrow(memoryRead(zeropage()));
-}
-void MOS6502::INCzpg() { //
-    waitForCycles(5);
-    INC(zeropage());
-}
-void MOS6502::INXimp() { //
-    waitForCycles(2);
-    ++X;
-    SR[ZF] = (X==0);
-    SR[NF] = (X & (1U<<7));
-}
-void MOS6502::SBCimm() { //
-    waitForCycles(2);
-    subWithBorrow(memoryRead(PC++));
-}
-void MOS6502::NOPimp() { //
-    waitForCycles(2);
-} 
-void MOS6502::CPXabs() { //
-    waitForCycles(4);
-    compareRM(X, memoryRead(absolute()));
-} 
-void MOS6502::SBCabs() { //
-    waitForCycles(4);
-    subWithBorrow(memoryRead(absolute()));
-}
-void MOS6502::INCabs() { //
-    waitForCycles(6);
-    INC(absolute());
-}
-
-void MOS6502::BEQrel() { //
-    waitForCycles(2);
-    bool page_cross{false};
+    //C and V (and N, Z on NMOS) come from the binary subtraction
+    addBinary(~memory);
+    AC = result;
 
-    if(SR[ZF] == 1) {
-        PC = relative(page_cross);
-        if(page_cross) {
-            waitForCycles(2);
-        } else {
-            waitForCycles(1);
-        }
-    } else {
-        ++PC;
+    if constexpr (Variant::cmos) {
+        SR[ZF] = (AC==0);
+        SR[NF] = (AC & (1U<<7));
     }
-} 
-void MOS6502::SBCiny() { //
-    bool page_cross{false};
-    BYTE memory{memoryRead(indirectY(page_cross))};
-    if(page_cross) waitForCycles(6);
-    else           waitForCycles(5);
-    subWithBorrow(memory);
-}
-void MOS6502::SBCzpx() { //
-    waitForCycles(4);
-    subWithBorrow(memoryRead(zeropageX()));
-}
-void MOS6502::INCzpx() { //
-    waitForCycles(6);
-    INC(zeropageX());
-} 
-void MOS6502::SEDimp() { //
-    waitForCycles(2);
-    SR[DF] = 1;
-}
-void MOS6502::SBCaby() { //
-    bool page_cross{false};
-    BYTE memory{memoryRead(absoluteY(page_cross))};
-    if(page_cross) waitForCycles(5);
-    else           waitForCycles(4);
-    subWithBorrow(memory);
-}
-void MOS6502::SBCabx() { //
-    bool page_cross{false};
-    BYTE memory{memoryRead(absoluteX(page_cross))};
-    if(page_cross) waitForCycles(5);
-    else           waitForCycles(4);
-    subWithBorrow(memory);
-}
-void MOS6502::INCabx() { //
-    waitForCycles(7);
-    bool page_cross;
-    INC(absoluteX(page_cross));
-}
-
-void MOS6502::OPCill() {
-    NOPimp();
-}
-
-
-void MOS6502::AND(WORD address) {
-    AC &= memoryRead(address);
-    SR[ZF] = (AC==0);
-    SR[NF] = (AC & (1U<<7));
-}
-
-void MOS6502::ASL(WORD address) {
-    BYTE data{memoryRead(address)};
-    SR[CF] = (data & (1U<<7));
-    data*=2;
-    SR[ZF] = (data==0);
-    SR[NF] = (data & (1U<<7));
-    memoryWrite(address, data);
-}
-
-void MOS6502::BIT(WORD address) {
-    BYTE data{memoryRead(address)};
-    SR[NF] = (data & (1U<<7));
-    SR[VF] = (data & (1U<<6));
-    SR[ZF] = ((data&AC)==0);  
-}
-
-void MOS6502::DEC(WORD address) {
-    BYTE data{memoryRead(address)};
-    --data;
-    memoryWrite(address, data);
-    SR[ZF] = (data==0);
-    SR[NF] = (data & (1U<<7));
 }
 
-void MOS6502::EOR(WORD address) {
-    AC ^= memoryRead(address);
-    SR[ZF] = (AC==0);
-    SR[NF] = (AC & (1U<<7));
-}
-
-void MOS6502::INC(WORD address) {
-    BYTE data{memoryRead(address)};
-    ++data;
-    memoryWrite(address, data);
-    SR[ZF] = (data==0);
-    SR[NF] = (data & (1U<<7));
-}
+/********************************/
 
-void MOS6502::LDA(WORD address) {
-    AC = memoryRead(address);
-    SR[ZF] = (AC==0);
-    SR[NF] = (AC & (1U<<7));
-}
+/**** Istructions ****/
+template<class Variant>
+template<uint8_t opcode, class Hooks>
+void MOS6502Core<Variant>::instruction() {
+    constexpr InstructionInfo info{INSTRUCTIONS<Variant>[opcode]};
 
-void MOS6502::LDX(WORD address) {
-    X = memoryRead(address);
-    SR[ZF] = (X==0);
-    SR[NF] = (X & (1U<<7));
-}
+    bool page_crossed{false};
+    WORD address{effectiveAddress<info.mode, Hooks>(page_crossed)};
 
-void MOS6502::LDY(WORD address) {
-    Y = memoryRead(address);
-    SR[ZF] = (Y==0);
-    SR[NF] = (Y & (1U<<7));
+    instructionCycles<opcode>(page_crossed);
+    operation<opcode, Hooks>(address, page_crossed);
 }
 
-void MOS6502::LSR(WORD address) {
-    BYTE data{memoryRead(address)};
-    SR[CF] = (data & 1U);
-    data/=2;
-    SR[ZF] = (data==0);
-    SR[NF] = 0;
-    memoryWrite(address, data);
+template<class Variant>
+void MOS6502Core<Variant>::setZN(uint8_t value) {
+    SR[ZF] = (value==0);
+    SR[NF] = (value & (1U<<7));
 }
+/*********************/
 
-void MOS6502::ORA(WORD address) {
-    AC |= memoryRead(address);
-    SR[ZF] = (AC==0);
-    SR[NF] = (AC & (1U<<7));
+template<class Variant>
+template<class Hooks, std::size_t... opcodes>
+constexpr typename MOS6502Core<Variant>::OpcodeTable
+MOS6502Core<Variant>::makeOpcodeTable(std::index_sequence<opcodes...>) {
+    return {{ &MOS6502Core::instruction<opcodes, Hooks>... }};
 }
 
-void MOS6502::ROL(WORD address) {
-    BYTE tmpCF{SR[CF]};
-    BYTE data{memoryRead(address)};
-    SR[CF] = (data & (1U<<7));
-    data <<= 1;
-    data+=tmpCF;
-    memoryWrite(address, data);
-    SR[ZF] = (data==0);
-    SR[NF] = (data & (1U<<7)); 
-}
+template<class Variant>
+template<class Hooks>
+const typename MOS6502Core<Variant>::OpcodeTable MOS6502Core<Variant>::OPCODES =
+    MOS6502Core<Variant>::makeOpcodeTable<Hooks>(std::make_index_sequence<0x100>());
 
-void MOS6502::ROR(WORD address) {
-    BYTE tmpCF{SR[CF]};
-    BYTE data{memoryRead(address)};
-    SR[CF] = (data & 1U);
-    data >>= 1;
-    data += (tmpCF<<7);
-    memoryWrite(address, data);
-    SR[ZF] = (data == 0);
-    SR[NF] = (data & (1U << 7));
-}
-/*********************/
+template class MOS6502Core<NMOS6502>;
+template class MOS6502Core<CMOS65C02>;
+template class MOS6502Core<RP2A03>;
@@ -4,21 +4,96 @@
 #include <functional>
 #include <string>
 #include <bitset>
+#include <array>
+#include <utility>
+#include <unordered_map>
 #include <cstdint>
+#include "Variants.h"
+#include "Instructions.h"
+#include "Hooks.h"
+#include "Scheduler.h"
+#include "PageTable.h"
+
+template<class Variant> class CycleEngine;
+template<class Variant> class Recompiled;
+template<class Variant> class Rewind;
+
+/*
+    The core is parameterised by a variant policy (see Variants.h).
+    Use one of the aliases at the bottom of this file:
+     - MOS6502:  NMOS 6502
+     - MOS65C02: CMOS 65C02
+     - MOS2A03:  Ricoh 2A03 (no decimal mode)
+*/
+template<class Variant>
+class MOS6502Core {
+    friend class CycleEngine<Variant>;
+    friend class Recompiled<Variant>;
+    friend class Rewind<Variant>;
 
-class MOS6502 {
     using fWrite = std::function<void(uint16_t, uint8_t)>;
     using fRead  = std::function<uint8_t(uint16_t)>;
 public:
-    MOS6502(fWrite const & w, fRead const & r);
+    //Native replacement of a ROM routine (see setTrap())
+    using fTrap  = std::function<void(MOS6502Core&)>;
+
+    MOS6502Core(fWrite const & w, fRead const & r);
+    //64 KiB of flat memory, accessed directly through a page table of
+    //the CPU: the writes are not tracked (bind a Memory with pages())
+    explicit MOS6502Core(uint8_t* memory);
+    //Pages of the table accessed directly, the others through w/r
+    MOS6502Core(PageTable const & pages, fWrite const & w, fRead const & r);
+    //Pages of the table only (the others read 0xff, ignore writes)
+    explicit MOS6502Core(PageTable const & pages);
     void IRQ();
     void NMI();
     void execute(uint16_t init_PC, uint16_t end_PC);
+    void step();
     void reset();
 
     std::string info() const;
     void setBreakpoint(uint16_t addr);
 
+    /*
+        High-level emulation: when execute()/step() reach addr, the
+        handler is called instead of the code at addr. The handler
+        accesses registers and memory through the CPU (set*()/get*(),
+        readMemory()/writeMemory()), then the CPU charges the given
+        number of cycles and returns from the subroutine (RTS).
+        A handler must not remove its own trap.
+    */
+    void setTrap(uint16_t addr, fTrap const & handler, uint32_t cycles);
+    void removeTrap(uint16_t addr);
+
+    uint8_t readMemory(uint16_t addr) const {
+        uint8_t* page{pages->read[addr >> PageTable::PAGE_BITS]};
+        return page ? page[addr & PageTable::PAGE_MASK] : memoryRead(addr);
+    }
+    void writeMemory(uint16_t addr, uint8_t data) const {
+        uint8_t* page{pages->write[addr >> PageTable::PAGE_BITS]};
+        if(page) {
+            page[addr & PageTable::PAGE_MASK] = data;
+            pages->markDirty(addr);
+        } else {
+            memoryWrite(addr, data);
+        }
+    }
+
+    /*
+        Instruction and memory hooks (see Hooks.h): with hooks != nullptr
+        the CPU switches to the ToolingHooks interpreter at the next
+        instruction boundary, with nullptr back to the NoHooks one.
+        While execute() runs without hooks, the change is only noticed
+        after a trap (call it from a trap handler or between step()s).
+    */
+    void setHooks(CPUHooks* hooks);
+
+    //Events and IRQ line of the devices (see Scheduler.h)
+    Scheduler& scheduler();
+
+    CPUState getState() const;
+    void setState(CPUState const & state);
+
     void setPC(uint16_t PC);
     void setAC(uint8_t AC);
     void setX(uint8_t X);
@@ -32,6 +107,7 @@ public:
     uint8_t getY() const;
     uint8_t getSR() const;
     uint8_t getSP() const;
+    uint64_t getCycles() const;
 
 private:
     /**** Registers and Memory ****/
@@ -55,180 +131,103 @@ private:
     uint8_t currentOpCodeCycles = 0;    //Cycles for the current opCode
     uint16_t breakpoint = 0;            //Breakpoint (for debugging)
 
+    /**** Devices ****/
+    Scheduler events{cycles};
+
+    /**** High-level emulation ****/
+    struct Trap {
+        fTrap handler;
+        uint32_t cycles;
+    };
+    std::bitset<0x10000> trapMap;       //PCs with a registered trap
+    std::unordered_map<uint16_t, Trap> traps;
+
     /**** Function objects for memory read and write operations ****/
     const fWrite memoryWrite;
     const fRead memoryRead;
+    PageTable flatPages;                //Pages of the flat memory (or none)
+    PageTable const* const pages;       //Direct accesses (see PageTable.h)
 
     /**** Istructions ****
-     *  The first three characters represent the real name of the instruction.
-     *  The last three characters indicate the addressing mode:
-     *      ---abs: absolute
-     *      ---abx: absolute,X indexed
-     *      ---aby: absolute,Y indexed
-     *      ---imm: immediate
-     *      ---ind: indirect
-     *      ---xin: X indexed,indirect
-     *      ---iny: indirect,Y indexed
-     *      ---rel: relative
-     *      ---zpg: zeropage
-     *      ---zpx: zeropage,X indexed
-     *      ---zpy: zeropage,Y indexed
-     * 
-     *  Note: OPCill stands for "illegal opcode" (NOPimp())
+     *  There are no hand-written opcode handlers: instruction<opcode>()
+     *  is instantiated for every opcode and reads its addressing mode,
+     *  cycles and page crossing penalty from INSTRUCTIONS<Variant>
+     *  (see Instructions.h), then calls operation<opcode>() which only
+     *  implements the semantics of the mnemonic. The compiler thus
+     *  generates one specialised handler per (operation, mode) pair.
+    */
+    template<uint8_t opcode, class Hooks> void instruction();
+    template<uint8_t opcode, class Hooks> void operation(uint16_t address, bool page_crossed);
+    //Charge the cycles of opcode (before operation(), branches excluded)
+    template<uint8_t opcode> void instructionCycles(bool page_crossed);
+
+    /*
+     *  Semantics of the operations that access a memory operand, on
+     *  values only: the bus accesses are done by the caller (so that
+     *  CycleEngine can perform them at the right cycle).
     */
-    void BRKimp(); void ORAxin();
-    void ORAzpg(); void ASLzpg(); 
-    void PHPimp(); void ORAimm(); 
-    void ASLimp(); void ORAabs(); 
-    void ASLabs();
-
-    void BPLrel(); void ORAiny(); 
-    void ORAzpx(); void ASLzpx(); 
-    void CLCimp(); void ORAaby(); 
-    void ORAabx(); void ASLabx();
-
-    void JSRabs(); void ANDxin(); 
-    void BITzpg(); void ANDzpg(); 
-    void ROLzpg(); void PLPimp(); 
-    void ANDimm(); void ROLimp(); 
-    void BITabs(); void ANDabs(); 
-    void ROLabs();
-
-    void BMIrel(); void ANDiny(); 
-    void ANDzpx(); void ROLzpx(); 
-    void SECimp(); void ANDaby(); 
-    void ANDabx(); void ROLabx();
-
-    void RTIimp(); void EORxin(); 
-    void EORzpg(); void LSRzpg(); 
-    void PHAimp(); void EORimm(); 
-    void LSRimp(); void JMPabs(); 
-    void EORabs(); void LSRabs();
-
-    void BVCrel(); void EORiny(); 
-    void EORzpx(); void LSRzpx(); 
-    void CLIimp(); void EORaby(); 
-    void EORabx(); void LSRabx();
-
-    void RTSimp(); void ADCxin(); 
-    void ADCzpg(); void RORzpg(); 
-    void PLAimp(); void ADCimm(); 
-    void RORimp(); void JMPind(); 
-    void ADCabs(); void RORabs();
-
-    void BVSrel(); void ADCiny(); 
-    void ADCzpx(); void RORzpx(); 
-    void SEIimp(); void ADCaby(); 
-    void ADCabx(); void RORabx();
-
-    void STAxin(); void STYzpg(); 
-    void STAzpg(); void STXzpg(); 
-    void DEYimp(); void TXAimp(); 
-    void STYabs(); void STAabs(); 
-    void STXabs();
-
-    void BCCrel(); void STAiny(); 
-    void STYzpx(); void STAzpx(); 
-    void STXzpy(); void TYAimp(); 
-    void STAaby(); void TXSimp(); 
-    void STAabx();
-
-    void LDYimm(); void LDAxin(); 
-    void LDXimm(); void LDYzpg(); 
-    void LDAzpg(); void LDXzpg(); 
-    void TAYimp(); void LDAimm(); 
-    void TAXimp(); void LDYabs(); 
-    void LDAabs(); void LDXabs();
-
-    void BCSrel(); void LDAiny();
-    void LDYzpx(); void LDAzpx(); 
-    void LDXzpy(); void CLVimp(); 
-    void LDAaby(); void TSXimp(); 
-    void LDYabx(); void LDAabx(); 
-    void LDXaby();
-
-    void CPYimm(); void CMPxin(); 
-    void CPYzpg(); void CMPzpg(); 
-    void DECzpg(); void INYimp(); 
-    void CMPimm(); void DEXimp(); 
-    void CPYabs(); void CMPabs(); 
-    void DECabs();
-
-    void BNErel(); void CMPiny(); 
-    void CMPzpx(); void DECzpx(); 
-    void CLDimp(); void CMPaby(); 
-    void CMPabx(); void DECabx();
-
-    void CPXimm(); void SBCxin(); 
-    void CPXzpg(); void SBCzpg(); 
-    void INCzpg(); void INXimp(); 
-    void SBCimm(); void NOPimp(); 
-    void CPXabs(); void SBCabs(); 
-    void INCabs();
-
-    void BEQrel(); void SBCiny(); 
-    void SBCzpx(); void INCzpx(); 
-    void SEDimp(); void SBCaby(); 
-    void SBCabx(); void INCabx();
-
-    void OPCill();
-
-    void AND(uint16_t);
-    void ASL(uint16_t);
-    void BIT(uint16_t);
-    void DEC(uint16_t);
-    void EOR(uint16_t);
-    void INC(uint16_t);
-    void LDA(uint16_t);
-    void LDX(uint16_t);
-    void LDY(uint16_t);
-    void LSR(uint16_t);
-    void ORA(uint16_t);
-    void ROL(uint16_t);
-    void ROR(uint16_t);
+    template<Mnemonic M, AddrMode A> void readOperation(uint8_t data);
+    template<Mnemonic M> uint8_t writeOperation() const;
+    template<Mnemonic M> uint8_t modifyOperation(uint8_t data);
+    template<Mnemonic M> bool branchTaken() const;
+
+    //Apply f to the accumulator (implied mode) or to the memory operand
+    template<AddrMode mode, class Hooks, class F> void readModifyWrite(uint16_t address, F f);
+    //Take the branch (and pay the extra cycles) if condition is true
+    template<uint8_t opcode> void branch(bool condition, uint16_t target, bool page_crossed);
+    //Pull the SR from the stack (B and bit 5 are not affected)
+    template<class Hooks> void pullSR();
+    //Set the Z and N flags according to value
+    void setZN(uint8_t value);
 
     /**** Addressing Modes ****/
-    uint16_t absolute();
-    uint16_t absoluteX(bool&);
-    uint16_t absoluteY(bool&);
-    uint16_t indirect();
-    uint16_t Xindirect();
-    uint16_t indirectY(bool&);
-    uint16_t relative(bool&);
-    uint8_t zeropage();
-    uint8_t zeropageX();
-    uint8_t zeropageY();
+    //Return the effective address for the given mode (PC for immediate)
+    template<AddrMode mode, class Hooks> uint16_t effectiveAddress(bool& page_crossed);
+    template<class Hooks> uint16_t absolute();
+    template<class Hooks> uint16_t absoluteX(bool&);
+    template<class Hooks> uint16_t absoluteY(bool&);
+    template<class Hooks> uint16_t indirect();
+    template<class Hooks> uint16_t Xindirect();
+    template<class Hooks> uint16_t indirectY(bool&);
+    template<class Hooks> uint16_t relative(bool&);
+    template<class Hooks> uint8_t zeropage();
+    template<class Hooks> uint8_t zeropageX();
+    template<class Hooks> uint8_t zeropageY();
+    template<class Hooks> uint16_t zeropageIndirect();
+    template<class Hooks> uint16_t absoluteXindirect();
 
     /**** Jump Table ****/
-    //https://www.masswerk.at/6502/6502_instruction_set.html
-    typedef void (MOS6502::*opc)();
-    opc OPCODES[0x100] = {
-               /*    -0      */  /*    -1      */  /*    -2      */  /*    -3      */  /*    -4      */  /*    -5      */  /*    -6      */  /*    -7      */  /*    -8      */  /*    -9      */  /*    -A      */  /*    -B      */  /*    -C      */  /*    -D      */  /*    -E      */  /*    -F      */
-        /*0-*/ &MOS6502::BRKimp, &MOS6502::ORAxin, &MOS6502::OPCill, &MOS6502::OPCill, &MOS6502::OPCill, &MOS6502::ORAzpg, &MOS6502::ASLzpg, &MOS6502::OPCill, &MOS6502::PHPimp, &MOS6502::ORAimm, &MOS6502::ASLimp, &MOS6502::OPCill, &MOS6502::OPCill, &MOS6502::ORAabs, &MOS6502::ASLabs, &MOS6502::OPCill,
-        /*1-*/ &MOS6502::BPLrel, &MOS6502::ORAiny, &MOS6502::OPCill, &MOS6502::OPCill, &MOS6502::OPCill, &MOS6502::ORAzpx, &MOS6502::ASLzpx, &MOS6502::OPCill, &MOS6502::CLCimp, &MOS6502::ORAaby, &MOS6502::OPCill, &MOS6502::OPCill, &MOS6502::OPCill, &MOS6502::ORAabx, &MOS6502::ASLabx, &MOS6502::OPCill, 
-        /*2-*/ &MOS6502::JSRabs, &MOS6502::ANDxin, &MOS6502::OPCill, &MOS6502::OPCill, &MOS6502::BITzpg, &MOS6502::ANDzpg, &MOS6502::ROLzpg, &MOS6502::OPCill, &MOS6502::PLPimp, &MOS6502::ANDimm, &MOS6502::ROLimp, &MOS6502::OPCill, &MOS6502::BITabs, &MOS6502::ANDabs, &MOS6502::ROLabs, &MOS6502::OPCill, 
-        /*3-*/ &MOS6502::BMIrel, &MOS6502::ANDiny, &MOS6502::OPCill, &MOS6502::OPCill, &MOS6502::OPCill, &MOS6502::ANDzpx, &MOS6502::ROLzpx, &MOS6502::OPCill, &MOS6502::SECimp, &MOS6502::ANDaby, &MOS6502::OPCill, &MOS6502::OPCill, &MOS6502::OPCill, &MOS6502::ANDabx, &MOS6502::ROLabx, &MOS6502::OPCill, 
-        /*4-*/ &MOS6502::RTIimp, &MOS6502::EORxin, &MOS6502::OPCill, &MOS6502::OPCill, &MOS6502::OPCill, &MOS6502::EORzpg, &MOS6502::LSRzpg, &MOS6502::OPCill, &MOS6502::PHAimp, &MOS6502::EORimm, &MOS6502::LSRimp, &MOS6502::OPCill, &MOS6502::JMPabs, &MOS6502::EORabs, &MOS6502::LSRabs, &MOS6502::OPCill, 
-        /*5-*/ &MOS6502::BVCrel, &MOS6502::EORiny, &MOS6502::OPCill, &MOS6502::OPCill, &MOS6502::OPCill, &MOS6502::EORzpx, &MOS6502::LSRzpx, &MOS6502::OPCill, &MOS6502::CLIimp, &MOS6502::EORaby, &MOS6502::OPCill, &MOS6502::OPCill, &MOS6502::OPCill, &MOS6502::EORabx, &MOS6502::LSRabx, &MOS6502::OPCill, 
-        /*6-*/ &MOS6502::RTSimp, &MOS6502::ADCxin, &MOS6502::OPCill, &MOS6502::OPCill, &MOS6502::OPCill, &MOS6502::ADCzpg, &MOS6502::RORzpg, &MOS6502::OPCill, &MOS6502::PLAimp, &MOS6502::ADCimm, &MOS6502::RORimp, &MOS6502::OPCill, &MOS6502::JMPind, &MOS6502::ADCabs, &MOS6502::RORabs, &MOS6502::OPCill, 
-        /*7-*/ &MOS6502::BVSrel, &MOS6502::ADCiny, &MOS6502::OPCill, &MOS6502::OPCill, &MOS6502::OPCill, &MOS6502::ADCzpx, &MOS6502::RORzpx, &MOS6502::OPCill, &MOS6502::SEIimp, &MOS6502::ADCaby, &MOS6502::OPCill, &MOS6502::OPCill, &MOS6502::OPCill, &MOS6502::ADCabx, &MOS6502::RORabx, &MOS6502::OPCill, 
-        /*8-*/ &MOS6502::OPCill, &MOS6502::STAxin, &MOS6502::OPCill, &MOS6502::OPCill, &MOS6502::STYzpg, &MOS6502::STAzpg, &MOS6502::STXzpg, &MOS6502::OPCill, &MOS6502::DEYimp, &MOS6502::OPCill, &MOS6502::TXAimp, &MOS6502::OPCill, &MOS6502::STYabs, &MOS6502::STAabs, &MOS6502::STXabs, &MOS6502::OPCill, 
-        /*9-*/ &MOS6502::BCCrel, &MOS6502::STAiny, &MOS6502::OPCill, &MOS6502::OPCill, &MOS6502::STYzpx, &MOS6502::STAzpx, &MOS6502::STXzpy, &MOS6502::OPCill, &MOS6502::TYAimp, &MOS6502::STAaby, &MOS6502::TXSimp, &MOS6502::OPCill, &MOS6502::OPCill, &MOS6502::STAabx, &MOS6502::OPCill, &MOS6502::OPCill, 
-        /*A-*/ &MOS6502::LDYimm, &MOS6502::LDAxin, &MOS6502::LDXimm, &MOS6502::OPCill, &MOS6502::LDYzpg, &MOS6502::LDAzpg, &MOS6502::LDXzpg, &MOS6502::OPCill, &MOS6502::TAYimp, &MOS6502::LDAimm, &MOS6502::TAXimp, &MOS6502::OPCill, &MOS6502::LDYabs, &MOS6502::LDAabs, &MOS6502::LDXabs, &MOS6502::OPCill, 
-        /*B-*/ &MOS6502::BCSrel, &MOS6502::LDAiny, &MOS6502::OPCill, &MOS6502::OPCill, &MOS6502::LDYzpx, &MOS6502::LDAzpx, &MOS6502::LDXzpy, &MOS6502::OPCill, &MOS6502::CLVimp, &MOS6502::LDAaby, &MOS6502::TSXimp, &MOS6502::OPCill, &MOS6502::LDYabx, &MOS6502::LDAabx, &MOS6502::LDXaby, &MOS6502::OPCill, 
-        /*C-*/ &MOS6502::CPYimm, &MOS6502::CMPxin, &MOS6502::OPCill, &MOS6502::OPCill, &MOS6502::CPYzpg, &MOS6502::CMPzpg, &MOS6502::DECzpg, &MOS6502::OPCill, &MOS6502::INYimp, &MOS6502::CMPimm, &MOS6502::DEXimp, &MOS6502::OPCill, &MOS6502::CPYabs, &MOS6502::CMPabs, &MOS6502::DECabs, &MOS6502::OPCill, 
-        /*D-*/ &MOS6502::BNErel, &MOS6502::CMPiny, &MOS6502::OPCill, &MOS6502::OPCill, &MOS6502::OPCill, &MOS6502::CMPzpx, &MOS6502::DECzpx, &MOS6502::OPCill, &MOS6502::CLDimp, &MOS6502::CMPaby, &MOS6502::OPCill, &MOS6502::OPCill, &MOS6502::OPCill, &MOS6502::CMPabx, &MOS6502::DECabx, &MOS6502::OPCill, 
-        /*E-*/ &MOS6502::CPXimm, &MOS6502::SBCxin, &MOS6502::OPCill, &MOS6502::OPCill, &MOS6502::CPXzpg, &MOS6502::SBCzpg, &MOS6502::INCzpg, &MOS6502::OPCill, &MOS6502::INXimp, &MOS6502::SBCimm, &MOS6502::NOPimp, &MOS6502::OPCill, &MOS6502::CPXabs, &MOS6502::SBCabs, &MOS6502::INCabs, &MOS6502::OPCill, 
-        /*F-*/ &MOS6502::BEQrel, &MOS6502::SBCiny, &MOS6502::OPCill, &MOS6502::OPCill, &MOS6502::OPCill, &MOS6502::SBCzpx, &MOS6502::INCzpx, &MOS6502::OPCill, &MOS6502::SEDimp, &MOS6502::SBCaby, &MOS6502::OPCill, &MOS6502::OPCill, &MOS6502::OPCill, &MOS6502::SBCabx, &MOS6502::INCabx, &MOS6502::OPCill
-    };
+    //Generated from INSTRUCTIONS<Variant>, one entry per opcode and hook policy
+    typedef void (MOS6502Core::*opc)();
+    using OpcodeTable = std::array<opc, 0x100>;
+    template<class Hooks>
+    static const OpcodeTable OPCODES;
+    template<class Hooks, std::size_t... opcodes>
+    static constexpr OpcodeTable makeOpcodeTable(std::index_sequence<opcodes...>);
+
+    /**** Hooks ****/
+    CPUHooks* hooks = nullptr;          //Hooks of the ToolingHooks interpreter
+    //Run until end_PC/breakpoint (false) or until the hook policy changes (true)
+    template<class Hooks> bool run(uint16_t end_PC);
+    //Step until the cycle counter reaches end, an event is due or PC is
+    //in stops, adding the instructions to steps (see Rewind::run())
+    void runUntil(uint64_t end, std::bitset<0x10000> const & stops, uint64_t& steps);
+    //Execute one instruction, calling the pre/post instruction hooks
+    void hookedStep();
+    //Memory accesses (reported to the hooks by the ToolingHooks interpreter)
+    template<class Hooks> uint8_t read(uint16_t addr);
+    template<class Hooks> void write(uint16_t addr, uint8_t data);
+    template<class Hooks> uint8_t fetch();
+    template<class Hooks> uint8_t fetchImmediate(uint16_t addr);
 
     /**** Utility ****/
-    void callOpCode(uint8_t);
-    void waitForCycles(uint8_t);
+    template<class Hooks> void callOpCode(uint8_t);
+    void callTrap();
+    void waitForCycles(uint32_t);
 
     /**** Stack Operations ****/
-    void push(uint8_t);
-    uint8_t pull();
+    template<class Hooks> void push(uint8_t);
+    template<class Hooks> uint8_t pull();
 
     /**** Comparison ****/
     //Compare register with memory (Set SR flags)
@@ -239,6 +238,21 @@ private:
     void addWithCarry(uint8_t memory);
     //Subtract memory to AC with borrow (and set SR flags)
     void subWithBorrow(uint8_t memory);
+    //Binary and BCD variants of the above
+    void addBinary(uint8_t memory);
+    void addDecimal(uint8_t memory);
+    void subDecimal(uint8_t memory);
+
+    /**** Interrupts ****/
+    //Push PC and SR, then jump through the given vector
+    template<class Hooks> void interrupt(uint16_t vector, bool brk);
+    //Fire the due events, then take the IRQ if the line is asserted
+    //(returns true if the IRQ has been taken)
+    template<class Hooks> bool serviceEvents();
 };
 
+using MOS6502  = MOS6502Core<NMOS6502>;
+using MOS65C02 = MOS6502Core<CMOS65C02>;
+using MOS2A03  = MOS6502Core<RP2A03>;
+
 #endif
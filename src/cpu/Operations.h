@@ -0,0 +1,385 @@
+#ifndef OPERATIONS_H
+#define OPERATIONS_H
+
+#include "MOS6502.h"
+
+/*
+    Semantics of the instructions.
+
+    These are the member templates of MOS6502Core shared by every engine
+    (MOS6502.cpp, CycleEngine.cpp, recompiled code): they are defined
+    here, with the memory, stack and interrupt primitives they use, so
+    that each engine can instantiate them for the opcodes it dispatches.
+*/
+
+template<class Variant>
+template<uint8_t opcode, class Hooks>
+void MOS6502Core<Variant>::operation(uint16_t address, bool page_crossed) {
+    constexpr Mnemonic M{INSTRUCTIONS<Variant>[opcode].mnemonic};
+    constexpr AddrMode A{INSTRUCTIONS<Variant>[opcode].mode};
+
+    /**** Memory operand ****/
+    if constexpr (accessType(M) == Access::read) {
+        if constexpr (A == AddrMode::imm) readOperation<M, A>(fetchImmediate<Hooks>(address));
+        else                              readOperation<M, A>(read<Hooks>(address));
+    } else if constexpr (accessType(M) == Access::write) {
+        write<Hooks>(address, writeOperation<M>());
+    } else if constexpr (accessType(M) == Access::rmw) {
+        readModifyWrite<A, Hooks>(address, [this](uint8_t data) -> uint8_t {
+            return modifyOperation<M>(data);
+        });
+    }
+
+    /**** Transfer ****/
+    else if constexpr (M == Mnemonic::TAX) {
+        X = AC;
+        setZN(X);
+    } else if constexpr (M == Mnemonic::TAY) {
+        Y = AC;
+        setZN(Y);
+    } else if constexpr (M == Mnemonic::TSX) {
+        X = SP;
+        setZN(X);
+    } else if constexpr (M == Mnemonic::TXA) {
+        AC = X;
+        setZN(AC);
+    } else if constexpr (M == Mnemonic::TXS) {
+        SP = X;
+    } else if constexpr (M == Mnemonic::TYA) {
+        AC = Y;
+        setZN(AC);
+    }
+
+    /**** Stack ****/
+    else if constexpr (M == Mnemonic::PHA) {
+        push<Hooks>(AC);
+    } else if constexpr (M == Mnemonic::PHX) {
+        push<Hooks>(X);
+    } else if constexpr (M == Mnemonic::PHY) {
+        push<Hooks>(Y);
+    } else if constexpr (M == Mnemonic::PHP) {
+        //The pushed copy of the SR always has the BFlag set
+        push<Hooks>(SR.to_ulong() | (1U<<BF));
+    } else if constexpr (M == Mnemonic::PLA) {
+        AC = pull<Hooks>();
+        setZN(AC);
+    } else if constexpr (M == Mnemonic::PLX) {
+        X = pull<Hooks>();
+        setZN(X);
+    } else if constexpr (M == Mnemonic::PLY) {
+        Y = pull<Hooks>();
+        setZN(Y);
+    } else if constexpr (M == Mnemonic::PLP) {
+        pullSR<Hooks>();
+    }
+
+    /**** Increment and Decrement (registers) ****/
+    else if constexpr (M == Mnemonic::INX) {
+        setZN(++X);
+    } else if constexpr (M == Mnemonic::INY) {
+        setZN(++Y);
+    } else if constexpr (M == Mnemonic::DEX) {
+        setZN(--X);
+    } else if constexpr (M == Mnemonic::DEY) {
+        setZN(--Y);
+    }
+
+    /**** Flags ****/
+    else if constexpr (M == Mnemonic::CLC) {
+        SR[CF] = 0;
+    } else if constexpr (M == Mnemonic::CLD) {
+        SR[DF] = 0;
+    } else if constexpr (M == Mnemonic::CLI) {
+        SR[IF] = 0;
+    } else if constexpr (M == Mnemonic::CLV) {
+        SR[VF] = 0;
+    } else if constexpr (M == Mnemonic::SEC) {
+        SR[CF] = 1;
+    } else if constexpr (M == Mnemonic::SED) {
+        SR[DF] = 1;
+    } else if constexpr (M == Mnemonic::SEI) {
+        SR[IF] = 1;
+    }
+
+    /**** Branches ****/
+    else if constexpr (A == AddrMode::rel) {
+        branch<opcode>(branchTaken<M>(), address, page_crossed);
+    }
+
+    /**** Jumps and Subroutines ****/
+    else if constexpr (M == Mnemonic::JMP) {
+        PC = address;
+    } else if constexpr (M == Mnemonic::JSR) {
+        //The return address pushed is the last byte of the JSR
+        uint16_t returnAddress = PC-1;
+        push<Hooks>(returnAddress/(16*16)); //push HB first
+        push<Hooks>(returnAddress);         //push LB
+        PC = address;
+    } else if constexpr (M == Mnemonic::RTS) {
+        uint8_t LB{pull<Hooks>()};
+        uint8_t HB{pull<Hooks>()};
+        PC = HB*16*16+LB+1;
+    } else if constexpr (M == Mnemonic::RTI) {
+        pullSR<Hooks>();
+        uint8_t LB{pull<Hooks>()};
+        uint8_t HB{pull<Hooks>()};
+        PC = HB*16*16+LB;
+    } else if constexpr (M == Mnemonic::BRK) {
+        //BRK skips the byte following the opcode
+        ++PC;
+        interrupt<Hooks>(0xfffe, true);
+    }
+
+    /**** NOP and illegal opcodes ****/
+    else if constexpr (M == Mnemonic::NOP && A == AddrMode::imm) {
+        //65C02 undefined opcodes: the operand is fetched and ignored
+        fetchImmediate<Hooks>(address);
+    } else if constexpr (M == Mnemonic::NOP && A != AddrMode::imp) {
+        read<Hooks>(address);
+    } else {
+        static_assert(M == Mnemonic::NOP || M == Mnemonic::ILL,
+                      "Missing operation for mnemonic");
+    }
+}
+
+template<class Variant>
+template<uint8_t opcode>
+void MOS6502Core<Variant>::instructionCycles(bool page_crossed) {
+    constexpr InstructionInfo info{INSTRUCTIONS<Variant>[opcode]};
+
+    if constexpr (info.mode == AddrMode::rel) {
+        //Branches pay the page crossing penalty only if taken (see branch())
+        waitForCycles(info.cycles);
+    } else {
+        waitForCycles(info.cycles + (page_crossed ? info.pagePenalty : 0));
+    }
+
+    //The 65C02 takes one more cycle for ADC/SBC in decimal mode
+    if constexpr (Variant::cmos && Variant::decimalMode &&
+                  (info.mnemonic == Mnemonic::ADC || info.mnemonic == Mnemonic::SBC)) {
+        if(SR[DF] == 1) waitForCycles(1);
+    }
+}
+
+template<class Variant>
+template<Mnemonic M, AddrMode A>
+void MOS6502Core<Variant>::readOperation(uint8_t data) {
+    if constexpr (M == Mnemonic::LDA) {
+        AC = data;
+        setZN(AC);
+    } else if constexpr (M == Mnemonic::LDX) {
+        X = data;
+        setZN(X);
+    } else if constexpr (M == Mnemonic::LDY) {
+        Y = data;
+        setZN(Y);
+    } else if constexpr (M == Mnemonic::AND) {
+        AC &= data;
+        setZN(AC);
+    } else if constexpr (M == Mnemonic::EOR) {
+        AC ^= data;
+        setZN(AC);
+    } else if constexpr (M == Mnemonic::ORA) {
+        AC |= data;
+        setZN(AC);
+    } else if constexpr (M == Mnemonic::ADC) {
+        addWithCarry(data);
+    } else if constexpr (M == Mnemonic::SBC) {
+        subWithBorrow(data);
+    } else if constexpr (M == Mnemonic::CMP) {
+        compareRM(AC, data);
+    } else if constexpr (M == Mnemonic::CPX) {
+        compareRM(X, data);
+    } else if constexpr (M == Mnemonic::CPY) {
+        compareRM(Y, data);
+    } else if constexpr (M == Mnemonic::BIT) {
+        //Immediate BIT (65C02) only affects the zero flag
+        if constexpr (A != AddrMode::imm) {
+            SR[NF] = (data & (1U<<7));
+            SR[VF] = (data & (1U<<6));
+        }
+        SR[ZF] = ((data&AC)==0);
+    } else {
+        static_assert(M == Mnemonic::LDA, "Not a read operation");
+    }
+}
+
+template<class Variant>
+template<Mnemonic M>
+uint8_t MOS6502Core<Variant>::writeOperation() const {
+    if constexpr (M == Mnemonic::STA)      return AC;
+    else if constexpr (M == Mnemonic::STX) return X;
+    else if constexpr (M == Mnemonic::STY) return Y;
+    else if constexpr (M == Mnemonic::STZ) return 0;
+    else static_assert(M == Mnemonic::STA, "Not a write operation");
+}
+
+template<class Variant>
+template<Mnemonic M>
+uint8_t MOS6502Core<Variant>::modifyOperation(uint8_t data) {
+    if constexpr (M == Mnemonic::ASL) {
+        SR[CF] = (data & (1U<<7));
+        data <<= 1;
+    } else if constexpr (M == Mnemonic::LSR) {
+        SR[CF] = (data & 1U);
+        data >>= 1;
+    } else if constexpr (M == Mnemonic::ROL) {
+        uint8_t tmpCF{SR[CF]};
+        SR[CF] = (data & (1U<<7));
+        data <<= 1;
+        data += tmpCF;
+    } else if constexpr (M == Mnemonic::ROR) {
+        uint8_t tmpCF{SR[CF]};
+        SR[CF] = (data & 1U);
+        data >>= 1;
+        data += (tmpCF<<7);
+    } else if constexpr (M == Mnemonic::INC) {
+        ++data;
+    } else if constexpr (M == Mnemonic::DEC) {
+        --data;
+    } else if constexpr (M == Mnemonic::TRB) {
+        //TRB and TSB only affect the zero flag
+        SR[ZF] = ((data&AC)==0);
+        return data & ~AC;
+    } else if constexpr (M == Mnemonic::TSB) {
+        SR[ZF] = ((data&AC)==0);
+        return data | AC;
+    } else {
+        static_assert(M == Mnemonic::ASL, "Not a read-modify-write operation");
+    }
+    setZN(data);
+    return data;
+}
+
+template<class Variant>
+template<Mnemonic M>
+bool MOS6502Core<Variant>::branchTaken() const {
+    if constexpr (M == Mnemonic::BCC)      return SR[CF] == 0;
+    else if constexpr (M == Mnemonic::BCS) return SR[CF] == 1;
+    else if constexpr (M == Mnemonic::BNE) return SR[ZF] == 0;
+    else if constexpr (M == Mnemonic::BEQ) return SR[ZF] == 1;
+    else if constexpr (M == Mnemonic::BPL) return SR[NF] == 0;
+    else if constexpr (M == Mnemonic::BMI) return SR[NF] == 1;
+    else if constexpr (M == Mnemonic::BVC) return SR[VF] == 0;
+    else if constexpr (M == Mnemonic::BVS) return SR[VF] == 1;
+    else if constexpr (M == Mnemonic::BRA) return true;
+    else static_assert(M == Mnemonic::BRA, "Not a branch");
+}
+
+template<class Variant>
+template<class Hooks>
+void MOS6502Core<Variant>::pullSR() {
+    uint8_t tmpBF{SR[BF]};
+    uint8_t tmpBit5{SR[5]};
+    SR = pull<Hooks>();
+    //ignore break flag
+    SR[BF] = tmpBF;
+    //ignore bit 5
+    SR[5] = tmpBit5;
+}
+
+template<class Variant>
+template<AddrMode mode, class Hooks, class F>
+void MOS6502Core<Variant>::readModifyWrite(uint16_t address, F f) {
+    if constexpr (mode == AddrMode::imp) {
+        AC = f(AC);
+    } else {
+        write<Hooks>(address, f(read<Hooks>(address)));
+    }
+}
+
+template<class Variant>
+template<uint8_t opcode>
+void MOS6502Core<Variant>::branch(bool condition, uint16_t target, bool page_crossed) {
+    if(condition) {
+        PC = target;
+        waitForCycles(1 + (page_crossed ? INSTRUCTIONS<Variant>[opcode].pagePenalty : 0));
+    }
+}
+
+/**** Memory Accesses ****/
+template<class Variant>
+template<class Hooks>
+uint8_t MOS6502Core<Variant>::read(uint16_t addr) {
+    uint8_t data{readMemory(addr)};
+    if constexpr (Hooks::enabled) hooks->memoryRead(addr, data);
+    return data;
+}
+
+template<class Variant>
+template<class Hooks>
+void MOS6502Core<Variant>::write(uint16_t addr, uint8_t data) {
+    writeMemory(addr, data);
+    if constexpr (Hooks::enabled) hooks->memoryWrite(addr, data);
+}
+
+template<class Variant>
+template<class Hooks>
+uint8_t MOS6502Core<Variant>::fetch() {
+    uint8_t data{readMemory(PC)};
+    if constexpr (Hooks::enabled) hooks->memoryFetch(PC, data);
+    ++PC;
+    return data;
+}
+
+//Immediate operand: read through PC, reported as a fetch
+template<class Variant>
+template<class Hooks>
+uint8_t MOS6502Core<Variant>::fetchImmediate(uint16_t addr) {
+    uint8_t data{readMemory(addr)};
+    if constexpr (Hooks::enabled) hooks->memoryFetch(addr, data);
+    return data;
+}
+/*****************/
+
+/**** Stack Operations ****/
+template<class Variant>
+template<class Hooks>
+void MOS6502Core<Variant>::push(uint8_t data) {
+    write<Hooks>(0x0100+(SP--), data);
+}
+
+template<class Variant>
+template<class Hooks>
+uint8_t MOS6502Core<Variant>::pull() {
+    return read<Hooks>(0x0100+(++SP));
+}
+/**************************/
+
+/**** Interrupts ****/
+template<class Variant>
+template<class Hooks>
+void MOS6502Core<Variant>::interrupt(uint16_t vector, bool brk) {
+    //Push HB first
+    push<Hooks>(PC/(16*16));
+    //Push LB
+    push<Hooks>(PC);
+    //BFlag must be set only in the copy of the SR into the stack
+    SR[BF] = brk;
+    push<Hooks>(SR.to_ulong());
+    SR[BF] = 0;
+    //The 65C02 leaves decimal mode when servicing an interrupt
+    if constexpr (Variant::cmos) {
+        SR[DF] = 0;
+    }
+    //Modify the program counter to jump at the istruction poninted by the vector
+    PC = read<Hooks>(vector+1)*16*16+read<Hooks>(vector);
+        /*        HB         */      /*     LB      */
+    //Set the IFlag
+    SR[IF] = 1;
+}
+
+template<class Variant>
+template<class Hooks>
+bool MOS6502Core<Variant>::serviceEvents() {
+    events.runEvents();
+    if(events.irqAsserted() && SR[IF] == 0) {
+        waitForCycles(7);
+        interrupt<Hooks>(0xfffe, false);
+        return true;
+    }
+    return false;
+}
+/********************/
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef PAGETABLE_H
+#define PAGETABLE_H
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+/*
+    Direct access to the address space of a CPU: 16 pages of 4 KiB.
+
+    A page with a pointer is read (written) by indexing the memory it
+    points to; a page without one (I/O, unmapped) goes through the
+    fRead/fWrite functions of the CPU. Read-only pages point their
+    writes to a scratch area instead.
+
+    The CPU keeps a pointer to the table, so the owner can remap a page
+    (e.g. a bank switch) by rewriting its pointers while the CPU runs:
+    the next access uses the new memory, nothing is copied.
+
+    Every direct write also sets the bit of its 256-byte page in the
+    dirty bitmap (a single OR), so the owner knows which pages changed
+    (see Memory.h). The owner clears the bits.
+*/
+struct PageTable {
+    static constexpr unsigned PAGE_BITS{12};
+    static constexpr std::size_t PAGE_SIZE{1 << PAGE_BITS};
+    static constexpr uint16_t PAGE_MASK{PAGE_SIZE - 1};
+    static constexpr std::size_t PAGES{0x10000 >> PAGE_BITS};
+
+    std::array<uint8_t*, PAGES> read{};
+    std::array<uint8_t*, PAGES> write{};
+
+    static constexpr unsigned DIRTY_BITS{8};
+    mutable std::array<uint64_t, 4> dirty{};    //Bit n: page $nn00-$nnff written
+
+    void markDirty(uint16_t addr) const {
+        dirty[addr >> (DIRTY_BITS + 6)] |= uint64_t{1} << ((addr >> DIRTY_BITS) & 63);
+    }
+    bool isDirty(uint8_t page) const {
+        return dirty[page >> 6] >> (page & 63) & 1;
+    }
+};
+
+#endif
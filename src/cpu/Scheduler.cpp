@@ -0,0 +1,77 @@
+#include "Scheduler.h"
+#include <limits>
+#include <utility>
+
+Scheduler::Scheduler(uint64_t const & cycles):
+    cycles{cycles}, next{std::numeric_limits<uint64_t>::max()}
+{}
+
+void Scheduler::schedule(void const* owner, uint64_t cycle, fEvent const & event) {
+    for(Event & e : events) {
+        if(e.owner == owner) {
+            e.cycle = cycle;
+            e.handler = event;
+            update();
+            return;
+        }
+    }
+    events.push_back(Event{owner, cycle, event});
+    update();
+}
+
+void Scheduler::cancel(void const* owner) {
+    for(std::size_t i = 0; i < events.size(); ++i) {
+        if(events[i].owner == owner) {
+            events.erase(events.begin() + i);
+            break;
+        }
+    }
+    update();
+}
+
+void Scheduler::setIRQLine(unsigned source, bool asserted) {
+    if(asserted) {
+        irqLine |= (1U << source);
+    } else {
+        irqLine &= ~(1U << source);
+    }
+    update();
+}
+
+void Scheduler::setIRQLines(uint32_t lines) {
+    irqLine = lines;
+    update();
+}
+
+void Scheduler::runEvents() {
+    //A handler may schedule or cancel events: look for the earliest
+    //due event again after every call
+    for(;;) {
+        std::size_t due = events.size();
+        for(std::size_t i = 0; i < events.size(); ++i) {
+            if(events[i].cycle <= cycles &&
+               (due == events.size() || events[i].cycle < events[due].cycle)) {
+                due = i;
+            }
+        }
+        if(due == events.size()) {
+            break;
+        }
+
+        fEvent handler = std::move(events[due].handler);
+        events.erase(events.begin() + due);
+        update();
+        handler();
+    }
+}
+
+void Scheduler::update() {
+    next = std::numeric_limits<uint64_t>::max();
+    if(irqLine != 0) {
+        next = 0;
+        return;
+    }
+    for(Event const & e : events) {
+        if(e.cycle < next) next = e.cycle;
+    }
+}
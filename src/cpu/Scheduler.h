@@ -0,0 +1,83 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <functional>
+#include <vector>
+#include <cstdint>
+
+/*
+    Cycle-based events and IRQ line of a CPU.
+
+    Devices that depend on time (timers, video...) do not need to be
+    ticked: they compute their state from getCycles() when accessed and
+    schedule an event for the cycle at which something must happen (an
+    underflow, a vertical blank...). The CPU fires the events due at each
+    instruction boundary, with a single comparison against nextCycle().
+
+    The IRQ line is level-triggered and wired-OR: every source (0-31)
+    asserts or releases its own bit, and the CPU takes the interrupt at
+    the first instruction boundary where the line is asserted and the I
+    flag is clear (as IRQ() does).
+*/
+class Scheduler {
+public:
+    using fEvent = std::function<void()>;
+
+    explicit Scheduler(uint64_t const & cycles);
+    //Bound to the cycle counter of its CPU
+    Scheduler(Scheduler const &) = delete;
+    Scheduler& operator=(Scheduler const &) = delete;
+
+    uint64_t getCycles() const;
+
+    /*
+        Call event at the first instruction boundary at or after cycle.
+        Every owner has at most one pending event: scheduling again
+        replaces it.
+    */
+    void schedule(void const* owner, uint64_t cycle, fEvent const & event);
+    void cancel(void const* owner);
+
+    void setIRQLine(unsigned source, bool asserted);
+    bool irqAsserted() const;
+    //All the sources (bit n: source n asserted), e.g. to save and restore the line
+    uint32_t irqLines() const;
+    void setIRQLines(uint32_t lines);
+
+    //Cycle of the next event (0 while the IRQ line is asserted)
+    uint64_t nextCycle() const;
+    //Fire the events due at the current cycle
+    void runEvents();
+
+private:
+    struct Event {
+        void const* owner;
+        uint64_t cycle;
+        fEvent handler;
+    };
+
+    uint64_t const & cycles;
+    std::vector<Event> events;
+    uint32_t irqLine{0};
+    uint64_t next;
+
+    void update();
+};
+
+inline uint64_t Scheduler::getCycles() const {
+    return cycles;
+}
+
+inline bool Scheduler::irqAsserted() const {
+    return irqLine != 0;
+}
+
+inline uint32_t Scheduler::irqLines() const {
+    return irqLine;
+}
+
+inline uint64_t Scheduler::nextCycle() const {
+    return next;
+}
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef VARIANTS_H
+#define VARIANTS_H
+
+/*
+    CPU variant policies.
+
+    A policy is a plain struct of compile-time constants passed as the
+    template argument of MOS6502Core. Every variant-dependent behavior
+    of the core is selected with `if constexpr` on these constants, so
+    no variant check survives as a runtime branch in the interpreter.
+
+      - decimalMode:   ADC/SBC honor the D flag (BCD arithmetic)
+      - cmos:          65C02 behavior (extra opcodes, valid N/Z in
+                       decimal mode, D cleared on interrupts...)
+      - jmpIndirectPageWrap: JMP ($xxFF) fetches the high byte of the
+                       target from $xx00 instead of $xx00+$100
+*/
+
+//Original NMOS 6502
+struct NMOS6502 {
+    static constexpr bool decimalMode{true};
+    static constexpr bool cmos{false};
+    static constexpr bool jmpIndirectPageWrap{true};
+};
+
+//CMOS 65C02 (WDC/Rockwell core instruction set, without the
+//Rockwell bit manipulation instructions)
+struct CMOS65C02 {
+    static constexpr bool decimalMode{true};
+    static constexpr bool cmos{true};
+    static constexpr bool jmpIndirectPageWrap{false};
+};
+
+//Ricoh 2A03: NMOS core with the decimal mode disconnected
+//(the D flag can be set and cleared but ADC/SBC ignore it)
+struct RP2A03 {
+    static constexpr bool decimalMode{false};
+    static constexpr bool cmos{false};
+    static constexpr bool jmpIndirectPageWrap{true};
+};
+
+#endif
@@ -0,0 +1,199 @@
+#include "AsyncMachine.h"
+#include <algorithm>
+
+template<class Variant>
+AsyncMachine<Variant>::AsyncMachine(MOS6502Core<Variant>& cpu, uint64_t batchCycles):
+    cpu{cpu}, batchCycles{std::max<uint64_t>(batchCycles, 1)}
+{
+    publish();
+    thread = std::thread(&AsyncMachine::run, this);
+}
+
+template<class Variant>
+AsyncMachine<Variant>::~AsyncMachine() {
+    post(Command::QUIT).wait();
+    thread.join();
+}
+
+/**** Control ****/
+template<class Variant>
+std::future<CPUState> AsyncMachine<Variant>::pause() {
+    return post(Command::PAUSE);
+}
+
+template<class Variant>
+std::future<CPUState> AsyncMachine<Variant>::resume() {
+    return post(Command::RESUME);
+}
+
+template<class Variant>
+std::future<CPUState> AsyncMachine<Variant>::stepAsync() {
+    return post(Command::STEP);
+}
+
+template<class Variant>
+std::future<CPUState> AsyncMachine<Variant>::runUntil(uint64_t cycle) {
+    return post(Command::RUN_UNTIL, cycle);
+}
+
+template<class Variant>
+std::future<CPUState> AsyncMachine<Variant>::state() {
+    return post(Command::STATE);
+}
+
+template<class Variant>
+bool AsyncMachine<Variant>::isRunning() const {
+    return running.load(std::memory_order_acquire);
+}
+
+template<class Variant>
+std::future<CPUState> AsyncMachine<Variant>::post(typename Command::Type type, uint64_t cycle) {
+    Command* command = new Command{type, cycle, {}, nullptr};
+    std::future<CPUState> result = command->done.get_future();
+
+    command->next = mailbox.load(std::memory_order_relaxed);
+    while(!mailbox.compare_exchange_weak(command->next, command,
+                                         std::memory_order_release,
+                                         std::memory_order_relaxed)) {}
+    mailboxReady.notify();
+
+    return result;
+}
+/*****************/
+
+/**** Snapshot ****/
+template<class Variant>
+CPUState AsyncMachine<Variant>::snapshot() const {
+    for(;;) {
+        uint32_t before = sequence.load(std::memory_order_acquire);
+        if(before & 1) continue;
+
+        uint64_t r = registers.load(std::memory_order_relaxed);
+        uint64_t c = cycles.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        if(sequence.load(std::memory_order_relaxed) == before) {
+            return CPUState{static_cast<uint16_t>(r), static_cast<uint8_t>(r >> 16),
+                            static_cast<uint8_t>(r >> 24), static_cast<uint8_t>(r >> 32),
+                            static_cast<uint8_t>(r >> 40), static_cast<uint8_t>(r >> 48), c};
+        }
+    }
+}
+
+template<class Variant>
+void AsyncMachine<Variant>::publish() {
+    CPUState state = cpu.getState();
+    uint64_t r = state.PC | (uint64_t{state.AC} << 16) | (uint64_t{state.X} << 24) |
+                 (uint64_t{state.Y} << 32) | (uint64_t{state.SR} << 40) |
+                 (uint64_t{state.SP} << 48);
+
+    uint32_t s = sequence.load(std::memory_order_relaxed);
+    sequence.store(s + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    registers.store(r, std::memory_order_relaxed);
+    cycles.store(state.cycles, std::memory_order_relaxed);
+    sequence.store(s + 2, std::memory_order_release);
+}
+/******************/
+
+/**** CPU thread ****/
+template<class Variant>
+void AsyncMachine<Variant>::run() {
+    while(!quit) {
+        if(mailbox.load(std::memory_order_relaxed) != nullptr) {
+            processCommands();
+            continue;
+        }
+
+        if(!running.load(std::memory_order_relaxed)) {
+            mailboxReady.wait([this] {
+                return mailbox.load(std::memory_order_acquire) != nullptr;
+            });
+            continue;
+        }
+
+        //One batch (stops at the target of runUntil())
+        uint64_t end = cpu.getCycles() + batchCycles;
+        if(end > target) end = target;
+        while(cpu.getCycles() < end) {
+            cpu.step();
+        }
+        publish();
+
+        if(cpu.getCycles() >= target) {
+            reachTarget();
+        }
+    }
+}
+
+template<class Variant>
+void AsyncMachine<Variant>::processCommands() {
+    //Take every command at once, then restore the posting order
+    Command* list = mailbox.exchange(nullptr, std::memory_order_acquire);
+    Command* ordered = nullptr;
+    while(list) {
+        Command* next = list->next;
+        list->next = ordered;
+        ordered = list;
+        list = next;
+    }
+
+    while(ordered) {
+        Command* command = ordered;
+        ordered = ordered->next;
+
+        switch(command->type) {
+            case Command::PAUSE:
+                running.store(false, std::memory_order_release);
+                if(targetPending) reachTarget();
+                break;
+            case Command::RESUME:
+                if(targetPending) reachTarget();
+                target = std::numeric_limits<uint64_t>::max();
+                running.store(true, std::memory_order_release);
+                break;
+            case Command::STEP:
+                running.store(false, std::memory_order_release);
+                if(targetPending) reachTarget();
+                cpu.step();
+                break;
+            case Command::RUN_UNTIL:
+                //A previous runUntil() completes where the new one starts
+                if(targetPending) reachTarget();
+                target = command->cycle;
+                targetPending = true;
+                targetReached = std::move(command->done);
+                running.store(true, std::memory_order_release);
+                if(cpu.getCycles() >= target) reachTarget();
+                break;
+            case Command::STATE:
+                break;
+            case Command::QUIT:
+                running.store(false, std::memory_order_release);
+                if(targetPending) reachTarget();
+                quit = true;
+                break;
+        }
+
+        publish();
+        if(command->type != Command::RUN_UNTIL) {
+            command->done.set_value(cpu.getState());
+        }
+        delete command;
+    }
+}
+
+template<class Variant>
+void AsyncMachine<Variant>::reachTarget() {
+    running.store(false, std::memory_order_release);
+    target = std::numeric_limits<uint64_t>::max();
+    if(targetPending) {
+        targetPending = false;
+        targetReached.set_value(cpu.getState());
+    }
+}
+/********************/
+
+template class AsyncMachine<NMOS6502>;
+template class AsyncMachine<CMOS65C02>;
+template class AsyncMachine<RP2A03>;
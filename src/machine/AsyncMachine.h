@@ -0,0 +1,93 @@
+#ifndef ASYNC_MACHINE_H
+#define ASYNC_MACHINE_H
+
+#include <atomic>
+#include <future>
+#include <thread>
+#include <limits>
+#include <cstdint>
+#include "../cpu/MOS6502.h"
+#include "../bus/SPSCQueue.h"
+
+/*
+    Runs a CPU on its own thread.
+
+    The control functions never block the caller: they post a command
+    to a lock-free mailbox and return a future, fulfilled with the
+    registers at the time the command took effect. The CPU thread runs
+    batches of batchCycles cycles and only looks at the mailbox between
+    two batches (one atomic load), so commands take effect at a batch
+    boundary (or at once while paused).
+
+        AsyncMachine<NMOS6502> machine(cpu);
+        machine.runUntil(1000000).get();
+        machine.resume();
+        ...
+        CPUState state = machine.snapshot();
+        machine.pause().get();
+
+    snapshot() reads the registers published at the last batch
+    boundary without involving the CPU thread.
+
+    While the machine exists, the CPU, its memory and its devices belong
+    to the CPU thread: access them from traps/hooks/devices, or after
+    pause() has completed. The machine starts paused.
+*/
+template<class Variant>
+class AsyncMachine {
+public:
+    explicit AsyncMachine(MOS6502Core<Variant>& cpu, uint64_t batchCycles = 10000);
+    ~AsyncMachine();
+
+    AsyncMachine(AsyncMachine const &) = delete;
+    AsyncMachine& operator=(AsyncMachine const &) = delete;
+
+    std::future<CPUState> pause();
+    std::future<CPUState> resume();
+    //Execute one instruction, then pause
+    std::future<CPUState> stepAsync();
+    //Run until the cycle counter reaches cycle, then pause
+    std::future<CPUState> runUntil(uint64_t cycle);
+    //Registers at the next batch boundary
+    std::future<CPUState> state();
+
+    //Registers at the last batch boundary (never waits for the CPU)
+    CPUState snapshot() const;
+    bool isRunning() const;
+
+private:
+    struct Command {
+        enum Type { PAUSE, RESUME, STEP, RUN_UNTIL, STATE, QUIT } type;
+        uint64_t cycle;
+        std::promise<CPUState> done;
+        Command* next;
+    };
+
+    MOS6502Core<Variant>& cpu;
+    uint64_t batchCycles;
+
+    /**** Mailbox (lock-free stack of commands, LIFO) ****/
+    std::atomic<Command*> mailbox{nullptr};
+    Wakeup mailboxReady;
+
+    /**** CPU thread ****/
+    std::atomic<bool> running{false};
+    bool quit{false};
+    uint64_t target{std::numeric_limits<uint64_t>::max()};
+    std::promise<CPUState> targetReached;
+    bool targetPending{false};
+    std::thread thread;
+
+    /**** Snapshot (seqlock) ****/
+    std::atomic<uint32_t> sequence{0};
+    std::atomic<uint64_t> registers{0};     //PC, AC, X, Y, SR, SP
+    std::atomic<uint64_t> cycles{0};
+
+    std::future<CPUState> post(typename Command::Type type, uint64_t cycle = 0);
+    void run();
+    void processCommands();
+    void publish();
+    void reachTarget();
+};
+
+#endif
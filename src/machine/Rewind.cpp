@@ -0,0 +1,298 @@
+#include "Rewind.h"
+#include <algorithm>
+
+template<class Variant>
+Rewind<Variant>::Rewind(Memory& memory, fWrite const & ioWrite, fRead const & ioRead,
+                        uint64_t interval, std::size_t capacity):
+    memory{memory}, ioWrite{ioWrite}, ioRead{ioRead},
+    core{memory.pages(),
+         [this](uint16_t addr, uint8_t data) { busWrite(addr, data); },
+         [this](uint16_t addr) { return busRead(addr); }},
+    interval{interval ? interval : 1},
+    ring(capacity ? capacity : 1)
+{}
+
+template<class Variant>
+MOS6502Core<Variant>& Rewind<Variant>::cpu() {
+    return core;
+}
+
+/**** I/O ****/
+template<class Variant>
+uint8_t Rewind<Variant>::busRead(uint16_t addr) {
+    if(!stepping) return ioRead(addr);
+
+    if(replaying() && read - readBase < reads.size()) {
+        return reads[read++ - readBase];
+    }
+    uint32_t lines = core.events.irqLines();
+    uint8_t data = ioRead(addr);
+    reads.push_back(data);
+    ++read;
+    logLines(lines);
+    return data;
+}
+
+template<class Variant>
+void Rewind<Variant>::busWrite(uint16_t addr, uint8_t data) {
+    //The devices already saw the writes of the replayed instructions
+    if(stepping && replaying()) return;
+    uint32_t lines = core.events.irqLines();
+    ioWrite(addr, data);
+    if(stepping) logLines(lines);
+}
+
+template<class Variant>
+void Rewind<Variant>::logLines(uint32_t before) {
+    uint32_t lines = core.events.irqLines();
+    if(lines != before && !replaying()) log(Input::LINE_AFTER, lines);
+}
+/*************/
+
+/**** Execution ****/
+template<class Variant>
+void Rewind<Variant>::log(typename Input::Type type, uint32_t lines) {
+    inputs.push_back(Input{type, current, lines});
+    ++input;
+}
+
+template<class Variant>
+void Rewind<Variant>::replayInputs(bool after) {
+    while(input - inputBase < inputs.size()) {
+        Input const & i = inputs[input - inputBase];
+        if(i.position != current || (i.type == Input::LINE_AFTER) != after) break;
+        ++input;
+
+        switch(i.type) {
+            case Input::LINE_BEFORE:
+            case Input::LINE_AFTER:
+                core.scheduler().setIRQLines(i.lines);
+                break;
+            case Input::IRQ:
+                core.IRQ();
+                break;
+            case Input::NMI:
+                core.NMI();
+                break;
+        }
+    }
+}
+
+template<class Variant>
+void Rewind<Variant>::replayStep() {
+    replayInputs(false);
+    core.step();
+    replayInputs(true);
+    ++current;
+}
+
+template<class Variant>
+inline void Rewind<Variant>::liveStep() {
+    Scheduler& events = core.events;
+
+    if(core.cycles >= nextSnapshot) {
+        takeSnapshot();
+    }
+
+    //The events due now run before the instruction (as in step()),
+    //so their changes of the line are logged before it
+    if(core.cycles >= events.nextCycle()) {
+        uint32_t lines = events.irqLines();
+        events.runEvents();
+        if(events.irqLines() != lines) log(Input::LINE_BEFORE, events.irqLines());
+    }
+
+    //The changes made by the I/O accesses are logged by busRead/busWrite
+    core.step();
+    frontier = ++current;
+}
+
+template<class Variant>
+void Rewind<Variant>::step() {
+    stepping = true;
+    if(replaying()) replayStep();
+    else            liveStep();
+    stepping = false;
+}
+
+template<class Variant>
+bool Rewind<Variant>::run(uint64_t cycle) {
+    bool hit = false;
+    stepping = true;
+
+    while(!hit && core.cycles < cycle) {
+        if(replaying()) {
+            replayStep();
+            hit = breakpoints[core.PC];
+            continue;
+        }
+
+        //Snapshot and events due
+        liveStep();
+        hit = breakpoints[core.PC];
+
+        //Then only the breakpoints need watching, up to the next snapshot
+        //or event: the core runs its fast loop, counting the instructions
+        if(!hit) {
+            core.runUntil(std::min(cycle, nextSnapshot), breakpoints, current);
+            hit = breakpoints[core.PC];
+        }
+        frontier = current;
+    }
+
+    stepping = false;
+    return hit;
+}
+
+template<class Variant>
+void Rewind<Variant>::IRQ() {
+    if(replaying()) return;
+    log(Input::IRQ, 0);
+    core.IRQ();
+}
+
+template<class Variant>
+void Rewind<Variant>::NMI() {
+    if(replaying()) return;
+    log(Input::NMI, 0);
+    core.NMI();
+}
+
+template<class Variant>
+void Rewind<Variant>::setBreakpoint(uint16_t addr) {
+    breakpoints[addr] = 1;
+}
+
+template<class Variant>
+void Rewind<Variant>::removeBreakpoint(uint16_t addr) {
+    breakpoints[addr] = 0;
+}
+/*******************/
+
+/**** Snapshots ****/
+template<class Variant>
+typename Rewind<Variant>::Snapshot& Rewind<Variant>::snapshot(std::size_t i) {
+    return ring[(oldest + i) % ring.size()];
+}
+
+template<class Variant>
+void Rewind<Variant>::takeSnapshot() {
+    if(count == ring.size()) {
+        //Drop the oldest snapshot: the next one becomes the base, and
+        //the inputs only the oldest one needed go
+        oldest = (oldest + 1) % ring.size();
+        --count;
+        Snapshot& next = snapshot(0);
+        for(std::size_t i = 0; i < next.memory.pages.size(); ++i) {
+            std::copy_n(next.memory.data.begin() + (i << 8), 0x100, base.data.begin() + (next.memory.pages[i] << 8));
+        }
+        next.memory.pages.clear();
+        next.memory.data.clear();
+
+        reads.erase(reads.begin(), reads.begin() + (next.read - readBase));
+        readBase = next.read;
+        inputs.erase(inputs.begin(), inputs.begin() + (next.input - inputBase));
+        inputBase = next.input;
+    }
+
+    //The slots keep the capacity of their buffers: no allocation once
+    //the ring is full (and the deltas are as large as they get)
+    Snapshot& s = snapshot(count);
+    s.position = current;
+    s.state = core.getState();
+    s.irqLines = core.events.irqLines();
+    s.read = read;
+    s.input = input;
+    if(count == 0) {
+        memory.snapshot(base);
+        s.memory.pages.clear();
+        s.memory.data.clear();
+        s.memory.generation = base.generation;
+    } else {
+        memory.snapshot(s.memory, snapshot(count-1).memory.generation);
+    }
+    ++count;
+    nextSnapshot = core.cycles + interval;
+}
+
+template<class Variant>
+void Rewind<Variant>::restore(std::size_t i) {
+    memory.restore(base);
+    for(std::size_t j = 1; j <= i; ++j) {
+        memory.restore(snapshot(j).memory);
+    }
+
+    Snapshot const & s = snapshot(i);
+    core.setState(s.state);
+    core.events.setIRQLines(s.irqLines);
+    read = s.read;
+    input = s.input;
+    current = s.position;
+}
+
+template<class Variant>
+bool Rewind<Variant>::seek(uint64_t position) {
+    if(position > current || count == 0 || position < snapshot(0).position) return false;
+
+    //Latest snapshot at or before position
+    std::size_t i = count - 1;
+    while(snapshot(i).position > position) --i;
+
+    restore(i);
+    while(current < position) step();
+    return true;
+}
+
+template<class Variant>
+bool Rewind<Variant>::reverseStep() {
+    return current > 0 && seek(current - 1);
+}
+
+template<class Variant>
+bool Rewind<Variant>::reverseContinue() {
+    if(count == 0) return false;
+
+    //Search the intervals between snapshots from the latest one, back
+    //to the oldest
+    uint64_t end = current;
+    for(std::size_t i = count; i-- > 0;) {
+        Snapshot const & s = snapshot(i);
+        if(s.position >= end) continue;
+
+        restore(i);
+        bool found = false;
+        uint64_t hit = 0;
+        while(current < end) {
+            if(breakpoints[core.getPC()]) {
+                found = true;
+                hit = current;
+            }
+            step();
+        }
+        if(found) return seek(hit);
+        end = s.position;
+    }
+
+    seek(snapshot(0).position);
+    return false;
+}
+
+template<class Variant>
+uint64_t Rewind<Variant>::position() const {
+    return current;
+}
+
+template<class Variant>
+bool Rewind<Variant>::replaying() const {
+    return current < frontier;
+}
+
+template<class Variant>
+std::size_t Rewind<Variant>::snapshots() const {
+    return count;
+}
+/*******************/
+
+template class Rewind<NMOS6502>;
+template class Rewind<CMOS65C02>;
+template class Rewind<RP2A03>;
@@ -0,0 +1,141 @@
+#ifndef REWIND_H
+#define REWIND_H
+
+#include <functional>
+#include <bitset>
+#include <deque>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "../cpu/MOS6502.h"
+#include "../memory/Memory.h"
+
+/*
+    Reverse execution.
+
+    The rewinder owns a CPU bound to the page table of memory; the pages
+    without memory (I/O) go to ioWrite/ioRead. While it runs it takes a
+    snapshot (registers, IRQ line, RAM pages written since the previous
+    one) every interval cycles into a ring of capacity snapshots, and
+    logs the inputs that do not depend on the program: the values
+    returned by ioRead, the changes of the IRQ line made by the devices,
+    and IRQ()/NMI().
+
+    Time is counted in instructions (position()). Going back restores
+    the nearest snapshot and executes forward again up to the target,
+    with the inputs taken from the log instead of the devices (ioWrite
+    is not called either): the devices stay in the present. Execution
+    keeps replaying the log until it reaches the point where the
+    rewinder went back (replaying()), then it is live again.
+
+        Rewind<NMOS6502> rewind(memory, ioWrite, ioRead, 100000, 64);
+        rewind.cpu().setPC(0x0400);
+        rewind.setBreakpoint(0x1234);
+        rewind.run(50000000);
+        rewind.reverseStep();           //One instruction back
+        rewind.reverseContinue();       //Back to the previous breakpoint hit
+
+    Memory use: 64 KiB for the RAM at the oldest snapshot, the pages
+    written between the snapshots (at most capacity * 64 KiB) and the
+    log of the inputs since the oldest snapshot. Between two snapshots
+    or events run() leaves the core in its fast loop, which only checks
+    the breakpoints: the devices change the IRQ line in their events and
+    I/O accesses, where the changes are logged.
+
+    Requirements: the devices are only reached through ioWrite/ioRead
+    and the IRQ line (their scheduler events and code writing to memory
+    directly are not replayed), and the CPU must not be modified while
+    replaying. A snapshot does not include traps and hooks.
+*/
+template<class Variant>
+class Rewind {
+    using fWrite = std::function<void(uint16_t, uint8_t)>;
+    using fRead  = std::function<uint8_t(uint16_t)>;
+public:
+    Rewind(Memory& memory, fWrite const & ioWrite, fRead const & ioRead,
+           uint64_t interval, std::size_t capacity);
+
+    Rewind(Rewind const &) = delete;
+    Rewind& operator=(Rewind const &) = delete;
+
+    MOS6502Core<Variant>& cpu();
+
+    void step();
+    //Step until the cycle counter reaches cycle (false) or a breakpoint (true)
+    bool run(uint64_t cycle);
+    //External interrupts (ignored while replaying: the log has them)
+    void IRQ();
+    void NMI();
+
+    void setBreakpoint(uint16_t addr);
+    void removeBreakpoint(uint16_t addr);
+
+    //Back one instruction (false if older than the oldest snapshot)
+    bool reverseStep();
+    //Back to the last instruction at a breakpoint (false: stopped at the oldest snapshot)
+    bool reverseContinue();
+    //Go to an earlier instruction (false if older than the oldest snapshot)
+    bool seek(uint64_t position);
+
+    uint64_t position() const;
+    bool replaying() const;
+    std::size_t snapshots() const;
+
+private:
+    struct Snapshot {
+        uint64_t position;
+        CPUState state;
+        uint32_t irqLines;
+        uint64_t read;                  //Next read/input (absolute index)
+        uint64_t input;
+        MemorySnapshot memory;          //Pages written since the previous snapshot
+    };
+
+    struct Input {
+        enum Type : uint8_t { LINE_BEFORE, LINE_AFTER, IRQ, NMI } type;
+        uint64_t position;              //Instruction of the input
+        uint32_t lines;                 //IRQ line after the change
+    };
+
+    Memory& memory;
+    fWrite ioWrite;
+    fRead ioRead;
+    MOS6502Core<Variant> core;
+    uint64_t interval;
+
+    MemorySnapshot base;                //RAM at the oldest snapshot
+    std::vector<Snapshot> ring;
+    std::size_t oldest{0};
+    std::size_t count{0};
+
+    std::deque<uint8_t> reads;          //Values of ioRead
+    uint64_t readBase{0};               //Index of reads.front()
+    uint64_t read{0};
+    std::deque<Input> inputs;
+    uint64_t inputBase{0};
+    uint64_t input{0};
+
+    uint64_t current{0};                //Position
+    uint64_t frontier{0};               //First position not recorded
+    uint64_t nextSnapshot{0};           //Cycle
+    bool stepping{false};               //Only the reads of the program are logged
+
+    std::bitset<0x10000> breakpoints;
+
+    uint8_t busRead(uint16_t addr);
+    void busWrite(uint16_t addr, uint8_t data);
+
+    Snapshot& snapshot(std::size_t i);  //i-th from the oldest
+    void takeSnapshot();
+    void liveStep();
+    void replayStep();
+    //Base, then the deltas up to the i-th snapshot
+    void restore(std::size_t i);
+    //Apply the logged inputs of the current instruction (before/after it)
+    void replayInputs(bool after);
+    void log(typename Input::Type type, uint32_t lines);
+    //Log the change of the IRQ line made by an I/O access
+    void logLines(uint32_t before);
+};
+
+#endif
@@ -0,0 +1,162 @@
+#include "System.h"
+#include <thread>
+#include <condition_variable>
+#include <algorithm>
+
+namespace {
+
+//Reusable barrier for a fixed number of threads
+class Barrier {
+public:
+    explicit Barrier(unsigned count): count{count} {}
+
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex);
+        unsigned current = generation;
+        if(++arrived == count) {
+            arrived = 0;
+            ++generation;
+            condition.notify_all();
+        } else {
+            condition.wait(lock, [&] { return generation != current; });
+        }
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable condition;
+    unsigned count;
+    unsigned arrived{0};
+    unsigned generation{0};
+};
+
+}
+
+template<class Variant>
+System<Variant>::System(unsigned cores, uint64_t quantum):
+    quantum{std::max<uint64_t>(quantum, 1)}
+{
+    for(unsigned i = 0; i < cores; ++i) {
+        buses.push_back(std::make_unique<Bus>());
+        this->cores.push_back(std::make_unique<MOS6502Core<Variant>>(
+            [this, i](uint16_t addr, uint8_t data) { write(i, addr, data); },
+            [this, i](uint16_t addr) { return read(i, addr); }));
+    }
+}
+
+template<class Variant>
+MOS6502Core<Variant>& System<Variant>::core(unsigned index) {
+    return *cores[index];
+}
+
+template<class Variant>
+Bus& System<Variant>::bus(unsigned index) {
+    return *buses[index];
+}
+
+template<class Variant>
+unsigned System<Variant>::size() const {
+    return cores.size();
+}
+
+template<class Variant>
+void System<Variant>::share(uint16_t start, uint16_t end, Device& device) {
+    for(auto & b : buses) {
+        b->map(start, end, device);
+    }
+    for(unsigned page = start >> 8; page <= static_cast<unsigned>(end >> 8); ++page) {
+        sharedPages[page] = 1;
+    }
+}
+
+template<class Variant>
+void System<Variant>::setQuantum(uint64_t cycles) {
+    quantum = std::max<uint64_t>(cycles, 1);
+}
+
+template<class Variant>
+void System<Variant>::setThreaded(bool threaded) {
+    this->threaded = threaded;
+}
+
+/**** Memory ****/
+template<class Variant>
+uint8_t System<Variant>::read(unsigned index, uint16_t addr) {
+    if(threaded && sharedPages[addr >> 8]) {
+        std::lock_guard<std::mutex> lock(sharedLock);
+        return buses[index]->read(addr);
+    }
+    return buses[index]->read(addr);
+}
+
+template<class Variant>
+void System<Variant>::write(unsigned index, uint16_t addr, uint8_t data) {
+    if(threaded && sharedPages[addr >> 8]) {
+        std::lock_guard<std::mutex> lock(sharedLock);
+        buses[index]->write(addr, data);
+        return;
+    }
+    buses[index]->write(addr, data);
+}
+/****************/
+
+/**** Scheduling ****/
+template<class Variant>
+void System<Variant>::run(uint64_t cycles) {
+    if(threaded && cores.size() > 1) {
+        runThreaded(cycles);
+    } else {
+        runInterleaved(cycles);
+    }
+}
+
+template<class Variant>
+void System<Variant>::runInterleaved(uint64_t cycles) {
+    std::vector<uint64_t> end(cores.size());
+    for(unsigned i = 0; i < cores.size(); ++i) {
+        end[i] = cores[i]->getCycles() + cycles;
+    }
+
+    for(uint64_t elapsed = 0; elapsed < cycles; elapsed += quantum) {
+        uint64_t slice = std::min(quantum, cycles - elapsed);
+        for(unsigned i = 0; i < cores.size(); ++i) {
+            MOS6502Core<Variant>& cpu = *cores[i];
+            uint64_t target = end[i] - (cycles - elapsed - slice);
+            while(cpu.getCycles() < target) {
+                cpu.step();
+            }
+        }
+    }
+}
+
+template<class Variant>
+void System<Variant>::runThreaded(uint64_t cycles) {
+    Barrier barrier(cores.size());
+    std::vector<std::thread> threads;
+
+    for(unsigned i = 0; i < cores.size(); ++i) {
+        threads.emplace_back([this, i, cycles, &barrier] {
+            MOS6502Core<Variant>& cpu = *cores[i];
+            uint64_t end = cpu.getCycles() + cycles;
+
+            for(uint64_t elapsed = 0; elapsed < cycles; elapsed += quantum) {
+                uint64_t slice = std::min(quantum, cycles - elapsed);
+                uint64_t target = end - (cycles - elapsed - slice);
+                while(cpu.getCycles() < target) {
+                    cpu.step();
+                }
+                //Nobody starts the next quantum before everybody is done
+                barrier.wait();
+            }
+        });
+    }
+
+    for(auto & thread : threads) {
+        thread.join();
+    }
+}
+/********************/
+
+template class System<NMOS6502>;
+template class System<CMOS65C02>;
+template class System<RP2A03>;
@@ -0,0 +1,74 @@
+#ifndef SYSTEM_H
+#define SYSTEM_H
+
+#include <vector>
+#include <memory>
+#include <bitset>
+#include <mutex>
+#include <cstdint>
+#include "../cpu/MOS6502.h"
+#include "../bus/Bus.h"
+
+/*
+    Several CPUs sharing memory (e.g. a main CPU and an I/O processor).
+
+    Every core has its own Bus for its private memory and devices;
+    share() maps a device (usually a RAM) at the same addresses in the
+    buses of all the cores.
+
+        System<NMOS6502> board(2, 100);
+        board.bus(0).map(0xc000, 0xffff, mainROM);
+        board.bus(1).map(0xf000, 0xffff, iopROM);
+        board.share(0x4000, 0x47ff, sharedRAM);
+        board.run(1000000);
+
+    The cores run in turn for quantum cycles each, so two cores are
+    never more than one quantum apart: a small quantum orders the
+    accesses to shared memory accurately, a large one runs faster.
+
+    With setThreaded(true) every core runs on its own host thread; the
+    threads meet at a barrier at the end of every quantum (conservative
+    synchronisation: no core starts quantum n+1 before all of them have
+    finished quantum n), and the accesses to shared pages are
+    serialised. Inside a quantum the order of the shared accesses of
+    different cores is not deterministic.
+*/
+template<class Variant>
+class System {
+public:
+    System(unsigned cores, uint64_t quantum);
+
+    System(System const &) = delete;
+    System& operator=(System const &) = delete;
+
+    MOS6502Core<Variant>& core(unsigned index);
+    Bus& bus(unsigned index);
+    unsigned size() const;
+
+    //Map device at [start, end] in the bus of every core
+    void share(uint16_t start, uint16_t end, Device& device);
+
+    void setQuantum(uint64_t cycles);
+    void setThreaded(bool threaded);
+
+    //Run every core for the given number of cycles (rounded up to the
+    //end of the last instruction of each quantum)
+    void run(uint64_t cycles);
+
+private:
+    std::vector<std::unique_ptr<Bus>> buses;
+    std::vector<std::unique_ptr<MOS6502Core<Variant>>> cores;
+    uint64_t quantum;
+    bool threaded{false};
+
+    std::bitset<0x100> sharedPages;
+    std::mutex sharedLock;
+
+    uint8_t read(unsigned index, uint16_t addr);
+    void write(unsigned index, uint16_t addr, uint8_t data);
+
+    void runInterleaved(uint64_t cycles);
+    void runThreaded(uint64_t cycles);
+};
+
+#endif
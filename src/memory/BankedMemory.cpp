@@ -0,0 +1,97 @@
+#include "BankedMemory.h"
+
+namespace {
+
+//Whole pages, at least one
+std::size_t pagesOf(std::size_t size) {
+    std::size_t pages = (size + PageTable::PAGE_SIZE - 1) / PageTable::PAGE_SIZE;
+    return pages ? pages : 1;
+}
+
+}
+
+/**** BankedMemory ****/
+BankedMemory::BankedMemory(std::size_t size, std::size_t windowSize, bool hugePages):
+    store{(size + windowSize - 1) / windowSize * pagesOf(windowSize) * PageTable::PAGE_SIZE, hugePages},
+    bankSize{pagesOf(windowSize) * PageTable::PAGE_SIZE},
+    pagesPerWindow{static_cast<unsigned>(pagesOf(windowSize))},
+    bank(PageTable::PAGES / pagesPerWindow, banks()),
+    discard(bankSize)
+{}
+
+uint8_t BankedMemory::read(uint16_t offset) {
+    uint8_t* page{table.read[offset >> PageTable::PAGE_BITS]};
+    return page ? page[offset & PageTable::PAGE_MASK] : 0xff;
+}
+
+void BankedMemory::write(uint16_t offset, uint8_t data) {
+    uint8_t* page{table.write[offset >> PageTable::PAGE_BITS]};
+    if(page) page[offset & PageTable::PAGE_MASK] = data;
+}
+
+void BankedMemory::select(unsigned window, std::size_t bank, bool readOnly) {
+    if(window >= windows()) return;
+    bank %= banks();
+
+    this->bank[window] = bank;
+    uint8_t* memory = store.data() + bank * bankSize;
+    for(unsigned i = 0; i < pagesPerWindow; ++i) {
+        std::size_t page = window * pagesPerWindow + i;
+        std::size_t offset = i * PageTable::PAGE_SIZE;
+        table.read[page]  = memory + offset;
+        table.write[page] = (readOnly ? discard.data() : memory) + offset;
+    }
+}
+
+void BankedMemory::unmap(unsigned window) {
+    if(window >= windows()) return;
+
+    bank[window] = banks();
+    for(unsigned i = 0; i < pagesPerWindow; ++i) {
+        std::size_t page = window * pagesPerWindow + i;
+        table.read[page]  = nullptr;
+        table.write[page] = nullptr;
+    }
+}
+
+std::size_t BankedMemory::selected(unsigned window) const {
+    return window < windows() ? bank[window] : banks();
+}
+
+std::size_t BankedMemory::banks() const {
+    return store.size() / bankSize;
+}
+
+std::size_t BankedMemory::windows() const {
+    return bank.size();
+}
+
+std::size_t BankedMemory::windowSize() const {
+    return bankSize;
+}
+
+PageTable const & BankedMemory::pages() const {
+    return table;
+}
+
+uint8_t* BankedMemory::data() {
+    return store.data();
+}
+
+std::size_t BankedMemory::size() const {
+    return store.size();
+}
+/**********************/
+
+/**** BankRegisters ****/
+BankRegisters::BankRegisters(BankedMemory& memory, unsigned first, unsigned count, bool readOnly):
+    memory{memory}, first{first}, count{count}, readOnly{readOnly} {}
+
+uint8_t BankRegisters::read(uint16_t offset) {
+    return offset < count ? static_cast<uint8_t>(memory.selected(first + offset)) : 0xff;
+}
+
+void BankRegisters::write(uint16_t offset, uint8_t data) {
+    if(offset < count) memory.select(first + offset, data, readOnly);
+}
+/***********************/
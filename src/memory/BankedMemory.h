@@ -0,0 +1,91 @@
+#ifndef BANKEDMEMORY_H
+#define BANKEDMEMORY_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "Mapping.h"
+#include "../cpu/PageTable.h"
+#include "../bus/Device.h"
+
+/*
+    Bank-switched memory: a backing store larger than the address space
+    (cartridge ROM, banked RAM, up to several MiB) seen through windows
+    of windowSize bytes (0x1000 or 0x2000) of the 64 KiB address space.
+
+    Each window shows one bank (a windowSize slice of the store) or
+    nothing: select() only rewrites the pointers of the window in the
+    page table, so a bank switch costs the same whatever the bank size
+    and never copies data. Windows that show nothing are left to the
+    fRead/fWrite functions of the CPU, e.g. a Bus with the I/O devices
+    and the bank registers:
+
+        BankedMemory memory(1 << 20, 0x2000);
+        memory.select(0, 0);                //$0000-$1fff: RAM (bank 0)
+        memory.select(4, 8, true);          //$8000-$9fff: ROM (bank 8)
+        ...
+        BankRegisters banks(memory, 4, 1);  //Register 0 selects window 4
+        bus.map(0xc000, 0xc000, banks);
+
+        MOS6502 cpu(memory.pages(),
+            [&bus](uint16_t addr, uint8_t data) { bus.write(addr, data); },
+            [&bus](uint16_t addr) { return bus.read(addr); });
+
+    As a Device the memory serves the whole address space through the
+    page table (without direct pointers: they would outlive a switch).
+*/
+class BankedMemory : public Device {
+public:
+    BankedMemory(std::size_t size, std::size_t windowSize = PageTable::PAGE_SIZE, bool hugePages = false);
+
+    uint8_t read(uint16_t offset) override;
+    void write(uint16_t offset, uint8_t data) override;
+
+    //Show bank in window (writes ignored if readOnly)
+    void select(unsigned window, std::size_t bank, bool readOnly = false);
+    //Leave window to the functions of the CPU
+    void unmap(unsigned window);
+    //Bank shown in window (banks() if none)
+    std::size_t selected(unsigned window) const;
+
+    std::size_t banks() const;
+    std::size_t windows() const;
+    std::size_t windowSize() const;
+
+    //Page table to bind to a CPU
+    PageTable const & pages() const;
+
+    //Backing store (bank b starts at data() + b*windowSize())
+    uint8_t* data();
+    std::size_t size() const;
+
+private:
+    Mapping store;
+    std::size_t bankSize;
+    unsigned pagesPerWindow;
+    PageTable table;
+    std::vector<std::size_t> bank;                  //Per window
+    std::vector<uint8_t> discard;                   //Target of the read-only writes
+};
+
+/*
+    Bank registers: writing register i selects the bank (the value
+    modulo the number of banks) of window first+i, reading it returns
+    the selected bank. The registers are plain I/O, to be mapped on a
+    Bus.
+*/
+class BankRegisters : public Device {
+public:
+    BankRegisters(BankedMemory& memory, unsigned first, unsigned count, bool readOnly = false);
+
+    uint8_t read(uint16_t offset) override;
+    void write(uint16_t offset, uint8_t data) override;
+
+private:
+    BankedMemory& memory;
+    unsigned first;
+    unsigned count;
+    bool readOnly;
+};
+
+#endif
@@ -0,0 +1,150 @@
+#include "Dump.h"
+#include "Memory.h"
+#include "../analysis/Format.h"
+#include <array>
+#include <cstring>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+//Two hex digits and the printable char of every byte
+struct ByteText {
+    char hex[2];
+    char ascii;
+};
+
+constexpr std::array<ByteText, 256> byteTexts() {
+    std::array<ByteText, 256> texts{};
+    for(int byte = 0; byte < 256; ++byte) {
+        texts[byte] = ByteText{{Format::HEX[byte >> 4], Format::HEX[byte & 0x0f]},
+                               static_cast<char>(byte >= 0x20 && byte <= 0x7e ? byte : '.')};
+    }
+    return texts;
+}
+
+constexpr std::array<ByteText, 256> BYTE_TEXT = byteTexts();
+
+//Columns of a line
+constexpr std::size_t HEX_COLUMN{6};
+constexpr std::size_t ASCII_COLUMN{57};
+
+constexpr std::size_t hexColumn(std::size_t i) {
+    return HEX_COLUMN + 3*i + (i >= 8);
+}
+
+char* line(char* out, uint16_t addr, uint8_t const * data, std::size_t size) {
+    std::memset(out, ' ', DUMP_LINE);
+    std::memcpy(out + 0, BYTE_TEXT[addr >> 8].hex, 2);
+    std::memcpy(out + 2, BYTE_TEXT[addr & 0xff].hex, 2);
+    for(std::size_t i = 0; i < size; ++i) {
+        ByteText const & text = BYTE_TEXT[data[i]];
+        std::memcpy(out + hexColumn(i), text.hex, 2);
+        out[ASCII_COLUMN + i] = text.ascii;
+    }
+    out[ASCII_COLUMN - 1] = '|';
+    out[ASCII_COLUMN + 16] = '|';
+    out[DUMP_LINE - 1] = '\n';
+    return out + DUMP_LINE;
+}
+
+//Builds the list of ranges, merging the adjacent ones
+class Ranges {
+public:
+    explicit Ranges(std::vector<MemoryRange>& ranges): ranges{ranges} {}
+
+    void add(uint32_t start, uint32_t size) {
+        if(size == 0) return;
+        if(!ranges.empty() && ranges.back().start + ranges.back().size == start) {
+            ranges.back().size += size;
+        } else {
+            ranges.push_back(MemoryRange{start, size});
+        }
+    }
+
+    //Bits of mask (bit i: byte start+i differs)
+    void add(uint32_t start, uint32_t mask, unsigned bits) {
+        unsigned i = 0;
+        while(i < bits) {
+            if(!(mask >> i & 1)) {
+                ++i;
+                continue;
+            }
+            unsigned first = i;
+            while(i < bits && (mask >> i & 1)) ++i;
+            add(start + first, i - first);
+        }
+    }
+
+private:
+    std::vector<MemoryRange>& ranges;
+};
+
+void compare(uint8_t const * a, uint8_t const * b, std::size_t size, uint32_t base, Ranges& ranges) {
+    std::size_t i = 0;
+
+#ifdef __SSE2__
+    for(; i + 16 <= size; i += 16) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<__m128i const *>(a + i));
+        __m128i y = _mm_loadu_si128(reinterpret_cast<__m128i const *>(b + i));
+        uint32_t mask = ~_mm_movemask_epi8(_mm_cmpeq_epi8(x, y)) & 0xffff;
+        if(mask == 0) continue;
+        if(mask == 0xffff) ranges.add(base + i, 16);
+        else               ranges.add(base + i, mask, 16);
+    }
+#endif
+
+    for(; i + 8 <= size; i += 8) {
+        uint64_t x, y;
+        std::memcpy(&x, a + i, 8);
+        std::memcpy(&y, b + i, 8);
+        if(x == y) continue;
+        uint32_t mask = 0;
+        for(unsigned j = 0; j < 8; ++j) mask |= (a[i+j] != b[i+j]) << j;
+        ranges.add(base + i, mask, 8);
+    }
+
+    for(; i < size; ++i) {
+        if(a[i] != b[i]) ranges.add(base + i, 1);
+    }
+}
+
+}
+
+std::size_t hexDump(uint8_t const * data, std::size_t size, uint16_t base, char* out) {
+    char* start = out;
+    for(std::size_t offset = 0; offset < size; offset += 16) {
+        std::size_t length = size - offset < 16 ? size - offset : 16;
+        out = line(out, base + offset, data + offset, length);
+    }
+    return out - start;
+}
+
+std::vector<MemoryRange> diff(uint8_t const * a, uint8_t const * b, std::size_t size, uint32_t base) {
+    std::vector<MemoryRange> result;
+    Ranges ranges(result);
+    compare(a, b, size, base, ranges);
+    return result;
+}
+
+std::vector<MemoryRange> diff(MemorySnapshot const & a, MemorySnapshot const & b) {
+    std::vector<MemoryRange> result;
+    Ranges ranges(result);
+
+    //The pages of a snapshot are in ascending order
+    std::size_t i = 0, j = 0;
+    while(i < a.pages.size() || j < b.pages.size()) {
+        if(j == b.pages.size() || (i < a.pages.size() && a.pages[i] < b.pages[j])) {
+            ranges.add(a.pages[i++] << 8, 0x100);
+        } else if(i == a.pages.size() || b.pages[j] < a.pages[i]) {
+            ranges.add(b.pages[j++] << 8, 0x100);
+        } else {
+            compare(a.data.data() + (i << 8), b.data.data() + (j << 8), 0x100, a.pages[i] << 8, ranges);
+            ++i;
+            ++j;
+        }
+    }
+
+    return result;
+}
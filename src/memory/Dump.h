@@ -0,0 +1,51 @@
+#ifndef DUMP_H
+#define DUMP_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+struct MemorySnapshot;
+
+/*
+    Hex/ASCII dump of a memory image, 16 bytes per line, written into
+    a caller buffer of at least dumpSize(size) bytes (no allocation):
+
+        0200  a9 10 a5 30 85 31 00 00  00 00 00 00 00 00 00 00  |...0.1..........|
+
+    The bytes outside 0x20-0x7e show as '.'. Lines start at base and
+    every 16 bytes after it; the last one is padded with spaces.
+*/
+constexpr std::size_t DUMP_LINE{75};
+
+constexpr std::size_t dumpSize(std::size_t size) {
+    return (size + 15) / 16 * DUMP_LINE;
+}
+
+//Returns the number of chars written
+std::size_t hexDump(uint8_t const * data, std::size_t size, uint16_t base, char* out);
+
+/*
+    Ranges of bytes that differ between two images, in address order
+    (adjacent differences are merged). The images are compared 16 bytes
+    at a time with SSE2 when available, 8 bytes at a time otherwise.
+*/
+struct MemoryRange {
+    uint32_t start;
+    uint32_t size;
+
+    bool operator==(MemoryRange const & other) const {
+        return start == other.start && size == other.size;
+    }
+};
+
+std::vector<MemoryRange> diff(uint8_t const * a, uint8_t const * b, std::size_t size, uint32_t base = 0);
+
+/*
+    Ranges that differ between two snapshots (see Memory::snapshot()),
+    compared page by page: a page stored in only one of them counts as
+    changed whole.
+*/
+std::vector<MemoryRange> diff(MemorySnapshot const & a, MemorySnapshot const & b);
+
+#endif
@@ -0,0 +1,360 @@
+#include "Loader.h"
+#include "Memory.h"
+#include <array>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr std::size_t BUFFER_SIZE{1 << 16};
+
+//Value of the hex digits, -1 for the other chars
+constexpr std::array<int8_t, 256> hexDigits() {
+    std::array<int8_t, 256> digits{};
+    for(int c = 0; c < 256; ++c) {
+        digits[c] = (c >= '0' && c <= '9') ? c - '0' :
+                    (c >= 'a' && c <= 'f') ? c - 'a' + 10 :
+                    (c >= 'A' && c <= 'F') ? c - 'A' + 10 : -1;
+    }
+    return digits;
+}
+
+constexpr std::array<int8_t, 256> HEX_DIGIT = hexDigits();
+
+bool isSpace(int c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\v' || c == '\f';
+}
+
+/*
+    Input of the parsers: a buffer, refilled from fd (if any) when
+    consumed. next() returns -1 at the end of the input.
+*/
+class Input {
+public:
+    Input(int fd, uint8_t* buffer):
+        fd{fd}, buffer{buffer}, pos{buffer}, end{buffer} {}
+    Input(uint8_t const * data, std::size_t size):
+        fd{-1}, buffer{nullptr}, pos{data}, end{data + size} {}
+
+    int next() {
+        if(pos == end && !refill()) return -1;
+        return *pos++;
+    }
+
+    int peek() {
+        if(pos == end && !refill()) return -1;
+        return *pos;
+    }
+
+    //Bytes available without reading (refilled if none)
+    std::size_t available() {
+        if(pos == end) refill();
+        return end - pos;
+    }
+
+    uint8_t const * data() const { return pos; }
+    void skip(std::size_t size) { pos += size; }
+
+    bool failed() const { return error; }
+
+private:
+    int fd;
+    uint8_t* buffer;
+    uint8_t const * pos;
+    uint8_t const * end;
+    bool error{false};
+
+    bool refill() {
+        if(fd < 0) return false;
+        ssize_t n;
+        do {
+            n = ::read(fd, buffer, BUFFER_SIZE);
+        } while(n < 0 && errno == EINTR);
+        if(n <= 0) {
+            error = n < 0;
+            return false;
+        }
+        pos = buffer;
+        end = buffer + n;
+        return true;
+    }
+};
+
+//Two hex digits, -1 if malformed
+int hexByte(Input& in) {
+    int high = in.next();
+    int low = in.next();
+    if(high < 0 || low < 0 || HEX_DIGIT[high] < 0 || HEX_DIGIT[low] < 0) return -1;
+    return (HEX_DIGIT[high] << 4) | HEX_DIGIT[low];
+}
+
+//Skip the whitespace before a record, counting the lines
+void skipSpace(Input& in, LoadResult& result) {
+    for(int c = in.peek(); c >= 0 && isSpace(c); c = in.peek()) {
+        if(c == '\n') ++result.line;
+        in.skip(1);
+    }
+}
+
+LoadResult& fail(LoadResult& result, Input const & in, LoadError error) {
+    result.error = in.failed() ? LoadError::read : error;
+    return result;
+}
+
+bool store(LoadTarget& target, LoadResult& result, uint32_t addr, uint8_t const * data, std::size_t size) {
+    if(size == 0) return true;
+    if(!target.store(addr, data, size)) {
+        result.error = LoadError::range;
+        return false;
+    }
+    result.bytes += size;
+    return true;
+}
+
+/**** Formats ****/
+LoadResult loadHex(Input& in, LoadTarget& target, uint32_t addr) {
+    LoadResult result;
+    result.line = 1;
+    uint8_t chunk[4096];
+    std::size_t used = 0;
+
+    for(;;) {
+        skipSpace(in, result);
+        if(in.peek() < 0) break;
+
+        //Exactly two digits per byte
+        int byte = hexByte(in);
+        int next = in.peek();
+        if(byte < 0 || (next >= 0 && !isSpace(next))) return fail(result, in, LoadError::syntax);
+
+        chunk[used++] = byte;
+        if(used == sizeof(chunk)) {
+            if(!store(target, result, addr, chunk, used)) return result;
+            addr += used;
+            used = 0;
+        }
+    }
+    if(in.failed()) return fail(result, in, LoadError::read);
+
+    store(target, result, addr, chunk, used);
+    return result;
+}
+
+LoadResult loadRaw(Input& in, LoadTarget& target, uint32_t addr) {
+    LoadResult result;
+
+    for(std::size_t size = in.available(); size > 0; size = in.available()) {
+        if(!store(target, result, addr, in.data(), size)) return result;
+        in.skip(size);
+        addr += size;
+    }
+    if(in.failed()) return fail(result, in, LoadError::read);
+
+    return result;
+}
+
+LoadResult loadPRG(Input& in, LoadTarget& target) {
+    LoadResult result;
+
+    int low = in.next();
+    int high = in.next();
+    if(high < 0) return fail(result, in, LoadError::syntax);
+
+    result = loadRaw(in, target, low | (high << 8));
+    result.entry = low | (high << 8);
+    result.hasEntry = true;
+    return result;
+}
+
+LoadResult loadIntelHex(Input& in, LoadTarget& target) {
+    LoadResult result;
+    result.line = 1;
+    uint32_t base = 0;          //Extended segment/linear address
+    uint8_t data[255];
+
+    for(;;) {
+        skipSpace(in, result);
+        if(in.next() != ':') return fail(result, in, LoadError::syntax);
+
+        //:LLAAAATT<data>CC
+        int header[4];
+        for(int& byte : header) {
+            byte = hexByte(in);
+            if(byte < 0) return fail(result, in, LoadError::syntax);
+        }
+        int length = header[0];
+        uint16_t offset = (header[1] << 8) | header[2];
+        int type = header[3];
+        uint8_t sum = header[0] + header[1] + header[2] + header[3];
+
+        for(int i = 0; i < length; ++i) {
+            int byte = hexByte(in);
+            if(byte < 0) return fail(result, in, LoadError::syntax);
+            data[i] = byte;
+            sum += byte;
+        }
+        int checksum = hexByte(in);
+        int next = in.peek();
+        if(checksum < 0 || (next >= 0 && !isSpace(next))) return fail(result, in, LoadError::syntax);
+        if(static_cast<uint8_t>(sum + checksum) != 0) return fail(result, in, LoadError::checksum);
+
+        switch(type) {
+            case 0x00:
+                if(!store(target, result, base + offset, data, length)) return result;
+                break;
+            case 0x01:
+                return result;
+            case 0x02:
+                if(length != 2) return fail(result, in, LoadError::syntax);
+                base = ((data[0] << 8) | data[1]) << 4;
+                break;
+            case 0x03:
+                if(length != 4) return fail(result, in, LoadError::syntax);
+                result.entry = (((data[0] << 8) | data[1]) << 4) + ((data[2] << 8) | data[3]);
+                result.hasEntry = true;
+                break;
+            case 0x04:
+                if(length != 2) return fail(result, in, LoadError::syntax);
+                base = static_cast<uint32_t>((data[0] << 8) | data[1]) << 16;
+                break;
+            case 0x05:
+                if(length != 4) return fail(result, in, LoadError::syntax);
+                result.entry = (static_cast<uint32_t>(data[0]) << 24) | (data[1] << 16) | (data[2] << 8) | data[3];
+                result.hasEntry = true;
+                break;
+            default:
+                return fail(result, in, LoadError::syntax);
+        }
+    }
+}
+
+LoadResult loadSRecord(Input& in, LoadTarget& target) {
+    LoadResult result;
+    result.line = 1;
+    uint32_t records = 0;       //Data records, for S5/S6
+    uint8_t data[255];
+
+    for(;;) {
+        skipSpace(in, result);
+        int s = in.next();
+        int type = in.next();
+        if(s != 'S' || type < '0' || type > '9' || type == '4') return fail(result, in, LoadError::syntax);
+        type -= '0';
+
+        //Stype<count><address><data><checksum>, count from the address
+        int count = hexByte(in);
+        if(count < 0) return fail(result, in, LoadError::syntax);
+        uint8_t sum = count;
+        for(int i = 0; i < count; ++i) {
+            int byte = hexByte(in);
+            if(byte < 0) return fail(result, in, LoadError::syntax);
+            data[i] = byte;
+            sum += byte;
+        }
+        int next = in.peek();
+        if(count == 0 || (next >= 0 && !isSpace(next))) return fail(result, in, LoadError::syntax);
+        //The checksum (last byte) complements the sum of the others
+        if(static_cast<uint8_t>(sum - data[count-1]) != static_cast<uint8_t>(~data[count-1])) {
+            return fail(result, in, LoadError::checksum);
+        }
+
+        static constexpr int ADDRESS[10] = {2, 2, 3, 4, 0, 2, 3, 4, 3, 2};
+        int size = ADDRESS[type];
+        if(count < size + 1) return fail(result, in, LoadError::syntax);
+        uint32_t address = 0;
+        for(int i = 0; i < size; ++i) {
+            address = (address << 8) | data[i];
+        }
+
+        switch(type) {
+            case 0:     //Header
+                break;
+            case 1: case 2: case 3:
+                if(!store(target, result, address, data + size, count - size - 1)) return result;
+                ++records;
+                break;
+            case 5: case 6:
+                if(address != records) return fail(result, in, LoadError::checksum);
+                break;
+            default:    //7, 8, 9: termination
+                result.entry = address;
+                result.hasEntry = true;
+                return result;
+        }
+    }
+}
+/*****************/
+
+LoadResult load(LoadFormat format, Input& in, LoadTarget& target, uint32_t addr) {
+    switch(format) {
+        case LoadFormat::hex:      return loadHex(in, target, addr);
+        case LoadFormat::binary:   return loadRaw(in, target, addr);
+        case LoadFormat::intelHex: return loadIntelHex(in, target);
+        case LoadFormat::sRecord:  return loadSRecord(in, target);
+        case LoadFormat::prg:      return loadPRG(in, target);
+    }
+    return LoadResult{LoadError::syntax};
+}
+
+}
+
+char const * loadErrorName(LoadError error) {
+    switch(error) {
+        case LoadError::none:     return "no error";
+        case LoadError::open:     return "couldn't open file";
+        case LoadError::read:     return "read error";
+        case LoadError::syntax:   return "syntax error";
+        case LoadError::checksum: return "checksum mismatch";
+        case LoadError::range:    return "address out of range";
+    }
+    return "unknown error";
+}
+
+/**** Targets ****/
+MemoryTarget::MemoryTarget(Memory& memory): memory{memory} {}
+
+bool MemoryTarget::store(uint32_t addr, uint8_t const * data, std::size_t size) {
+    while(size > 0) {
+        uint16_t start = addr;
+        std::size_t room = SIZE - start;
+        std::size_t part = size < room ? size : room;
+        std::memcpy(memory.data() + start, data, part);
+        memory.markDirty(start, part);
+        addr += part;
+        data += part;
+        size -= part;
+    }
+    return true;
+}
+
+BufferTarget::BufferTarget(uint8_t* data, std::size_t size, uint32_t base):
+    buffer{data}, size{size}, base{base} {}
+
+bool BufferTarget::store(uint32_t addr, uint8_t const * data, std::size_t size) {
+    if(addr < base || addr - base > this->size || size > this->size - (addr - base)) return false;
+    std::memcpy(buffer + (addr - base), data, size);
+    return true;
+}
+/*****************/
+
+LoadResult load(LoadFormat format, int fd, LoadTarget& target, uint32_t addr) {
+    uint8_t buffer[BUFFER_SIZE];
+    Input in(fd, buffer);
+    return load(format, in, target, addr);
+}
+
+LoadResult load(LoadFormat format, uint8_t const * data, std::size_t size, LoadTarget& target, uint32_t addr) {
+    Input in(data, size);
+    return load(format, in, target, addr);
+}
+
+LoadResult loadFile(LoadFormat format, std::string const & fileName, LoadTarget& target, uint32_t addr) {
+    int fd = ::open(fileName.c_str(), O_RDONLY);
+    if(fd < 0) return LoadResult{LoadError::open};
+
+    LoadResult result = load(format, fd, target, addr);
+    ::close(fd);
+    return result;
+}
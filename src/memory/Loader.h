@@ -0,0 +1,105 @@
+#ifndef LOADER_H
+#define LOADER_H
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+class Memory;
+
+/*
+    Streaming program loaders.
+
+    The input is parsed as it is read (64 KiB at a time from a file
+    descriptor, so files and pipes work the same) or straight from a
+    buffer, without allocating. Errors are returned, never fatal:
+
+        MemoryTarget target(memory);
+        LoadResult result = loadFile(LoadFormat::intelHex, "rom.hex", target);
+        if(!result) {
+            std::cout << "ERROR: " << loadErrorName(result.error)
+                      << " at line " << result.line << "\n";
+        }
+
+    Formats:
+     - hex:      whitespace-separated hex bytes ("A9 10 a5 30") at addr
+     - binary:   raw bytes at addr
+     - intelHex: Intel HEX records (extended segment/linear addresses,
+                 start address as entry), checksums verified, the
+                 end-of-file record is required
+     - sRecord:  Motorola S-records (S1/S2/S3 data, S7/S8/S9 entry,
+                 S5/S6 record count), checksums and count verified, the
+                 termination record is required
+     - prg:      C64 PRG: 2-byte little-endian load address (used as
+                 entry), then raw bytes; addr is ignored
+*/
+enum class LoadFormat {
+    hex,
+    binary,
+    intelHex,
+    sRecord,
+    prg
+};
+
+enum class LoadError {
+    none,
+    open,           //Cannot open the file
+    read,           //Read error
+    syntax,         //Malformed or truncated input
+    checksum,       //Record checksum (or S5/S6 count) mismatch
+    range           //Address outside the target
+};
+
+struct LoadResult {
+    LoadError error{LoadError::none};
+    std::size_t line{0};        //Line of the error (text formats)
+    std::size_t bytes{0};       //Bytes stored
+    uint32_t entry{0};          //Start address (if hasEntry)
+    bool hasEntry{false};
+
+    explicit operator bool() const { return error == LoadError::none; }
+};
+
+char const * loadErrorName(LoadError error);
+
+/*
+    Destination of the loaded bytes. Addresses are linear: Intel HEX
+    and S-records address more than 64 KiB.
+*/
+class LoadTarget {
+public:
+    virtual ~LoadTarget() = default;
+
+    //Store size bytes at addr, false if out of range
+    virtual bool store(uint32_t addr, uint8_t const * data, std::size_t size) = 0;
+};
+
+//RAM of a Memory: addresses wrap around at 64 KiB
+class MemoryTarget : public LoadTarget {
+public:
+    explicit MemoryTarget(Memory& memory);
+
+    bool store(uint32_t addr, uint8_t const * data, std::size_t size) override;
+
+private:
+    Memory& memory;
+};
+
+//Buffer of size bytes seen at [base, base+size), e.g. a banked store
+class BufferTarget : public LoadTarget {
+public:
+    BufferTarget(uint8_t* data, std::size_t size, uint32_t base = 0);
+
+    bool store(uint32_t addr, uint8_t const * data, std::size_t size) override;
+
+private:
+    uint8_t* buffer;
+    std::size_t size;
+    uint32_t base;
+};
+
+LoadResult load(LoadFormat format, int fd, LoadTarget& target, uint32_t addr = 0);
+LoadResult load(LoadFormat format, uint8_t const * data, std::size_t size, LoadTarget& target, uint32_t addr = 0);
+LoadResult loadFile(LoadFormat format, std::string const & fileName, LoadTarget& target, uint32_t addr = 0);
+
+#endif
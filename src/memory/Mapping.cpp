@@ -0,0 +1,34 @@
+#include "Mapping.h"
+#include <new>
+#include <sys/mman.h>
+
+Mapping::Mapping(std::size_t size, bool hugePages):
+    area{nullptr}, length{size}, mapped{size}, hugePages{false}
+{
+    void* address{MAP_FAILED};
+#ifdef MAP_HUGETLB
+    if(hugePages) {
+        std::size_t rounded = (size + HUGE_PAGE - 1) / HUGE_PAGE * HUGE_PAGE;
+        address = mmap(nullptr, rounded, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if(address != MAP_FAILED) {
+            mapped = rounded;
+            this->hugePages = true;
+        }
+    }
+#endif
+    //No huge page reserved (or not requested): normal pages
+    if(address == MAP_FAILED) {
+        address = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if(address == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+    }
+
+    area = static_cast<uint8_t*>(address);
+}
+
+Mapping::~Mapping() {
+    munmap(area, mapped);
+}
@@ -0,0 +1,34 @@
+#ifndef MAPPING_H
+#define MAPPING_H
+
+#include <cstdint>
+#include <cstddef>
+
+/*
+    Anonymous memory mapping: page aligned and zeroed. With
+    hugePages = true the mapping is backed by huge pages (rounded up to
+    a multiple of HUGE_PAGE) when the kernel has enough reserved, by
+    normal pages otherwise. Throws std::bad_alloc if out of memory.
+*/
+class Mapping {
+public:
+    static constexpr std::size_t HUGE_PAGE{2 << 20};
+
+    Mapping(std::size_t size, bool hugePages);
+    ~Mapping();
+
+    Mapping(Mapping const &) = delete;
+    Mapping& operator=(Mapping const &) = delete;
+
+    uint8_t* data() const { return area; }
+    std::size_t size() const { return length; }
+    bool usesHugePages() const { return hugePages; }
+
+private:
+    uint8_t* area;
+    std::size_t length;
+    std::size_t mapped;         //length rounded up to the page size
+    bool hugePages;
+};
+
+#endif
@@ -1,92 +1,161 @@
 #include "Memory.h"
-#include <fstream>
-#include <iostream>
-#include <sstream>
-#include <iomanip>
-
-static uint8_t memory[SIZE] = {0};
-
-/*
-    Convert an hex byte string to an integer
-*/
-static uint8_t strToByte(std::string str) {
-    uint8_t byte = 0x00;
-
-    for(int i = 0; i < 2; ++i) {
-        if(str[i] >= '0' && str[i] <= '9') {
-            byte += (str[i] - '0')*((1-i)*15+1);
-        }
-        else if(str[i] >= 'A' && str[i] <= 'F') {
-            byte += (str[i] - 'A' + 10)*((1-i)*15+1);
-        }
-        else {
-            std::cout << "ERROR: couldn't load program\n";
-            exit(1);
-        }
+#include "../analysis/Format.h"
+#include <cstring>
+
+Memory::Memory(bool hugePages):
+    mapping{SIZE + PageTable::PAGE_SIZE, hugePages},
+    memory{mapping.data()}, discard{mapping.data() + SIZE}
+{
+    mapRAM(0x0000, SIZE);
+}
+
+bool Memory::mapROM(uint16_t addr, ROMImage const & image) {
+    if(!image.isOpen() || (addr & PageTable::PAGE_MASK) != 0) return false;
+
+    std::size_t first = addr >> PageTable::PAGE_BITS;
+    std::size_t count = (image.size() + PageTable::PAGE_SIZE - 1) >> PageTable::PAGE_BITS;
+    for(std::size_t i = 0; i < count && first + i < PageTable::PAGES; ++i) {
+        //Read-only mapping: the table never writes through the read pointers
+        table.read[first + i] = const_cast<uint8_t*>(image.data()) + i*PageTable::PAGE_SIZE;
+        table.write[first + i] = discard;
     }
 
-    return byte;
+    return true;
 }
 
-void memoryWrite(uint16_t addr, uint8_t data) {
-    memory[addr] = data;
+void Memory::mapIO(uint16_t addr, std::size_t size) {
+    std::size_t first = addr >> PageTable::PAGE_BITS;
+    std::size_t last = (addr + size + PageTable::PAGE_SIZE - 1) >> PageTable::PAGE_BITS;
+    for(std::size_t page = first; page < last && page < PageTable::PAGES; ++page) {
+        table.read[page] = table.write[page] = nullptr;
+    }
 }
 
-uint8_t memoryRead(uint16_t addr) {
-    return memory[addr];
+void Memory::mapRAM(uint16_t addr, std::size_t size) {
+    std::size_t first = addr >> PageTable::PAGE_BITS;
+    std::size_t last = (addr + size + PageTable::PAGE_SIZE - 1) >> PageTable::PAGE_BITS;
+    for(std::size_t page = first; page < last && page < PageTable::PAGES; ++page) {
+        table.read[page] = table.write[page] = memory + page*PageTable::PAGE_SIZE;
+    }
 }
 
-void loadFromFileHex(uint16_t addr, std::string fileName) {
-    std::ifstream file(fileName);
-    
-    if(!file) {
-        std::cout << "ERROR: couldn't open file\n";
-        exit(1);
+/**** Dirty pages ****/
+void Memory::markDirty(uint16_t addr, std::size_t size) {
+    if(size == 0) return;
+
+    std::size_t pages = ((addr & 0xff) + size + 0xff) >> 8;
+    for(std::size_t i = 0; i < pages && i < 0x100; ++i) {
+        table.markDirty(static_cast<uint16_t>(addr + (i << 8)));
     }
+}
 
-    std::string charByte;
+uint32_t Memory::sync() {
+    bool dirty = false;
+    for(uint64_t word : table.dirty) dirty = dirty || word;
+    if(!dirty) return current;
 
-    while(file >> charByte) {
-        memory[addr++] = strToByte(charByte);
+    ++current;
+    for(unsigned i = 0; i < table.dirty.size(); ++i) {
+        for(uint64_t bits = table.dirty[i]; bits; bits &= bits - 1) {
+            generations[i*64 + __builtin_ctzll(bits)] = current;
+        }
+        table.dirty[i] = 0;
     }
+    return current;
+}
 
-    file.close();
+void Memory::setBaseline() {
+    baseline.assign(memory, memory + SIZE);
+    baselineGeneration = sync();
 }
 
-void loadFromFileBin(uint16_t addr, std::string fileName) {
-    std::ifstream file(fileName, std::ios::binary);
+std::size_t Memory::resetToBaseline() {
+    if(baseline.empty()) return 0;
 
-    if(!file) {
-        std::cout << "ERROR: couldn't open file\n";
-        exit(1);
+    sync();
+    std::size_t restored = 0;
+    for(unsigned page = 0; page < 0x100; ++page) {
+        if(generations[page] > baselineGeneration) {
+            std::memcpy(memory + (page << 8), baseline.data() + (page << 8), 0x100);
+            table.markDirty(page << 8);
+            ++restored;
+        }
     }
+    //The restored pages are equal to the baseline again
+    baselineGeneration = sync();
+    return restored;
+}
 
-    uint8_t buffer[SIZE];
+void Memory::copyPages(MemorySnapshot& out, uint32_t since, bool all) {
+    out.generation = sync();
+    out.pages.clear();
+    out.data.clear();
+    for(unsigned page = 0; page < 0x100; ++page) {
+        if(all || generations[page] > since) {
+            out.pages.push_back(page);
+            out.data.insert(out.data.end(), memory + (page << 8), memory + (page << 8) + 0x100);
+        }
+    }
+}
 
-    file.read((char*)buffer,SIZE);
-    size_t byteRead = file.gcount();
+void Memory::snapshot(MemorySnapshot& out) {
+    copyPages(out, 0, true);
+}
 
-    for(size_t i = 0; i < byteRead; ++i) {
-        memory[addr++] = buffer[i];
+void Memory::snapshot(MemorySnapshot& out, uint32_t since) {
+    copyPages(out, since, false);
+}
+
+void Memory::restore(MemorySnapshot const & snapshot) {
+    for(std::size_t i = 0; i < snapshot.pages.size(); ++i) {
+        uint16_t addr = snapshot.pages[i] << 8;
+        std::memcpy(memory + addr, snapshot.data.data() + (i << 8), 0x100);
+        table.markDirty(addr);
     }
+}
+/***********************/
 
-    file.close();
+LoadResult Memory::loadFromFileHex(uint16_t addr, std::string const & fileName) {
+    MemoryTarget target(*this);
+    return loadFile(LoadFormat::hex, fileName, target, addr);
 }
 
-std::string memoryDump(uint16_t start, uint16_t end) {
-    std::ostringstream out;
+LoadResult Memory::loadFromFileBin(uint16_t addr, std::string const & fileName) {
+    MemoryTarget target(*this);
+    return loadFile(LoadFormat::binary, fileName, target, addr);
+}
+
+std::string Memory::dump(uint16_t start, uint16_t end) const {
+    if(end < start) return "\n";
+
+    std::string out;
+    uint32_t span = end - start + 1;
+    out.reserve(span * 3 + (span / 16 + 2) * 7);
 
-    for(uint16_t i = start; i <= end; ++i) {
-        if(i % 16 == 0) {
-            out << "\n" << std::hex
-                << std::setw(4) << std::setfill('0')
-                << +i << ": ";
+    //uint32_t: end = 0xffff is included
+    for(uint32_t addr = start; addr <= end; ++addr) {
+        if(addr % 16 == 0 || addr == start) {
+            char header[7] = {'\n', 0, 0, 0, 0, ':', ' '};
+            Format::hex4(header + 1, addr);
+            out.append(header, sizeof(header));
         }
-        out << std::hex 
-            << std::setw(2) << std::setfill('0')
-            << +memory[i] << " ";
+        char text[3] = {0, 0, ' '};
+        Format::hex2(text, read(addr));
+        out.append(text, sizeof(text));
     }
-    out << "\n";
+    out += '\n';
 
-    return out.str();
+    return out;
+}
+
+std::size_t Memory::hexDump(uint16_t start, uint16_t end, char* out) const {
+    //Line by line through the page table (the lines may cross a page)
+    uint8_t bytes[16];
+    std::size_t size = 0;
+    for(uint32_t addr = start; addr <= end; addr += 16) {
+        std::size_t length = end - addr + 1 < 16 ? end - addr + 1 : 16;
+        for(std::size_t i = 0; i < length; ++i) bytes[i] = read(addr + i);
+        size += ::hexDump(bytes, length, addr, out + size);
+    }
+    return size;
 }
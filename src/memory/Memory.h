@@ -2,29 +2,156 @@
 #define MEMORY_H
 
 #include <string>
+#include <vector>
 #include <cstdint>
+#include <cstddef>
+#include "Mapping.h"
+#include "ROMImage.h"
+#include "Loader.h"
+#include "Dump.h"
+#include "../cpu/PageTable.h"
 
 #define SIZE 0x10000 // 64KiB
 
-void memoryWrite(uint16_t addr, uint8_t data);
-uint8_t memoryRead(uint16_t addr);
-
 /*
-    Load the memory content from a file containing
-    whitespace-separated hex bytes at the specified
-    address.
-
-    EXAMPLE (File content):
-     A9 10 A5 30
+    Pages of a Memory (see Memory::snapshot()): all of them, or only
+    the ones written after a given generation (incremental).
 */
-void loadFromFileHex(uint16_t addr, std::string fileName);
+struct MemorySnapshot {
+    uint32_t generation{0};             //Generation of the memory when taken
+    std::vector<uint8_t> pages;         //Page numbers (high byte of the address)
+    std::vector<uint8_t> data;          //256 bytes per page, in the same order
+};
 
 /*
-    Load the memory content from a binary file at the
-    specified address.
+    64 KiB of flat memory. Every instance owns its own storage, so
+    independent machines can run side by side in one process.
+
+    The storage is page aligned (thus cache-line aligned) and zeroed;
+    with hugePages = true it is backed by a huge page when the kernel
+    has one available (see usesHugePages()), by normal pages otherwise.
+
+    A CPU accesses it without the fRead/fWrite indirection through the
+    page table of the memory, which also tracks the pages it writes
+    (see the dirty pages below):
+
+        Memory memory;
+        memory.loadFromFileBin(0x0400, "program.bin");
+        MOS6502 cpu(memory.pages());
+
+    The ROM images mapped with mapROM() replace the RAM pages (4 KiB
+    each) in the table, read-only, without a copy (see ROMImage.h). The
+    pages of mapIO() go to the I/O functions of the CPU.
+
+        memory.mapROM(0xe000, kernal);
+        memory.mapIO(0xd000, 0x1000);
+        MOS6502 cpu(memory.pages(), ioWrite, ioRead);
 */
-void loadFromFileBin(uint16_t addr, std::string fileName);
+class Memory {
+public:
+    explicit Memory(bool hugePages = false);
+
+    Memory(Memory const &) = delete;
+    Memory& operator=(Memory const &) = delete;
+
+    //Through the page table (ROM pages included, the RAM for I/O pages)
+    void write(uint16_t addr, uint8_t data) {
+        uint8_t* page{table.write[addr >> PageTable::PAGE_BITS]};
+        if(page) page[addr & PageTable::PAGE_MASK] = data;
+        else     memory[addr] = data;
+        table.markDirty(addr);
+    }
+    uint8_t read(uint16_t addr) const {
+        uint8_t* page{table.read[addr >> PageTable::PAGE_BITS]};
+        return page ? page[addr & PageTable::PAGE_MASK] : memory[addr];
+    }
+
+    //The RAM (under the ROM pages too)
+    uint8_t* data() { return memory; }
+    uint8_t const * data() const { return memory; }
+
+    PageTable const & pages() const { return table; }
+
+    /*
+        Map image at addr (a multiple of PageTable::PAGE_SIZE), up to
+        the end of the address space. Writes to its pages are ignored.
+        Returns false if the image is not open or addr not aligned.
+    */
+    bool mapROM(uint16_t addr, ROMImage const & image);
+    //Leave the pages of [addr, addr+size) to the functions of the CPU
+    void mapIO(uint16_t addr, std::size_t size);
+    //Back to RAM for the pages of [addr, addr+size)
+    void mapRAM(uint16_t addr, std::size_t size);
+
+    bool usesHugePages() const { return mapping.usesHugePages(); }
+
+    /**** Dirty pages ****
+     *  A CPU bound to pages() and write() mark the 256-byte pages they
+     *  write in the dirty bitmap of the page table; code writing
+     *  through data() calls markDirty(). A CPU built on data() has a
+     *  page table of its own: its writes are not tracked. sync() moves the marks to a generation
+     *  counter per page (the generation of its last write), so the
+     *  write path never does more than setting a bit, and both the
+     *  baseline and the snapshots compare generations:
+     *   - resetToBaseline() restores only the pages written since
+     *     setBaseline()
+     *   - snapshot(out, since) stores only the pages written since
+     *     the generation of an earlier snapshot
+    */
+    void markDirty(uint16_t addr, std::size_t size);
+    //Written since the last sync()
+    bool isDirty(uint8_t page) const { return table.isDirty(page); }
+    //Assign a new generation to the dirty pages, returns the current one
+    uint32_t sync();
+    uint32_t generation() const { return current; }
+    uint32_t pageGeneration(uint8_t page) const { return generations[page]; }
+
+    void setBaseline();
+    //Returns the number of pages restored
+    std::size_t resetToBaseline();
+
+    void snapshot(MemorySnapshot& out);
+    void snapshot(MemorySnapshot& out, uint32_t since);
+    //Apply a full snapshot, then the incremental ones in order
+    void restore(MemorySnapshot const & snapshot);
+
+    /*
+        Load the memory content from a file containing
+        whitespace-separated hex bytes at the specified
+        address (see Loader.h for the other formats).
+
+        EXAMPLE (File content):
+         A9 10 A5 30
+    */
+    LoadResult loadFromFileHex(uint16_t addr, std::string const & fileName);
+
+    /*
+        Load the memory content from a binary file at the
+        specified address.
+    */
+    LoadResult loadFromFileBin(uint16_t addr, std::string const & fileName);
+
+    //Hex bytes of [start, end], end included ("\n0010: 11 22 \n")
+    std::string dump(uint16_t start, uint16_t end) const;
+    /*
+        Hex/ASCII lines of [start, end], end included, into out (at
+        least dumpSize(end - start + 1) bytes, see Dump.h). Returns the
+        number of chars written.
+    */
+    std::size_t hexDump(uint16_t start, uint16_t end, char* out) const;
+
+private:
+    Mapping mapping;
+    uint8_t* const memory;
+    uint8_t* const discard;             //Target of the ROM writes
+    PageTable table;
+
+    uint32_t current{0};                //Generation
+    uint32_t generations[0x100] = {0};
+    std::vector<uint8_t> baseline;
+    uint32_t baselineGeneration{0};
 
-std::string memoryDump(uint16_t start, uint16_t end);
+    void copyPages(MemorySnapshot& out, uint32_t since, bool all);
+};
 
 #endif
@@ -0,0 +1,39 @@
+#include "ROMImage.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+ROMImage::ROMImage(std::string const & fileName):
+    image{nullptr}, length{0}
+{
+    int fd = ::open(fileName.c_str(), O_RDONLY);
+    if(fd < 0) return;
+
+    struct stat info;
+    if(fstat(fd, &info) == 0 && info.st_size > 0) {
+        void* address = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        if(address != MAP_FAILED) {
+            image = static_cast<uint8_t*>(address);
+            length = info.st_size;
+        }
+    }
+    //The mapping keeps the file
+    ::close(fd);
+}
+
+ROMImage::~ROMImage() {
+    if(image) munmap(image, length);
+}
+
+bool ROMImage::isOpen() const {
+    return image != nullptr;
+}
+
+uint8_t const * ROMImage::data() const {
+    return image;
+}
+
+std::size_t ROMImage::size() const {
+    return length;
+}
@@ -0,0 +1,40 @@
+#ifndef ROMIMAGE_H
+#define ROMIMAGE_H
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+/*
+    ROM image file mapped read-only (mmap): nothing is read or copied
+    when it is opened, the pages are loaded on first access, and they
+    are the pages of the file in the page cache, so every instance that
+    maps the image (and every process that maps the file) shares one
+    physical copy.
+
+        ROMImage kernal("kernal.bin");
+        if(!kernal.isOpen()) ...
+        memory.mapROM(0xe000, kernal);  //Every machine of the farm
+
+    The image must outlive the memories it is mapped into. The bytes of
+    the last page past the end of the file read as zero.
+*/
+class ROMImage {
+public:
+    explicit ROMImage(std::string const & fileName);
+    ~ROMImage();
+
+    ROMImage(ROMImage const &) = delete;
+    ROMImage& operator=(ROMImage const &) = delete;
+
+    bool isOpen() const;
+
+    uint8_t const * data() const;
+    std::size_t size() const;           //Size of the file
+
+private:
+    uint8_t* image;
+    std::size_t length;
+};
+
+#endif
@@ -0,0 +1,141 @@
+#ifndef RECOMPILED_H
+#define RECOMPILED_H
+
+#include <cstdint>
+#include "../cpu/MOS6502.h"
+#include "../cpu/Operations.h"
+
+/*
+    Runtime of the code generated by the static recompiler (see
+    Recompiler.h).
+
+    A recompiled ROM is a function
+
+        void name(MOS6502Core<Variant>& cpu, uint64_t end);
+
+    that runs the CPU until cpu.getCycles() >= end, exactly as
+
+        while(cpu.getCycles() < end) cpu.step();
+
+    would: the translated instructions change the registers, the
+    memory and the cycle counter of the core through the same
+    operations as the interpreter, and at every instruction boundary
+    the translated code goes back to the dispatcher when an event is
+    due, when a trap is set at PC or when hooks are installed. The
+    dispatcher jumps to the translation of PC, or interprets one
+    instruction (code outside the image, RAM, unknown targets of
+    indirect jumps).
+
+    The operands are constants of the generated code: only the opcode
+    dispatch and the operand fetches are removed, the bus accesses to
+    the effective addresses are performed as usual.
+*/
+template<class Variant>
+class Recompiled {
+public:
+    using Core = MOS6502Core<Variant>;
+
+    //True if the translated code must go back to the dispatcher
+    static bool stop(Core& cpu, uint64_t end) {
+        return cpu.cycles >= end || cpu.cycles >= cpu.events.nextCycle() ||
+               !translatable(cpu);
+    }
+
+    //Fire the due events (true if an IRQ has been taken)
+    static bool service(Core& cpu) {
+        return cpu.cycles >= cpu.events.nextCycle() &&
+               cpu.template serviceEvents<NoHooks>();
+    }
+
+    //False if the instruction at PC must be interpreted (trap, hooks)
+    static bool translatable(Core const & cpu) {
+        return !cpu.hooks && !cpu.trapMap[cpu.PC];
+    }
+
+    static void interpret(Core& cpu) {
+        cpu.step();
+    }
+
+    static uint16_t PC(Core const & cpu) {
+        return cpu.PC;
+    }
+
+    static uint64_t cycles(Core const & cpu) {
+        return cpu.cycles;
+    }
+
+    /*
+        Execute the instruction at next-length(opcode). operand is the
+        operand of the instruction (the target for the branches).
+    */
+    template<uint8_t opcode>
+    static void execute(Core& cpu, uint16_t next, uint16_t operand) {
+        constexpr InstructionInfo info{INSTRUCTIONS<Variant>[opcode]};
+
+        cpu.PC = next;
+        bool page_crossed{false};
+        uint16_t address{effectiveAddress<info.mode>(cpu, next, operand, page_crossed)};
+
+        cpu.template instructionCycles<opcode>(page_crossed);
+        if constexpr (info.mode == AddrMode::imm && accessType(info.mnemonic) == Access::read) {
+            //The immediate operand is known: no bus access
+            cpu.template readOperation<info.mnemonic, info.mode>(operand);
+        } else {
+            cpu.template operation<opcode, NoHooks>(address, page_crossed);
+        }
+    }
+
+private:
+    //Same as MOS6502Core::effectiveAddress() with the operand already fetched
+    template<AddrMode mode>
+    static uint16_t effectiveAddress(Core& cpu, uint16_t next, uint16_t operand, bool& page_crossed) {
+        if constexpr (mode == AddrMode::imp) {
+            return 0;
+        } else if constexpr (mode == AddrMode::imm) {
+            return next-1;
+        } else if constexpr (mode == AddrMode::zpg || mode == AddrMode::abs) {
+            return operand;
+        } else if constexpr (mode == AddrMode::zpx) {
+            return static_cast<uint8_t>(operand + cpu.X);
+        } else if constexpr (mode == AddrMode::zpy) {
+            return static_cast<uint8_t>(operand + cpu.Y);
+        } else if constexpr (mode == AddrMode::abx || mode == AddrMode::aby) {
+            uint8_t index{mode == AddrMode::abx ? cpu.X : cpu.Y};
+            page_crossed = (static_cast<uint8_t>(operand + index) < static_cast<uint8_t>(operand));
+            return operand + index;
+        } else if constexpr (mode == AddrMode::ind) {
+            uint8_t LB = cpu.template read<NoHooks>(operand);
+            uint8_t HB;
+            if constexpr (Variant::jmpIndirectPageWrap) {
+                HB = cpu.template read<NoHooks>((operand & 0xff00) | static_cast<uint8_t>(operand+1));
+            } else {
+                HB = cpu.template read<NoHooks>(operand+1);
+            }
+            return HB*16*16+LB;
+        } else if constexpr (mode == AddrMode::xin) {
+            uint8_t target = operand + cpu.X;
+            uint8_t LB = cpu.template read<NoHooks>(target);
+            uint8_t HB = cpu.template read<NoHooks>(static_cast<uint8_t>(target+1));
+            return HB*16*16+LB;
+        } else if constexpr (mode == AddrMode::iny || mode == AddrMode::izp) {
+            uint8_t LB = cpu.template read<NoHooks>(operand);
+            uint8_t HB = cpu.template read<NoHooks>(static_cast<uint8_t>(operand+1));
+            if constexpr (mode == AddrMode::izp) {
+                return HB*16*16+LB;
+            } else {
+                page_crossed = (static_cast<uint8_t>(LB + cpu.Y) < LB);
+                return (HB*16*16+LB)+cpu.Y;
+            }
+        } else if constexpr (mode == AddrMode::axi) {
+            uint16_t target = operand + cpu.X;
+            uint8_t LB = cpu.template read<NoHooks>(target);
+            uint8_t HB = cpu.template read<NoHooks>(static_cast<uint16_t>(target+1));
+            return HB*16*16+LB;
+        } else if constexpr (mode == AddrMode::rel) {
+            page_crossed = ((operand >> 8) != (next >> 8));
+            return operand;
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,164 @@
+#include "Recompiler.h"
+#include <sstream>
+#include <iomanip>
+#include <bitset>
+
+namespace {
+
+template<class Variant> char const * variantName();
+template<> char const * variantName<NMOS6502>()  { return "NMOS6502"; }
+template<> char const * variantName<CMOS65C02>() { return "CMOS65C02"; }
+template<> char const * variantName<RP2A03>()    { return "RP2A03"; }
+
+std::string hex(unsigned value, int width) {
+    std::ostringstream out;
+    out << std::hex << std::setw(width) << std::setfill('0') << value;
+    return out.str();
+}
+
+std::string label(uint16_t addr) {
+    return "L_" + hex(addr, 4);
+}
+
+std::string entry(uint16_t addr) {
+    return "E_" + hex(addr, 4);
+}
+
+//Flow of control after an instruction
+bool isBranch(InstructionInfo const & info) {
+    return info.mode == AddrMode::rel;
+}
+
+bool fallsThrough(InstructionInfo const & info) {
+    switch(info.mnemonic) {
+        case Mnemonic::JMP: case Mnemonic::JSR: case Mnemonic::RTS:
+        case Mnemonic::RTI: case Mnemonic::BRK: case Mnemonic::BRA:
+            return false;
+        default:
+            return true;
+    }
+}
+
+}
+
+template<class Variant>
+Recompiler<Variant>::Recompiler(std::vector<uint8_t> image, uint16_t base):
+    flow{std::move(image), base}
+{}
+
+template<class Variant>
+void Recompiler<Variant>::addEntry(uint16_t addr) {
+    flow.addEntry(addr);
+}
+
+/**** Code generation ****/
+template<class Variant>
+std::string Recompiler<Variant>::generate(std::string const & name, std::string const & include) {
+    std::ostringstream out;
+    std::string core = "MOS6502Core<" + std::string(variantName<Variant>()) + ">";
+
+    out << "//Generated by the 6502 static recompiler: do not edit\n"
+        << "#include \"" << include << "\"\n\n"
+        << "void " << name << "(" << core << "& cpu, uint64_t end) {\n"
+        << "    using R = Recompiled<" << variantName<Variant>() << ">;\n\n"
+        << "    //Instruction boundary outside the straight-line flow\n"
+        << "dispatch:\n"
+        << "    while(R::cycles(cpu) < end) {\n"
+        << "        if(R::service(cpu)) continue;\n"
+        << "        if(R::translatable(cpu)) {\n"
+        << "            switch(R::PC(cpu)) {\n";
+    for(unsigned addr = 0; addr < 0x10000; ++addr) {
+        if(flow.isInstruction(addr)) {
+            out << "                case 0x" << hex(addr, 4) << ": goto " << entry(addr) << ";\n";
+        }
+    }
+    out << "                default: break;\n"
+        << "            }\n"
+        << "        }\n"
+        << "        R::interpret(cpu);\n"
+        << "    }\n"
+        << "    return;\n";
+
+    //Translated instructions, in address order
+    std::vector<uint16_t> order;
+    for(unsigned addr = 0; addr < 0x10000; ++addr) {
+        if(flow.isInstruction(addr)) order.push_back(addr);
+    }
+
+    //Where the flow is not sequential in the output, goto the next instruction
+    auto successor = [&](std::size_t i) -> uint32_t {
+        InstructionInfo const & info = INSTRUCTIONS<Variant>[flow.byte(order[i])];
+        return fallsThrough(info) ? static_cast<uint16_t>(order[i] + instructionLength(info.mode)) : 0x10000;
+    };
+    auto contiguous = [&](std::size_t i) {
+        return i+1 < order.size() && successor(i) == order[i+1];
+    };
+    auto staticJump = [](InstructionInfo const & info) {
+        return isBranch(info) || (info.mode == AddrMode::abs &&
+                                  (info.mnemonic == Mnemonic::JMP || info.mnemonic == Mnemonic::JSR));
+    };
+    std::bitset<0x10000> labels;
+    for(std::size_t i = 0; i < order.size(); ++i) {
+        uint32_t next = successor(i);
+        if(next < 0x10000 && !contiguous(i) && flow.isInstruction(next)) labels[next] = 1;
+        if(staticJump(INSTRUCTIONS<Variant>[flow.byte(order[i])])) {
+            uint16_t target = flow.operand(order[i]);
+            if(flow.isInstruction(target)) labels[target] = 1;
+        }
+    }
+
+    auto jump = [&](uint16_t target) {
+        return flow.isInstruction(target) ? "goto " + label(target) : std::string("goto dispatch");
+    };
+
+    for(std::size_t i = 0; i < order.size(); ++i) {
+        uint16_t addr = order[i];
+        InstructionInfo const & info = INSTRUCTIONS<Variant>[flow.byte(addr)];
+        uint8_t length = instructionLength(info.mode);
+        uint16_t next = addr + length;
+        uint16_t operand = flow.operand(addr);
+
+        if(flow.isLeader(addr)) {
+            out << "\n    //Block $" << hex(addr, 4) << "\n";
+        }
+        if(labels[addr]) {
+            out << label(addr) << ":\n";
+        }
+        out << "    if(R::stop(cpu, end)) goto dispatch;\n"
+            << entry(addr) << ":\n"
+            << "    R::execute<0x" << hex(flow.byte(addr), 2) << ">(cpu, 0x" << hex(next, 4)
+            << ", 0x" << hex(operand, length == 2 && !isBranch(info) ? 2 : 4) << ");"
+            << "  //" << mnemonicName(info.mnemonic) << "\n";
+
+        //Static control flow
+        if(isBranch(info) && info.mnemonic != Mnemonic::BRA) {
+            out << "    if(R::PC(cpu) == 0x" << hex(operand, 4) << ") " << jump(operand) << ";\n";
+        } else if(staticJump(info)) {
+            out << "    " << jump(operand) << ";\n";
+        } else if(!fallsThrough(info)) {
+            out << "    goto dispatch;\n";
+        }
+
+        if(fallsThrough(info) && !contiguous(i)) {
+            out << "    " << jump(next) << ";\n";
+        }
+    }
+    out << "}\n";
+
+    return out.str();
+}
+/*************************/
+
+template<class Variant>
+std::size_t Recompiler<Variant>::instructionCount() const {
+    return flow.instructionCount();
+}
+
+template<class Variant>
+std::size_t Recompiler<Variant>::blockCount() const {
+    return flow.blocks().size();
+}
+
+template class Recompiler<NMOS6502>;
+template class Recompiler<CMOS65C02>;
+template class Recompiler<RP2A03>;
@@ -0,0 +1,58 @@
+#ifndef RECOMPILER_H
+#define RECOMPILER_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include "../cpu/Variants.h"
+#include "../cpu/Instructions.h"
+#include "../analysis/ControlFlow.h"
+
+/*
+    Static recompiler: translates the code of a ROM image into C++.
+
+    The code reachable from the vectors found in the image and from the
+    extra entry points is discovered by ControlFlow (see
+    ControlFlow.h). The indirect jumps, RTS and RTI end a block: their
+    target is found at runtime by the dispatcher of the generated code
+    (the targets already resolved by a ControlFlowTracker can be passed
+    with addEntry()).
+
+        Recompiler<NMOS6502> recompiler(image, 0xf000);
+        recompiler.addEntry(0xf800);
+        std::string source = recompiler.generate("runFirmware");
+
+    The generated source defines
+
+        void runFirmware(MOS6502Core<NMOS6502>& cpu, uint64_t end);
+
+    (see Recompiled.h). Each basic block is emitted as a sequence of
+    labelled statements of that function, so that the static branches
+    are direct gotos.
+
+    The image is assumed to be read-only: code written at runtime (in
+    RAM) is interpreted.
+*/
+template<class Variant>
+class Recompiler {
+public:
+    Recompiler(std::vector<uint8_t> image, uint16_t base);
+
+    void addEntry(uint16_t addr);
+
+    /*
+        C++ source of the function name. include is the path of
+        Recompiled.h used by the #include directive.
+    */
+    std::string generate(std::string const & name,
+                         std::string const & include = "Recompiled.h");
+
+    std::size_t instructionCount() const;
+    std::size_t blockCount() const;
+
+private:
+    ControlFlow<Variant> flow;
+};
+
+#endif
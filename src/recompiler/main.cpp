@@ -0,0 +1,84 @@
+#include "Recompiler.h"
+#include <iostream>
+#include <fstream>
+#include <iterator>
+#include <unistd.h>
+
+/*
+    recompile [-v nmos|cmos|2a03] [-b base] [-e entry]... [-n name] [-i include] rom.bin out.cpp
+
+    Translate rom.bin (loaded at base, by default at the top of the
+    address space) into the C++ function name (see Recompiler.h).
+*/
+
+static void usage() {
+    std::cout << "Usage: recompile [-v nmos|cmos|2a03] [-b base] [-e entry]... "
+                 "[-n name] [-i include] rom.bin out.cpp\n";
+}
+
+template<class Variant>
+static int recompile(std::vector<uint8_t> image, long base, std::vector<uint16_t> const & entries,
+                     std::string const & name, std::string const & include, std::string const & output) {
+    Recompiler<Variant> recompiler(std::move(image), base);
+    for(uint16_t entry : entries) {
+        recompiler.addEntry(entry);
+    }
+    std::string source = recompiler.generate(name, include);
+
+    std::ofstream file(output);
+    if(!file) {
+        std::cout << "ERROR: couldn't open file\n";
+        return 1;
+    }
+    file << source;
+
+    std::cout << output << ": " << recompiler.instructionCount() << " instructions, "
+              << recompiler.blockCount() << " blocks\n";
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    std::string variant{"nmos"};
+    long base{-1};
+    std::vector<uint16_t> entries;
+    std::string name{"recompiled"};
+    std::string include{"Recompiled.h"};
+
+    int option;
+    while((option = getopt(argc, argv, "v:b:e:n:i:")) != -1) {
+        switch(option) {
+            case 'v': variant = optarg; break;
+            case 'b': base = std::stol(optarg, nullptr, 16); break;
+            case 'e': entries.push_back(std::stoul(optarg, nullptr, 16)); break;
+            case 'n': name = optarg; break;
+            case 'i': include = optarg; break;
+            default: usage(); return 1;
+        }
+    }
+    if(argc - optind != 2) {
+        usage();
+        return 1;
+    }
+
+    std::ifstream file(argv[optind], std::ios::binary);
+    if(!file) {
+        std::cout << "ERROR: couldn't open file\n";
+        return 1;
+    }
+    std::vector<uint8_t> image{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+    if(image.empty() || image.size() > 0x10000) {
+        std::cout << "ERROR: invalid image size\n";
+        return 1;
+    }
+    if(base < 0) {
+        base = 0x10000 - image.size();
+    }
+
+    std::string output{argv[optind+1]};
+    if(variant == "nmos") return recompile<NMOS6502>(image, base, entries, name, include, output);
+    if(variant == "cmos") return recompile<CMOS65C02>(image, base, entries, name, include, output);
+    if(variant == "2a03") return recompile<RP2A03>(image, base, entries, name, include, output);
+
+    usage();
+    return 1;
+}
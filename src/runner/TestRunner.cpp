@@ -0,0 +1,143 @@
+#include "TestRunner.h"
+#include "../cpu/MOS6502.h"
+#include "../memory/Memory.h"
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+template<class Variant>
+TestResult run(TestConfig const & config) {
+    TestResult result;
+    Memory memory;
+    MemoryTarget target(memory);
+    if(!loadFile(LoadFormat::binary, config.file, target, config.load)) {
+        return result;
+    }
+
+    MOS6502Core<Variant> cpu(memory.pages());
+    cpu.setPC(config.entry);
+
+    for(;;) {
+        uint16_t pc = cpu.getPC();
+        if(pc == config.success) {
+            result.status = TestStatus::passed;
+            break;
+        }
+        if(cpu.getCycles() >= config.cycleLimit) {
+            result.status = TestStatus::timeout;
+            break;
+        }
+
+        cpu.step();
+
+        //Jump or branch to itself: the ROM reports an error
+        if(cpu.getPC() == pc) {
+            result.status = TestStatus::trap;
+            break;
+        }
+    }
+
+    result.pc = cpu.getPC();
+    result.cycles = cpu.getCycles();
+    return result;
+}
+
+}
+
+char const * testStatusName(TestStatus status) {
+    switch(status) {
+        case TestStatus::passed:    return "PASS";
+        case TestStatus::trap:      return "FAIL (trap)";
+        case TestStatus::timeout:   return "FAIL (timeout)";
+        case TestStatus::loadError: return "FAIL (couldn't load file)";
+    }
+    return "FAIL";
+}
+
+bool parseVariant(std::string const & name, TestVariant& variant) {
+    if(name == "nmos")      variant = TestVariant::nmos;
+    else if(name == "cmos") variant = TestVariant::cmos;
+    else if(name == "2a03") variant = TestVariant::rp2a03;
+    else return false;
+    return true;
+}
+
+TestResult runTest(TestConfig const & config) {
+    auto start = std::chrono::steady_clock::now();
+
+    TestResult result;
+    switch(config.variant) {
+        case TestVariant::nmos:   result = run<NMOS6502>(config); break;
+        case TestVariant::cmos:   result = run<CMOS65C02>(config); break;
+        case TestVariant::rp2a03: result = run<RP2A03>(config); break;
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    result.seconds = elapsed.count();
+    return result;
+}
+
+std::vector<TestResult> runTests(std::vector<TestConfig> const & configs, unsigned jobs) {
+    std::vector<TestResult> results(configs.size());
+    if(jobs == 0) jobs = std::thread::hardware_concurrency();
+    if(jobs == 0) jobs = 1;
+    if(jobs > configs.size()) jobs = configs.size();
+
+    //Every thread takes the next config until none is left
+    std::atomic<std::size_t> next{0};
+    auto worker = [&]() {
+        for(std::size_t i = next++; i < configs.size(); i = next++) {
+            results[i] = runTest(configs[i]);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for(unsigned i = 0; i < jobs; ++i) {
+        threads.emplace_back(worker);
+    }
+    for(std::thread& thread : threads) {
+        thread.join();
+    }
+
+    return results;
+}
+
+bool loadTestConfigs(std::string const & fileName, std::vector<TestConfig>& configs, std::size_t& line) {
+    line = 0;
+    std::ifstream file(fileName);
+    if(!file) return false;
+
+    std::size_t slash = fileName.rfind('/');
+    std::string directory = slash == std::string::npos ? "" : fileName.substr(0, slash + 1);
+
+    std::string text;
+    while(std::getline(file, text)) {
+        ++line;
+        text = text.substr(0, text.find('#'));
+        std::istringstream fields(text);
+
+        TestConfig config;
+        unsigned long load, entry, success;
+        if(!(fields >> config.file)) continue;      //Empty line
+        if(!(fields >> std::hex >> load >> entry >> success >> std::dec >> config.cycleLimit) ||
+           load > 0xffff || entry > 0xffff || success > 0xffff) {
+            return false;
+        }
+        std::string variant;
+        if(fields >> variant && !parseVariant(variant, config.variant)) return false;
+        if(fields >> text) return false;
+
+        if(config.file[0] != '/') config.file = directory + config.file;
+        config.load = load;
+        config.entry = entry;
+        config.success = success;
+        configs.push_back(config);
+    }
+
+    line = 0;
+    return true;
+}
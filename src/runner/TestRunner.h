@@ -0,0 +1,77 @@
+#ifndef TESTRUNNER_H
+#define TESTRUNNER_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/*
+    Headless runner of test ROMs (e.g. Klaus Dormann's functional
+    tests): load a binary image, start at entry, and run until
+
+     - PC reaches success:                         passed
+     - an instruction jumps to itself (JMP *,
+       BNE * taken, ...), anywhere but success:    failed (trap)
+     - the cycle counter reaches cycleLimit:       failed (timeout)
+
+    The test ROMs report their errors by looping in place, so a trap
+    is a failure as soon as it is reached, with its address in pc.
+
+        TestConfig config{"6502_functional_test.bin", TestVariant::nmos,
+                          0x0400, 0x0400, 0x36b9, 200000000};
+        TestResult result = runTest(config);
+
+    runTests() runs the jobs in parallel, each on its own memory and
+    CPU, and returns the results in the order of the configs.
+*/
+enum class TestVariant {
+    nmos,
+    cmos,
+    rp2a03
+};
+
+enum class TestStatus {
+    passed,
+    trap,           //Looping in place
+    timeout,        //Cycle limit reached
+    loadError       //ROM not loaded
+};
+
+struct TestConfig {
+    std::string file;
+    TestVariant variant{TestVariant::nmos};
+    uint16_t load{0x0000};
+    uint16_t entry{0x0000};
+    uint16_t success{0x0000};
+    uint64_t cycleLimit{100000000};
+};
+
+struct TestResult {
+    TestStatus status{TestStatus::loadError};
+    uint16_t pc{0};             //PC at the end (address of the trap)
+    uint64_t cycles{0};
+    double seconds{0};          //Wall time of the run (loading included)
+};
+
+char const * testStatusName(TestStatus status);
+//"nmos", "cmos", "2a03" (false if unknown)
+bool parseVariant(std::string const & name, TestVariant& variant);
+
+TestResult runTest(TestConfig const & config);
+//jobs = 0: one per hardware thread
+std::vector<TestResult> runTests(std::vector<TestConfig> const & configs, unsigned jobs = 0);
+
+/*
+    Configs from a text file, one per line (hex addresses, decimal
+    cycle limit, '#' starts a comment):
+
+        file  load  entry  success  cycleLimit  [nmos|cmos|2a03]
+
+    Relative file names are relative to the directory of the config
+    file. Returns false on the first malformed line (its number in
+    line, 0 if the file cannot be opened).
+*/
+bool loadTestConfigs(std::string const & fileName, std::vector<TestConfig>& configs, std::size_t& line);
+
+#endif
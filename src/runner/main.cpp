@@ -0,0 +1,79 @@
+#include "TestRunner.h"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <unistd.h>
+
+/*
+    run6502 [-j jobs] [-c configs]... [-v nmos|cmos|2a03] [-l load] [-e entry]
+            [-s success] [-n cycles] [rom.bin]...
+
+    Run the test ROMs of the config files (see TestRunner.h) and the
+    ones on the command line (with the -v/-l/-e/-s/-n values, hex
+    addresses) in parallel. The exit code is the number of failures.
+*/
+
+static void usage() {
+    std::cout << "Usage: run6502 [-j jobs] [-c configs]... [-v nmos|cmos|2a03] [-l load] [-e entry] "
+                 "[-s success] [-n cycles] [rom.bin]...\n";
+}
+
+int main(int argc, char* argv[]) {
+    unsigned jobs{0};
+    std::vector<TestConfig> configs;
+    TestConfig defaults;
+
+    int option;
+    while((option = getopt(argc, argv, "j:c:v:l:e:s:n:")) != -1) {
+        switch(option) {
+            case 'j': jobs = std::stoul(optarg); break;
+            case 'c': {
+                std::size_t line;
+                if(!loadTestConfigs(optarg, configs, line)) {
+                    if(line == 0) std::cout << "ERROR: couldn't open file " << optarg << "\n";
+                    else          std::cout << "ERROR: " << optarg << ":" << line << ": invalid config\n";
+                    return 1;
+                }
+                break;
+            }
+            case 'v':
+                if(!parseVariant(optarg, defaults.variant)) {
+                    usage();
+                    return 1;
+                }
+                break;
+            case 'l': defaults.load = std::stoul(optarg, nullptr, 16); break;
+            case 'e': defaults.entry = std::stoul(optarg, nullptr, 16); break;
+            case 's': defaults.success = std::stoul(optarg, nullptr, 16); break;
+            case 'n': defaults.cycleLimit = std::stoull(optarg); break;
+            default: usage(); return 1;
+        }
+    }
+    for(int i = optind; i < argc; ++i) {
+        TestConfig config = defaults;
+        config.file = argv[i];
+        configs.push_back(config);
+    }
+    if(configs.empty()) {
+        usage();
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<TestResult> results = runTests(configs, jobs);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    int failed = 0;
+    for(std::size_t i = 0; i < results.size(); ++i) {
+        TestResult const & result = results[i];
+        failed += result.status != TestStatus::passed;
+        std::cout << std::left << std::setw(26) << testStatusName(result.status) << configs[i].file
+                  << "  PC:" << std::right << std::hex << std::setw(4) << std::setfill('0') << result.pc
+                  << std::dec << std::setfill(' ') << "  " << result.cycles << " cycles  "
+                  << std::fixed << std::setprecision(3) << result.seconds << " s\n";
+    }
+    std::cout << results.size() - failed << " passed, " << failed << " failed in "
+              << std::fixed << std::setprecision(3) << elapsed.count() << " s\n";
+
+    return failed;
+}
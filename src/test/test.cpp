@@ -1,20 +1,1493 @@
 #include <iostream>
 #include "../cpu/MOS6502.h"
+#include "../cpu/CycleEngine.h"
 #include "../memory/Memory.h"
+#include "../memory/BankedMemory.h"
+#include "../bus/Bus.h"
+#include "../bus/Devices.h"
+#include "../bus/VIA.h"
+#include "../bus/ACIA.h"
+#include "../bus/Framebuffer.h"
+#include "../bus/SPSCQueue.h"
+#include "../bus/HostLink.h"
+#include "../machine/AsyncMachine.h"
+#include "../machine/System.h"
+#include "../machine/Rewind.h"
+#include "../analysis/ControlFlow.h"
+#include "../analysis/Disassembler.h"
+#include "../analysis/Trace.h"
+#include "../analysis/Heatmap.h"
+#include "../analysis/Lockstep.h"
+#include "../runner/TestRunner.h"
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+#include <thread>
+#include <unistd.h>
+#include <fcntl.h>
 
 #define SUCCESS 0x36b9
 
-int main(void) {
+//Translation of recompiler_test.bin (see makefile and recompiler_test.lst)
+void recompiledTestROM(MOS6502Core<NMOS6502>& cpu, uint64_t end);
 
-    loadFromFileBin(0x0400, "./6502_functional_test.bin");
-    MOS6502 cpu = MOS6502(memoryWrite, memoryRead);
+/*
+    Run the functional test on the given CPU variant.
+    Returns true if the success address has been reached.
+*/
+template<class CPU>
+static bool functionalTest(std::string const & name, uint64_t& cycles) {
+    Memory memory;
+    memory.loadFromFileBin(0x0400, "./6502_functional_test.bin");
+    CPU cpu(memory.data());
 
-    std::cout << cpu.info() << "\n";
+    std::cout << name << "\n" << cpu.info() << "\n";
 
     cpu.setBreakpoint(SUCCESS);
     cpu.execute(0x0400, 0x3a19);
 
     std::cout << cpu.info() << "\n";
 
-    return 0;
+    cycles = cpu.getCycles();
+    return cpu.getPC() == SUCCESS;
+}
+
+/*
+    Run the functional test on the cycle-exact engine.
+    Returns true if the success address has been reached
+    with the same number of cycles of the fast engine.
+*/
+template<class Variant>
+static bool cycleExactTest(std::string const & name, uint64_t expectedCycles) {
+    Memory memory;
+    memory.loadFromFileBin(0x0400, "./6502_functional_test.bin");
+    MOS6502Core<Variant> cpu(memory.data());
+    CycleEngine<Variant> engine(cpu);
+
+    std::cout << name << " (cycle-exact)\n" << cpu.info() << "\n";
+
+    cpu.setBreakpoint(SUCCESS);
+    engine.execute(0x0400, 0x3a19);
+
+    std::cout << cpu.info() << "\n";
+
+    return cpu.getPC() == SUCCESS && cpu.getCycles() == expectedCycles;
+}
+
+struct BusCycle {
+    uint64_t cycle;
+    uint16_t addr;
+    bool write;
+    uint8_t data;
+
+    bool operator==(BusCycle const & other) const {
+        return cycle == other.cycle && addr == other.addr &&
+               write == other.write && data == other.data;
+    }
+};
+
+/*
+    Bus accesses of the cycle-exact engine, dummy ones included:
+    page crossing abs,X and (zp),Y, double write of ASL, stack
+    reads of JSR and RTS.
+*/
+static bool busCycleTest() {
+    //LDX #$01; LDA $02FF,X; LDY #$01; LDA ($40),Y; ASL $50; JSR $0300
+    const uint8_t program[] = {0xa2, 0x01, 0xbd, 0xff, 0x02, 0xa0, 0x01,
+                               0xb1, 0x40, 0x06, 0x50, 0x20, 0x00, 0x03};
+    std::vector<uint8_t> memory(0x10000);
+    std::copy(std::begin(program), std::end(program), memory.begin() + 0x0200);
+    memory[0x0040] = 0xff;
+    memory[0x0041] = 0x03;
+    memory[0x0050] = 0x41;
+    memory[0x0300] = 0x60;      //RTS
+    memory[0x0400] = 0x99;
+
+    std::vector<BusCycle> accesses;
+    MOS6502Core<NMOS6502>* core = nullptr;
+    MOS6502Core<NMOS6502> cpu(
+        [&](uint16_t addr, uint8_t data) {
+            accesses.push_back(BusCycle{core->getCycles(), addr, true, data});
+            memory[addr] = data;
+        },
+        [&](uint16_t addr) {
+            accesses.push_back(BusCycle{core->getCycles(), addr, false, memory[addr]});
+            return memory[addr];
+        });
+    core = &cpu;
+    CycleEngine<NMOS6502> engine(cpu);
+    cpu.setPC(0x0200);
+    for(int i = 0; i < 7; ++i) {
+        engine.step();
+    }
+
+    const std::vector<BusCycle> expected = {
+        { 1, 0x0200, false, 0xa2}, { 2, 0x0201, false, 0x01},
+        //LDA $02FF,X: dummy read of $0200 before the fix-up of PCH
+        { 3, 0x0202, false, 0xbd}, { 4, 0x0203, false, 0xff}, { 5, 0x0204, false, 0x02},
+        { 6, 0x0200, false, 0xa2}, { 7, 0x0300, false, 0x60},
+        { 8, 0x0205, false, 0xa0}, { 9, 0x0206, false, 0x01},
+        //LDA ($40),Y: dummy read of $0300
+        {10, 0x0207, false, 0xb1}, {11, 0x0208, false, 0x40}, {12, 0x0040, false, 0xff},
+        {13, 0x0041, false, 0x03}, {14, 0x0300, false, 0x60}, {15, 0x0400, false, 0x99},
+        //ASL $50: the unmodified value is written back first
+        {16, 0x0209, false, 0x06}, {17, 0x020a, false, 0x50}, {18, 0x0050, false, 0x41},
+        {19, 0x0050, true,  0x41}, {20, 0x0050, true,  0x82},
+        //JSR $0300: stack read, PCH and PCL pushed, then the high byte
+        {21, 0x020b, false, 0x20}, {22, 0x020c, false, 0x00}, {23, 0x01ff, false, 0x00},
+        {24, 0x01ff, true,  0x02}, {25, 0x01fe, true,  0x0d}, {26, 0x020d, false, 0x03},
+        //RTS: reads of the next byte and of the stack, read at the return address
+        {27, 0x0300, false, 0x60}, {28, 0x0301, false, 0x00}, {29, 0x01fd, false, 0x00},
+        {30, 0x01fe, false, 0x0d}, {31, 0x01ff, false, 0x02}, {32, 0x020d, false, 0x03}
+    };
+
+    std::cout << "Bus cycles\n" << cpu.info() << "\n";
+
+    return accesses == expected && cpu.getPC() == 0x020e;
+}
+
+/*
+    The undefined opcodes of the 65C02 are NOPs of fixed length and
+    timing: same PC and cycles on both engines.
+*/
+static bool cmosNopTest() {
+    //NOP #$ff; NOP; NOP $10; NOP $10,X; NOP $1234 (5C); NOP $1234 (DC); NOP
+    const uint8_t program[] = {0x02, 0xff, 0x03, 0x44, 0x10, 0x54, 0x10,
+                               0x5c, 0x34, 0x12, 0xdc, 0x34, 0x12, 0xea};
+    Memory memory;
+    for(uint16_t i = 0; i < sizeof(program); ++i) {
+        memory.write(0x0200+i, program[i]);
+    }
+
+    MOS65C02 cpu(memory.data());
+    cpu.setBreakpoint(0x020d);
+    cpu.execute(0x0200, 0xffff);
+
+    Memory cycleMemory;
+    for(uint16_t i = 0; i < sizeof(program); ++i) {
+        cycleMemory.write(0x0200+i, program[i]);
+    }
+    MOS6502Core<CMOS65C02> core(cycleMemory.data());
+    CycleEngine<CMOS65C02> engine(core);
+    core.setBreakpoint(0x020d);
+    engine.execute(0x0200, 0xffff);
+
+    std::cout << "65C02 NOPs\n" << cpu.info() << "\n";
+
+    constexpr uint64_t cycles{2+1+3+4+8+4};
+    return cpu.getPC() == 0x020d && cpu.getCycles() == cycles &&
+           core.getPC() == 0x020d && core.getCycles() == cycles;
+}
+
+//Run a program loaded at $0200 up to its end, returns the final state
+template<class Variant>
+static CPUState runProgram(Memory& memory, uint8_t const * program, uint16_t size) {
+    for(uint16_t i = 0; i < size; ++i) {
+        memory.write(0x0200+i, program[i]);
+    }
+    MOS6502Core<Variant> cpu(memory.data());
+    cpu.setBreakpoint(0x0200+size);
+    cpu.execute(0x0200, 0xffff);
+    return cpu.getState();
+}
+
+/*
+    BCD arithmetic: N and Z of the NMOS 6502 come from the binary
+    result, the 65C02 makes them valid (one more cycle), the 2A03
+    ignores the D flag.
+*/
+static bool decimalTest() {
+    //SED; CLC; LDA #$99; ADC #$01
+    const uint8_t adc[] = {0xf8, 0x18, 0xa9, 0x99, 0x69, 0x01};
+    //SED; SEC; LDA #$00; SBC #$01
+    const uint8_t sbc[] = {0xf8, 0x38, 0xa9, 0x00, 0xe9, 0x01};
+
+    Memory memory;
+    CPUState nmosAdc = runProgram<NMOS6502>(memory, adc, sizeof(adc));
+    CPUState cmosAdc = runProgram<CMOS65C02>(memory, adc, sizeof(adc));
+    CPUState nesAdc = runProgram<RP2A03>(memory, adc, sizeof(adc));
+    CPUState nmosSbc = runProgram<NMOS6502>(memory, sbc, sizeof(sbc));
+    CPUState cmosSbc = runProgram<CMOS65C02>(memory, sbc, sizeof(sbc));
+    CPUState nesSbc = runProgram<RP2A03>(memory, sbc, sizeof(sbc));
+
+    std::cout << "Decimal mode\n";
+
+    //NV-BDIZC
+    return nmosAdc.AC == 0x00 && nmosAdc.SR == 0xa9 && nmosAdc.cycles == 8 &&
+           cmosAdc.AC == 0x00 && cmosAdc.SR == 0x2b && cmosAdc.cycles == 9 &&
+           nesAdc.AC == 0x9a && nesAdc.SR == 0xa8 && nesAdc.cycles == 8 &&
+           nmosSbc.AC == 0x99 && nmosSbc.SR == 0xa8 && nmosSbc.cycles == 8 &&
+           cmosSbc.AC == 0x99 && cmosSbc.SR == 0xa8 && cmosSbc.cycles == 9 &&
+           nesSbc.AC == 0xff && nesSbc.SR == 0xa8 && nesSbc.cycles == 8;
+}
+
+/*
+    65C02 instructions and the fixed JMP ($xxFF), which the NMOS 6502
+    reads across the page ($10FF, $1000).
+*/
+static bool cmosInstructionsTest() {
+    Memory memory;
+    memory.write(0x10ff, 0x34);
+    memory.write(0x1100, 0x12);
+    memory.write(0x1000, 0x56);
+
+    //JMP ($10FF)
+    const uint8_t jmp[] = {0x6c, 0xff, 0x10};
+    for(uint16_t i = 0; i < sizeof(jmp); ++i) {
+        memory.write(0x0200+i, jmp[i]);
+    }
+    MOS6502 nmos(memory.data());
+    nmos.setPC(0x0200);
+    nmos.step();
+    MOS65C02 cmos(memory.data());
+    cmos.setPC(0x0200);
+    cmos.step();
+
+    bool jump = nmos.getPC() == 0x5634 && nmos.getCycles() == 5 &&
+                cmos.getPC() == 0x1234 && cmos.getCycles() == 6;
+
+    //LDA #$0f; STA $10; LDA #$f0; TSB $10; PHP; LDA #$0c; TRB $10;
+    //STZ $11; LDX #$42; PHX; LDA #$20; STA $20; LDA #$03; STA $21;
+    //LDA #$77; STA ($20); LDA #$00; ORA ($20); BRA +1; BRK; NOP
+    const uint8_t program[] = {0xa9, 0x0f, 0x85, 0x10, 0xa9, 0xf0, 0x04, 0x10, 0x08,
+                               0xa9, 0x0c, 0x14, 0x10, 0x64, 0x11, 0xa2, 0x42, 0xda,
+                               0xa9, 0x20, 0x85, 0x20, 0xa9, 0x03, 0x85, 0x21,
+                               0xa9, 0x77, 0x92, 0x20, 0xa9, 0x00, 0x12, 0x20,
+                               0x80, 0x01, 0x00, 0xea};
+    memory.write(0x11, 0x55);
+    CPUState state = runProgram<CMOS65C02>(memory, program, sizeof(program));
+
+    std::cout << "65C02 instructions\n";
+
+    //TSB sets Z (no common bit, PHP pushes it with B), TRB clears it
+    return jump && state.PC == 0x0226 && state.AC == 0x77 && state.SP == 0xfd &&
+           state.cycles == 59 && memory.read(0x10) == 0xf3 && memory.read(0x11) == 0x00 &&
+           memory.read(0x01ff) == 0xb2 && memory.read(0x01fe) == 0x42 &&
+           memory.read(0x0320) == 0x77;
+}
+
+/*
+    Replace a multiply routine with a native handler and
+    check registers and cycles after the JSR.
+*/
+static bool trapTest() {
+    //LDX #7; LDY #6; JSR $1000; NOP
+    const uint8_t program[] = {0xa2, 0x07, 0xa0, 0x06, 0x20, 0x00, 0x10, 0xea};
+    Memory memory;
+    for(uint16_t i = 0; i < sizeof(program); ++i) {
+        memory.write(0x0200+i, program[i]);
+    }
+    //The trap must never execute the code at $1000
+    memory.write(0x1000, 0x00);
+
+    MOS6502 cpu(memory.data());
+    cpu.setTrap(0x1000, [](MOS6502& c) {
+        c.setAC(c.getX()*c.getY());
+    }, 20);
+    cpu.setBreakpoint(0x0208);
+    cpu.execute(0x0200, 0xffff);
+
+    std::cout << "HLE trap\n" << cpu.info() << "\n";
+
+    return cpu.getAC() == 42 && cpu.getPC() == 0x0208 &&
+           cpu.getSP() == 0xff && cpu.getCycles() == 2+2+6+20+2;
+}
+
+struct CountingHooks : CPUHooks {
+    unsigned instructions = 0, fetches = 0, reads = 0, writes = 0;
+    uint8_t lastWrite = 0;
+
+    void preInstruction(DecodedInstruction const &, CPUState const &) override { ++instructions; }
+    void memoryFetch(uint16_t, uint8_t) override { ++fetches; }
+    void memoryRead(uint16_t, uint8_t) override { ++reads; }
+    void memoryWrite(uint16_t, uint8_t data) override { ++writes; lastWrite = data; }
+};
+
+static bool hooksTest() {
+    //LDA #$2a; JSR $1000; STA $10; INC $10; NOP
+    const uint8_t program[] = {0xa9, 0x2a, 0x20, 0x00, 0x10, 0x85, 0x10, 0xe6, 0x10, 0xea};
+    Memory memory;
+    for(uint16_t i = 0; i < sizeof(program); ++i) {
+        memory.write(0x0200+i, program[i]);
+    }
+
+    //The trap switches to the hooked interpreter: the hooks see the
+    //stack reads of its RTS, then STA, INC and NOP
+    CountingHooks counter;
+    MOS6502 cpu(memory.data());
+    cpu.setTrap(0x1000, [&counter](MOS6502& c) {
+        c.setHooks(&counter);
+    }, 0);
+    cpu.setBreakpoint(0x020a);
+    cpu.execute(0x0200, 0xffff);
+
+    std::cout << "Hooks\n" << cpu.info() << "\n";
+
+    bool hooked = counter.instructions == 3 && counter.fetches == 5 &&
+                  counter.reads == 2+1 && counter.writes == 2 &&
+                  counter.lastWrite == 0x2b;
+
+    //Back to the fast path
+    cpu.setHooks(nullptr);
+    cpu.setPC(0x0205);
+    cpu.step();
+
+    return hooked && counter.instructions == 3 && memory.read(0x10) == 0x2a;
+}
+
+/*
+    Two machines with their own memory: same program,
+    different data, no interference.
+*/
+static bool memoryTest() {
+    //LDA $10; ASL A; STA $11; NOP
+    const uint8_t program[] = {0xa5, 0x10, 0x0a, 0x85, 0x11, 0xea};
+    Memory first;
+    Memory second(true);
+    for(uint16_t i = 0; i < sizeof(program); ++i) {
+        first.write(0x0200+i, program[i]);
+        second.write(0x0200+i, program[i]);
+    }
+    first.write(0x10, 0x11);
+    second.write(0x10, 0x21);
+
+    MOS6502 a(first.data());
+    MOS65C02 b(second.data());
+    a.execute(0x0200, 0x0205);
+    b.execute(0x0200, 0x0205);
+
+    std::cout << "Memory instances" << (second.usesHugePages() ? " (huge pages)" : "")
+              << first.dump(0x0010, 0x001f) << "\n";
+
+    bool aligned = reinterpret_cast<uintptr_t>(first.data()) % 64 == 0 &&
+                   reinterpret_cast<uintptr_t>(second.data()) % 64 == 0;
+
+    return aligned && first.read(0x11) == 0x22 && second.read(0x11) == 0x42 &&
+           a.readMemory(0x11) == 0x22 && first.dump(0x0010, 0x0011) == "\n0010: 11 22 \n";
+}
+
+/*
+    The CPU writes three pages: only those end up in the
+    incremental snapshot and are restored by the reset.
+*/
+static bool dirtyPagesTest() {
+    //LDA #$aa; STA $10; STA $0300; STA $1234; NOP
+    const uint8_t program[] = {0xa9, 0xaa, 0x85, 0x10, 0x8d, 0x00, 0x03, 0x8d, 0x34, 0x12, 0xea};
+    Memory memory;
+    for(uint16_t i = 0; i < sizeof(program); ++i) {
+        memory.write(0x0200+i, program[i]);
+    }
+    memory.setBaseline();
+
+    MemorySnapshot full, incremental;
+    memory.snapshot(full);
+    MOS6502 cpu(memory.pages());
+    cpu.execute(0x0200, 0x020a);
+
+    bool dirty = memory.isDirty(0x00) && memory.isDirty(0x03) && memory.isDirty(0x12) &&
+                 !memory.isDirty(0x02);
+    memory.snapshot(incremental, full.generation);
+    bool snapshots = full.pages.size() == 0x100 && incremental.pages.size() == 3 &&
+                     incremental.pages[2] == 0x12 && incremental.data[2*0x100 + 0x34] == 0xaa &&
+                     memory.pageGeneration(0x12) == incremental.generation && !memory.isDirty(0x12);
+
+    std::cout << "Dirty pages\n" << cpu.info() << "\n";
+
+    std::size_t restored = memory.resetToBaseline();
+    bool reset = restored == 3 && memory.read(0x10) == 0x00 && memory.read(0x1234) == 0x00 &&
+                 memory.read(0x0200) == 0xa9 && memory.resetToBaseline() == 0;
+
+    memory.restore(incremental);
+    bool restoredSnapshot = memory.read(0x0300) == 0xaa && memory.read(0x1234) == 0xaa &&
+                            memory.resetToBaseline() == 3 && memory.read(0x0300) == 0x00;
+
+    //A CPU built on data() writes through its own page table
+    MOS6502 flat(memory.data());
+    flat.execute(0x0200, 0x020a);
+    bool untracked = memory.read(0x1234) == 0xaa && !memory.isDirty(0x12) &&
+                     memory.resetToBaseline() == 0;
+
+    return dirty && snapshots && reset && restoredSnapshot && untracked;
+}
+
+/*
+    Dumps up to the end of the address space, and the
+    ranges that differ between two images or snapshots.
+*/
+static bool dumpTest() {
+    Memory memory;
+    const char text[] = "6502!";
+    for(uint16_t i = 0; i < 5; ++i) {
+        memory.write(0x0200+i, text[i]);
+    }
+    memory.write(0xfffe, 0x34);
+    memory.write(0xffff, 0x12);
+
+    std::string tail = memory.dump(0xfffe, 0xffff);
+    std::cout << "Dump" << tail;
+
+    char line[DUMP_LINE + 1] = {0};
+    bool partial = memory.hexDump(0x0200, 0x0204, line) == DUMP_LINE && std::string(line) ==
+        "0200  36 35 30 32 21                                    |6502!           |\n";
+
+    std::vector<char> all(dumpSize(0x10000));
+    bool whole = memory.hexDump(0x0000, 0xffff, all.data()) == all.size() &&
+                 std::string(&all[all.size() - DUMP_LINE], DUMP_LINE) ==
+                 "fff0  00 00 00 00 00 00 00 00  00 00 00 00 00 00 34 12  |..............4.|\n";
+
+    //Byte ranges, a whole 16-byte block and the scalar tail
+    std::vector<uint8_t> a(0x10000), b(0x10000);
+    for(uint16_t addr : {5, 6, 17, 0xffff}) b[addr] = 1;
+    std::fill(b.begin() + 0x1000, b.begin() + 0x1010, 0xff);
+    std::vector<MemoryRange> ranges = diff(a.data(), b.data(), a.size());
+    std::vector<MemoryRange> expected = {{5, 2}, {17, 1}, {0x1000, 16}, {0xffff, 1}};
+    std::vector<MemoryRange> shifted = diff(a.data() + 3, b.data() + 3, 21, 0x0103);
+    std::vector<MemoryRange> expectedShifted = {{0x0105, 2}, {0x0111, 1}};
+
+    //Snapshots: the pages written in between
+    MemorySnapshot before, after;
+    memory.snapshot(before);
+    memory.write(0x02ff, 0xaa);
+    memory.write(0x0300, 0xbb);
+    memory.write(0x8000, 0xcc);
+    memory.snapshot(after);
+    std::vector<MemoryRange> snapshotRanges = diff(before, after);
+    std::vector<MemoryRange> expectedSnapshot = {{0x02ff, 2}, {0x8000, 1}};
+
+    return tail == "\nfffe: 34 12 \n" && memory.dump(0x0008, 0x0010) ==
+           "\n0008: 00 00 00 00 00 00 00 00 \n0010: 00 \n" &&
+           memory.dump(0x0020, 0x0010) == "\n" && memory.hexDump(0x0020, 0x0010, line) == 0 &&
+           partial && whole && ranges == expected && shifted == expectedShifted &&
+           snapshotRanges == expectedSnapshot && diff(a.data(), a.data(), a.size()).empty();
+}
+
+/*
+    A program reading a counter device, interrupted by the
+    device every 16 reads: going back must give the same states
+    as the first run, with the device reads and the IRQ line
+    taken from the log (the device does not see them again).
+*/
+static bool rewindTest() {
+    //$0200: CLI; loop: LDA $d000; STA $10; INC $11; JMP loop
+    //$0300: INC $12; LDA $d001; RTI
+    const uint8_t program[] = {0x58, 0xad, 0x00, 0xd0, 0x85, 0x10, 0xe6, 0x11, 0x4c, 0x01, 0x02};
+    const uint8_t handler[] = {0xe6, 0x12, 0xad, 0x01, 0xd0, 0x40};
+    //Second machine, run by run()
+    Memory memory, fastMemory;
+    for(Memory* m : {&memory, &fastMemory}) {
+        for(uint16_t i = 0; i < sizeof(program); ++i) m->write(0x0200+i, program[i]);
+        for(uint16_t i = 0; i < sizeof(handler); ++i) m->write(0x0300+i, handler[i]);
+        m->write(0xfffe, 0x00);
+        m->write(0xffff, 0x03);
+        m->mapIO(0xd000, 0x1000);
+    }
+
+    //Reads of $d000 count, every 16th asserts the line, $d001 releases it
+    auto device = [](Rewind<NMOS6502>*& self, unsigned& counter) {
+        return [&self, &counter](uint16_t addr) -> uint8_t {
+            if(addr == 0xd001) {
+                self->cpu().scheduler().setIRQLine(0, false);
+                return 0;
+            }
+            if(++counter % 16 == 0) self->cpu().scheduler().setIRQLine(0, true);
+            return counter;
+        };
+    };
+    Rewind<NMOS6502>* self = nullptr;
+    unsigned counter = 0;
+    Rewind<NMOS6502> rewind(memory, [](uint16_t, uint8_t) {}, device(self, counter), 50, 4);
+    self = &rewind;
+    rewind.cpu().setPC(0x0200);
+
+    //State after every instruction of the first run
+    struct State { CPUState cpu; uint8_t counters[3]; };
+    auto stateOf = [](Rewind<NMOS6502>& r, Memory& m) {
+        return State{r.cpu().getState(), {m.read(0x10), m.read(0x11), m.read(0x12)}};
+    };
+    auto state = [&] {
+        return stateOf(rewind, memory);
+    };
+    auto same = [](State const & a, State const & b) {
+        return a.cpu.PC == b.cpu.PC && a.cpu.AC == b.cpu.AC && a.cpu.SR == b.cpu.SR &&
+               a.cpu.SP == b.cpu.SP && a.cpu.cycles == b.cpu.cycles &&
+               std::equal(a.counters, a.counters + 3, b.counters);
+    };
+    std::vector<State> states{state()};
+    while(rewind.cpu().getCycles() < 1000) {
+        rewind.step();
+        states.push_back(state());
+    }
+    uint64_t end = rewind.position();
+    unsigned reads = counter;
+
+    bool back = true;
+    for(int i = 0; i < 30; ++i) {
+        back = back && rewind.reverseStep() && same(state(), states[rewind.position()]);
+    }
+    bool replayed = rewind.replaying() && counter == reads;
+
+    //Forward again to the present, then live
+    while(rewind.position() < end) {
+        rewind.step();
+        replayed = replayed && same(state(), states[rewind.position()]);
+    }
+    replayed = replayed && !rewind.replaying() && counter == reads;
+    for(int i = 0; i < 40; ++i) {
+        rewind.step();
+        states.push_back(state());
+    }
+    bool live = counter > reads;
+
+    //Latest instruction at STA $10 before now, and the bounded window
+    rewind.setBreakpoint(0x0204);
+    uint64_t now = rewind.position();
+    bool found = rewind.reverseContinue() && rewind.cpu().getPC() == 0x0204 &&
+                 rewind.position() < now && now - rewind.position() <= 8 &&
+                 same(state(), states[rewind.position()]);
+    bool bounded = rewind.snapshots() == 4 && !rewind.seek(0);
+
+    //run() leaves the core in its fast loop between snapshots: going
+    //back must replay the same instructions, across an IRQ
+    Rewind<NMOS6502>* fastSelf = nullptr;
+    unsigned fastCounter = 0;
+    Rewind<NMOS6502> fast(fastMemory, [](uint16_t, uint8_t) {}, device(fastSelf, fastCounter), 50, 4);
+    fastSelf = &fast;
+    fast.cpu().setPC(0x0200);
+    fast.run(states.back().cpu.cycles);
+    bool ran = fast.position() == states.size() - 1 && same(stateOf(fast, fastMemory), states.back());
+    uint8_t irqs = fastMemory.read(0x12);
+    while(fast.reverseStep()) {
+        ran = ran && same(stateOf(fast, fastMemory), states[fast.position()]);
+    }
+    ran = ran && fastMemory.read(0x12) < irqs;
+
+    std::cout << "Rewind\n" << rewind.cpu().info() << "\n";
+
+    return back && replayed && live && found && bounded && ran && memory.read(0x12) > 0;
+}
+
+/*
+    Streaming loaders: every format from a buffer, Intel HEX
+    from a pipe, and the errors.
+*/
+static bool loaderTest() {
+    auto text = [](char const * string) { return reinterpret_cast<uint8_t const *>(string); };
+    Memory memory;
+    MemoryTarget target(memory);
+
+    char const hex[] = "a9 10\nA5 30\r\n";
+    LoadResult hexResult = load(LoadFormat::hex, text(hex), sizeof(hex)-1, target, 0x0200);
+    bool hexLoaded = hexResult && hexResult.bytes == 4 &&
+                     memory.read(0x0200) == 0xa9 && memory.read(0x0203) == 0x30;
+    LoadResult bad = load(LoadFormat::hex, text("a9\n123"), 6, target);
+    bool hexErrors = bad.error == LoadError::syntax && bad.line == 2 &&
+                     load(LoadFormat::hex, text("a9 1g"), 5, target).error == LoadError::syntax;
+
+    //3 bytes at $0030, then $cafe at $10000 (out of the 64 KiB buffer)
+    char const intel[] = ":0300300002337A1E\n:04000005000F0400E4\n:00000001FF\n";
+    char const linear[] = ":020000040001F9\n:02000000CAFE36\n:00000001FF\n";
+    std::vector<uint8_t> buffer(0x10000);
+    BufferTarget bufferTarget(buffer.data(), buffer.size());
+    LoadResult intelResult = load(LoadFormat::intelHex, text(intel), sizeof(intel)-1, bufferTarget);
+    bool intelLoaded = intelResult && intelResult.bytes == 3 && buffer[0x32] == 0x7a &&
+                       intelResult.hasEntry && intelResult.entry == 0x000f0400 &&
+                       load(LoadFormat::intelHex, text(linear), sizeof(linear)-1, bufferTarget).error == LoadError::range;
+    LoadResult checksum = load(LoadFormat::intelHex, text(":0300300002337A1F\n:00000001FF"), 29, target);
+    bool intelErrors = checksum.error == LoadError::checksum && checksum.line == 1 &&
+                       load(LoadFormat::intelHex, text(":0300300002337A1E\n"), 18, target).error == LoadError::syntax;
+
+    char const srecord[] = "S1070200A910A53068\nS5030001FB\nS9030200FA\n";
+    LoadResult sResult = load(LoadFormat::sRecord, text(srecord), sizeof(srecord)-1, target);
+    bool sLoaded = sResult && sResult.bytes == 4 && sResult.entry == 0x0200 &&
+                   load(LoadFormat::sRecord, text("S5030002FA\n"), 11, target).error == LoadError::checksum;
+
+    uint8_t const prg[] = {0x01, 0x08, 0xaa, 0xbb};
+    LoadResult prgResult = load(LoadFormat::prg, prg, sizeof(prg), target);
+    bool prgLoaded = prgResult && prgResult.entry == 0x0801 && memory.read(0x0802) == 0xbb;
+
+    int fds[2];
+    bool piped = pipe(fds) == 0 && write(fds[1], intel, sizeof(intel)-1) == sizeof(intel)-1;
+    close(fds[1]);
+    memory.write(0x0032, 0x00);
+    piped = piped && load(LoadFormat::intelHex, fds[0], target) && memory.read(0x0032) == 0x7a;
+    close(fds[0]);
+
+    std::cout << "Loaders\n";
+
+    return hexLoaded && hexErrors && intelLoaded && intelErrors && sLoaded && prgLoaded && piped &&
+           loadFile(LoadFormat::binary, "./missing.bin", target).error == LoadError::open;
+}
+
+/*
+    One ROM file mapped into two memories: both CPUs run the
+    same physical pages, the writes to the ROM are dropped.
+*/
+static bool romImageTest() {
+    //$f000: LDA $f800; STA $11; INC $f800; LDA $f800; STA $12; NOP
+    const uint8_t program[] = {0xad, 0x00, 0xf8, 0x85, 0x11, 0xee, 0x00, 0xf8,
+                               0xad, 0x00, 0xf8, 0x85, 0x12, 0xea};
+    std::vector<uint8_t> rom(0x1000, 0x00);
+    std::copy(std::begin(program), std::end(program), rom.begin());
+    rom[0x0800] = 0x5a;
+
+    std::string fileName = "/tmp/mos6502_rom_test.bin";
+    std::ofstream(fileName, std::ios::binary).write(reinterpret_cast<char const *>(rom.data()), rom.size());
+    ROMImage image(fileName);
+
+    Memory first;
+    Memory second;
+    bool mapped = first.mapROM(0xf000, image) && second.mapROM(0xf000, image) &&
+                  !first.mapROM(0xf001, image);
+
+    MOS6502 a(first.pages());
+    MOS65C02 b(second.pages());
+    a.execute(0xf000, 0xf00c);
+    b.execute(0xf000, 0xf00c);
+
+    std::cout << "ROM image\n" << a.info() << "\n";
+
+    bool shared = first.pages().read[15] == image.data() && second.pages().read[15] == image.data();
+    bool ran = first.read(0x11) == 0x5a && first.read(0x12) == 0x5a &&
+               second.read(0x11) == 0x5a && second.read(0x12) == 0x5a;
+    bool readOnly = image.data()[0x0800] == 0x5a && first.data()[0xf800] == 0x00;
+
+    first.mapRAM(0xf000, 0x1000);
+    return mapped && shared && ran && readOnly && first.read(0xf800) == 0x00;
+}
+
+/*
+    1 MiB in 8 KiB banks: the program selects every bank in
+    $8000-$9fff through the register at $c000 (I/O on the Bus)
+    and copies its first byte to $0300+bank.
+*/
+static bool bankedMemoryTest() {
+    BankedMemory memory(1 << 20, 0x2000);
+    for(std::size_t bank = 0; bank < memory.banks(); ++bank) {
+        memory.data()[bank * memory.windowSize()] = static_cast<uint8_t>(bank);
+    }
+
+    //LDX #0; STX $c000; LDA $8000; STA $0300,X; INX; CPX #$80; BNE -14; NOP
+    const uint8_t program[] = {0xa2, 0x00, 0x8e, 0x00, 0xc0, 0xad, 0x00, 0x80, 0x9d, 0x00, 0x03,
+                               0xe8, 0xe0, 0x80, 0xd0, 0xf2, 0xea};
+    memory.select(0, 0);
+    for(uint16_t i = 0; i < sizeof(program); ++i) {
+        memory.write(0x0200+i, program[i]);
+    }
+
+    Bus bus;
+    BankRegisters banks(memory, 4, 1);
+    bus.map(0xc000, 0xc000, banks);
+
+    MOS6502 cpu(memory.pages(),
+        [&bus](uint16_t addr, uint8_t data) { bus.write(addr, data); },
+        [&bus](uint16_t addr) { return bus.read(addr); });
+    cpu.execute(0x0200, 0x0210);
+
+    std::cout << "Banked memory\n" << cpu.info() << "\n";
+
+    bool copied = memory.banks() == 128 && memory.selected(4) == 127 && bus.read(0xc000) == 127;
+    for(unsigned bank = 0; bank < 128; ++bank) {
+        copied = copied && memory.read(0x0300 + bank) == bank;
+    }
+
+    //The window points into the store, a read-only window drops the writes
+    bool direct = memory.pages().read[8] == memory.data() + 127 * 0x2000;
+    memory.select(5, 3, true);
+    cpu.writeMemory(0xa000, 0x55);
+    bool readOnly = cpu.readMemory(0xa000) == 3 && memory.data()[3 * 0x2000] == 3;
+
+    return copied && direct && readOnly && cpu.getPC() == 0x0211;
+}
+
+/*
+    Access counters of a loop, the hottest pages, the
+    difference after a second run and the exports.
+*/
+static bool heatmapTest() {
+    //LDX #$03; STA $10; DEX; BNE *-3; NOP
+    const uint8_t program[] = {0xa2, 0x03, 0x85, 0x10, 0xca, 0xd0, 0xfb, 0xea};
+    Memory memory;
+    for(uint16_t i = 0; i < sizeof(program); ++i) {
+        memory.write(0x0200+i, program[i]);
+    }
+
+    Heatmap heatmap;
+    MOS6502 cpu(memory.data());
+    cpu.setHooks(&heatmap);
+    cpu.setBreakpoint(0x0207);
+    cpu.execute(0x0200, 0xffff);
+
+    bool counted = heatmap.fetchCount(0x0200) == 1 && heatmap.fetchCount(0x0201) == 1 &&
+                   heatmap.fetchCount(0x0202) == 3 &&
+                   heatmap.fetchCount(0x0203) == 3 && heatmap.writeCount(0x0010) == 3 &&
+                   heatmap.readCount(0x0010) == 0 && heatmap.fetchCount(0x0207) == 0;
+
+    std::vector<PageHeat> hottest = heatmap.hottestPages(10);
+    bool summary = hottest.size() == 2 && hottest[0].start == 0x0200 && hottest[0].fetches == 17 &&
+                   hottest[0].reads == 0 &&
+                   hottest[1].start == 0x0000 && hottest[1].writes == 3;
+
+    //Second run: only the loop (no LDX), X wraps around to 0 after 256 iterations
+    Heatmap before = heatmap;
+    cpu.execute(0x0202, 0xffff);
+    std::vector<PageChange> changes = heatmap.diffPages(before, 10);
+    bool diff = changes.size() == 2 && changes[0].start == 0x0200 && changes[0].fetches == 256*5 &&
+                changes[1].start == 0x0000 && changes[1].writes == 256;
+
+    //Binary round trip
+    FILE* file = std::tmpfile();
+    Heatmap loaded;
+    bool saved = file && heatmap.save(fileno(file)) && lseek(fileno(file), 0, SEEK_SET) == 0 &&
+                 loaded.load(fileno(file)) && loaded.fetchCount(0x0202) == 3 + 256 &&
+                 loaded.diffPages(heatmap, 10).empty();
+    if(file) std::fclose(file);
+
+    //CSV of the changes
+    int pipeCSV[2];
+    if(pipe(pipeCSV) != 0) return false;
+    Heatmap empty;
+    bool written = heatmap.writeCSV(pipeCSV[1]) && empty.writeDiffCSV(before, pipeCSV[1]);
+    close(pipeCSV[1]);
+    char text[1024];
+    ssize_t n = read(pipeCSV[0], text, sizeof(text));
+    close(pipeCSV[0]);
+    std::string csv(text, n > 0 ? n : 0);
+
+    std::cout << "Heatmap\n" << csv;
+
+    return counted && summary && diff && saved && written &&
+           csv.find("address,reads,writes,fetches\n0010,0,259,0\n0200,0,0,1\n0201,0,0,1\n") == 0 &&
+           csv.find("\n0010,0,-3,0\n0200,0,0,-1\n0201,0,0,-1\n") != std::string::npos;
+}
+
+//Registers of a memory-mapped device: counts the accesses
+struct RegisterDevice : Device {
+    uint8_t registers[4] = {0};
+    unsigned accesses = 0;
+
+    uint8_t read(uint16_t offset) override { ++accesses; return registers[offset]; }
+    void write(uint16_t offset, uint8_t data) override { ++accesses; registers[offset] = data; }
+};
+
+/*
+    Map RAM, a mirror, a ROM and a device sharing a page with the RAM,
+    then run a program through the Bus.
+*/
+static bool busTest() {
+    RAM ram(0x8000);
+    Mirror mirror(ram, 0x0800);
+    //LDA #$2a; STA $6001; STA $0810; LDX $6001; NOP
+    ROM rom({0xa9, 0x2a, 0x8d, 0x01, 0x60, 0x8d, 0x10, 0x08, 0xae, 0x01, 0x60, 0xea});
+    RegisterDevice device;
+
+    Bus bus;
+    bus.map(0x0000, 0x7fff, ram);
+    bus.map(0x0800, 0x1fff, mirror);
+    bus.map(0xc000, 0xc0ff, rom);
+    bus.map(0x6000, 0x6003, device);
+
+    MOS6502 cpu = MOS6502(
+        [&bus](uint16_t addr, uint8_t data) { bus.write(addr, data); },
+        [&bus](uint16_t addr) { return bus.read(addr); });
+    cpu.setBreakpoint(0xc00b);
+    cpu.execute(0xc000, 0xffff);
+
+    std::cout << "Bus\n" << cpu.info() << "\n";
+
+    //ROM writes are ignored, unmapped reads are 0xff
+    bus.write(0xc000, 0x00);
+
+    return cpu.getX() == 0x2a && device.registers[1] == 0x2a &&
+           device.accesses == 2 && ram.data()[0x0010] == 0x2a &&
+           bus.read(0x1810) == 0x2a && bus.read(0x6004) == 0x00 &&
+           bus.read(0xc000) == 0xa9 && bus.read(0x9000) == 0xff;
+}
+
+/*
+    Free-running VIA timer 1 with N=$100: the IRQs must be taken at the
+    first instruction boundary after each underflow (load+N+1, then
+    every N+2 cycles) on both engines, and the counter read by the
+    handler must be the one of the cycle of the read.
+*/
+template<bool cycleExact>
+static bool viaTest() {
+    RAM ram(0x10000);
+    //LDA #$C0; STA IER; LDA #$40; STA ACR; LDA #$00; STA T1CL; LDA #$01; STA T1CH; CLI
+    const uint8_t program[] = {0xa9, 0xc0, 0x8d, 0x0e, 0x60, 0xa9, 0x40, 0x8d, 0x0b, 0x60,
+                               0xa9, 0x00, 0x8d, 0x04, 0x60, 0xa9, 0x01, 0x8d, 0x05, 0x60, 0x58};
+    for(uint16_t i = 0; i < sizeof(program); ++i) ram.data()[0x0200+i] = program[i];
+    //NOP sled
+    for(uint16_t i = 0x0215; i < 0x0600; ++i) ram.data()[i] = 0xea;
+    //IRQ handler: LDA T1CL; RTI
+    const uint8_t handler[] = {0xad, 0x04, 0x60, 0x40};
+    for(uint16_t i = 0; i < sizeof(handler); ++i) ram.data()[0x0700+i] = handler[i];
+    ram.data()[0xfffe] = 0x00;
+    ram.data()[0xffff] = 0x07;
+
+    Bus bus;
+    bus.map(0x0000, 0xffff, ram);
+    MOS6502 cpu = MOS6502(
+        [&bus](uint16_t addr, uint8_t data) { bus.write(addr, data); },
+        [&bus](uint16_t addr) { return bus.read(addr); });
+    CycleEngine<NMOS6502> engine(cpu);
+    VIA via(cpu.scheduler());
+    bus.map(0x6000, 0x600f, via);
+
+    auto step = [&] {
+        if constexpr (cycleExact) engine.step();
+        else cpu.step();
+    };
+
+    cpu.setPC(0x0200);
+    while(cpu.getPC() != 0x0214) step();
+    uint64_t load = cpu.getCycles();
+
+    uint64_t entries[2];
+    for(uint64_t & entry : entries) {
+        do step(); while(cpu.getPC() != 0x0700);
+        entry = cpu.getCycles() - load;
+    }
+
+    std::cout << "VIA timer" << (cycleExact ? " (cycle-exact)" : "") << "\n" << cpu.info() << "\n";
+
+    //1st underflow at 257, boundary at 258 (NOPs from 0), IRQ takes 7 cycles.
+    //The handler reads T1CL at 269 (phase 11: $100-11 = $F5) and returns
+    //at 275. 2nd underflow at 515, boundary at 515 (NOPs from 275).
+    //The flag of the 2nd IRQ is cleared by the handler, not yet run.
+    return entries[0] == 265 && entries[1] == 522 && cpu.getAC() == 0xf5 &&
+           via.read(VIA::IFR) == (0x80 | VIA::T1_FLAG);
+}
+
+/*
+    ACIA on pipes: "HI" is flushed by the timer, the received byte is
+    only seen after the poll interval, "x\n" is flushed by the newline.
+*/
+static bool aciaTest() {
+    RAM ram(0x10000);
+    const uint8_t program[] = {
+        0xa9, 0x48, 0x8d, 0x00, 0x88,   //LDA #'H'; STA DATA
+        0xa9, 0x49, 0x8d, 0x00, 0x88,   //LDA #'I'; STA DATA
+        0xad, 0x01, 0x88, 0x29, 0x08,   //LDA STATUS; AND #RDRF
+        0xf0, 0xf9,                     //BEQ *-7
+        0xad, 0x00, 0x88, 0x8d, 0x00, 0x88, //LDA DATA; STA DATA
+        0xa9, 0x0a, 0x8d, 0x00, 0x88,   //LDA #'\n'; STA DATA
+        0xa9, 0x5a, 0x8d, 0x00, 0x88,   //LDA #'Z'; STA DATA
+        0xa2, 0x40, 0xca, 0xd0, 0xfd,   //LDX #$40; DEX; BNE *-3
+        0xea};
+    for(uint16_t i = 0; i < sizeof(program); ++i) ram.data()[0x0200+i] = program[i];
+
+    int in[2], out[2];
+    if(pipe(in) != 0 || pipe(out) != 0) return false;
+    fcntl(out[0], F_SETFL, O_NONBLOCK);
+
+    Bus bus;
+    bus.map(0x0000, 0xffff, ram);
+    MOS6502 cpu = MOS6502(
+        [&bus](uint16_t addr, uint8_t data) { bus.write(addr, data); },
+        [&bus](uint16_t addr) { return bus.read(addr); });
+    ACIA acia(cpu.scheduler(), in[0], out[1]);
+    acia.setFlushDelay(100);
+    acia.setPollInterval(1000);
+    bus.map(0x8800, 0x8803, acia);
+
+    char received[16];
+
+    //Buffered, not flushed yet; first poll of the input
+    cpu.setBreakpoint(0x020f);
+    cpu.execute(0x0200, 0xffff);
+    bool buffered = ::read(out[0], received, sizeof(received)) < 0;
+
+    if(::write(in[1], "x", 1) != 1) return false;
+    cpu.setBreakpoint(0x0226);
+    cpu.execute(0x020f, 0xffff);
+
+    ssize_t n = ::read(out[0], received, sizeof(received));
+
+    std::cout << "ACIA\n" << cpu.info() << "\n";
+
+    //The flags of the input fd are untouched, a full non-blocking
+    //output takes nothing (the bytes stay in the ACIA buffer)
+    bool blocking = !(fcntl(in[0], F_GETFL) & O_NONBLOCK);
+    fcntl(out[1], F_SETFL, O_NONBLOCK);
+    std::vector<uint8_t> fill(4096, 'x');
+    while(::write(out[1], fill.data(), fill.size()) > 0) {}
+    FdLink link(in[0], out[1]);
+    std::size_t full = link.send(fill.data(), 3);
+
+    close(in[0]); close(in[1]); close(out[0]); close(out[1]);
+
+    return buffered && n == 5 && std::string(received, n) == "HIx\nZ" &&
+           cpu.getCycles() > 1000 && blocking && full == 0;
+}
+
+/*
+    1 bit per pixel 16x4 framebuffer: only the lines written by the CPU
+    are rendered, the frame matches its own PPM and then differs by the
+    pixel written afterwards. Unsupported depths give 8 bits per pixel.
+*/
+static bool framebufferTest() {
+    RAM ram(0x10000);
+    //LDA #$80; STA $4000; LDA #$01; STA $4007
+    const uint8_t program[] = {0xa9, 0x80, 0x8d, 0x00, 0x40, 0xa9, 0x01, 0x8d, 0x07, 0x40, 0xea};
+    for(uint16_t i = 0; i < sizeof(program); ++i) ram.data()[0x0200+i] = program[i];
+
+    Framebuffer screen(16, 4, 1);
+    Bus bus;
+    bus.map(0x0000, 0xffff, ram);
+    bus.map(0x4000, 0x4007, screen);
+    MOS6502 cpu = MOS6502(
+        [&bus](uint16_t addr, uint8_t data) { bus.write(addr, data); },
+        [&bus](uint16_t addr) { return bus.read(addr); });
+
+    unsigned first = screen.render();
+    cpu.setBreakpoint(0x020a);
+    cpu.execute(0x0200, 0xffff);
+    unsigned second = screen.render();
+    unsigned unchanged = screen.render();
+
+    std::cout << "Framebuffer\n" << cpu.info() << "\n";
+
+    uint8_t const * pixels = screen.pixels();
+    bool image = pixels[0] == 0xff && pixels[4] == 0x00 &&
+                 pixels[(3*16+15)*4] == 0xff && pixels[(3*16+14)*4] == 0x00;
+
+    std::string golden = "/tmp/mos6502_framebuffer_test.ppm";
+    bool saved = screen.savePPM(golden) && screen.savePNG("/tmp/mos6502_framebuffer_test.png");
+    long same = screen.compare(golden);
+    bus.write(0x4003, 0x01);
+    screen.render();
+    long different = screen.compare(golden);
+
+    //Depths that do not pack into bytes are 8 bits per pixel
+    Framebuffer zero(4, 2, 0), odd(4, 2, 3), deep(4, 2, 16);
+    odd.write(0x0005, 0xff);
+    bool depths = zero.size() == 8 && odd.size() == 8 && deep.size() == 8 &&
+                  zero.render() == 2 && odd.render() == 2 && deep.render() == 2 &&
+                  odd.pixels()[5*4] == 0xff && odd.pixels()[4*4] == 0x00;
+
+    return first == 4 && second == 2 && unchanged == 0 && image &&
+           saved && same == 0 && different == 1 && depths;
+}
+
+/*
+    One million values through a small SPSC queue between two threads,
+    the consumer sleeping on batched wakeups.
+*/
+static bool spscQueueTest() {
+    constexpr uint32_t COUNT = 1000000;
+    SPSCQueue<uint32_t, 256> queue;
+    Wakeup ready;
+    bool ordered = true;
+
+    std::thread consumer([&] {
+        uint32_t expected = 0;
+        uint32_t batch[64];
+        while(expected < COUNT) {
+            ready.wait([&] { return !queue.empty(); });
+            std::size_t n = queue.pop(batch, 64);
+            for(std::size_t i = 0; i < n; ++i) {
+                ordered = ordered && (batch[i] == expected++);
+            }
+        }
+    });
+
+    uint32_t batch[32];
+    for(uint32_t next = 0; next < COUNT; ) {
+        uint32_t n = 0;
+        while(n < 32 && next + n < COUNT) { batch[n] = next + n; ++n; }
+        std::size_t pushed = queue.push(batch, n);
+        next += pushed;
+        ready.notify();
+        if(pushed == 0) std::this_thread::yield();
+    }
+    consumer.join();
+
+    std::cout << "SPSC queue\n\n";
+
+    return ordered && queue.empty();
+}
+
+/*
+    ACIA on a QueueLink: the received byte comes from the input queue,
+    the echoed line reaches a host thread sleeping on the output queue.
+*/
+static bool aciaQueueTest() {
+    RAM ram(0x10000);
+    const uint8_t program[] = {
+        0xad, 0x01, 0x88, 0x29, 0x08,   //LDA STATUS; AND #RDRF
+        0xf0, 0xf9,                     //BEQ *-7
+        0xad, 0x00, 0x88, 0x8d, 0x00, 0x88, //LDA DATA; STA DATA
+        0xa9, 0x0a, 0x8d, 0x00, 0x88,   //LDA #'\n'; STA DATA
+        0xea};
+    for(uint16_t i = 0; i < sizeof(program); ++i) ram.data()[0x0200+i] = program[i];
+
+    ByteQueue toHost, fromHost;
+    Wakeup outputReady;
+    QueueLink link(&fromHost, &toHost, &outputReady);
+
+    Bus bus;
+    bus.map(0x0000, 0xffff, ram);
+    MOS6502 cpu = MOS6502(
+        [&bus](uint16_t addr, uint8_t data) { bus.write(addr, data); },
+        [&bus](uint16_t addr) { return bus.read(addr); });
+    ACIA acia(cpu.scheduler(), link);
+    bus.map(0x8800, 0x8803, acia);
+
+    std::string line;
+    std::thread host([&] {
+        uint8_t buffer[16];
+        while(line.empty() || line.back() != '\n') {
+            outputReady.wait([&] { return !toHost.empty(); });
+            std::size_t n = toHost.pop(buffer, sizeof(buffer));
+            line.append(reinterpret_cast<char*>(buffer), n);
+        }
+    });
+
+    fromHost.push('q');
+    cpu.setBreakpoint(0x0212);
+    cpu.execute(0x0200, 0xffff);
+    host.join();
+
+    std::cout << "ACIA (queues)\n" << cpu.info() << "\n";
+
+    return line == "q\n";
+}
+
+/*
+    Control a CPU running INX; JMP $0200 on its own thread.
+*/
+static bool asyncMachineTest() {
+    RAM ram(0x10000);
+    const uint8_t program[] = {0xe8, 0x4c, 0x00, 0x02};
+    for(uint16_t i = 0; i < sizeof(program); ++i) ram.data()[0x0200+i] = program[i];
+
+    Bus bus;
+    bus.map(0x0000, 0xffff, ram);
+    MOS6502 cpu = MOS6502(
+        [&bus](uint16_t addr, uint8_t data) { bus.write(addr, data); },
+        [&bus](uint16_t addr) { return bus.read(addr); });
+    cpu.setPC(0x0200);
+
+    AsyncMachine<NMOS6502> machine(cpu, 1000);
+
+    //Stops at the first instruction boundary at or after the target
+    CPUState reached = machine.runUntil(100000).get();
+    bool target = reached.cycles >= 100000 && reached.cycles < 100000 + 3 &&
+                  !machine.isRunning();
+
+    CPUState stepped = machine.stepAsync().get();
+    bool step = stepped.cycles == reached.cycles + (reached.PC == 0x0200 ? 2 : 3);
+
+    machine.resume().get();
+    while(machine.snapshot().cycles < stepped.cycles + 50000) {
+        std::this_thread::yield();
+    }
+    CPUState paused = machine.pause().get();
+    CPUState snapshot = machine.snapshot();
+    bool consistent = snapshot.cycles == paused.cycles && snapshot.X == paused.X &&
+                      snapshot.PC == paused.PC && cpu.getCycles() == paused.cycles;
+
+    std::cout << "Async machine\n" << cpu.info() << "\n";
+
+    return target && step && consistent;
+}
+
+static bool systemTest() {
+    //Core 0: INX; STX $8000 (shared); STX $0010 (private)
+    const uint8_t producer[] = {0xe8, 0x8e, 0x00, 0x80, 0x86, 0x10, 0x4c, 0x00, 0x02};
+    //Core 1: LDA $8000 (shared); STA $0020 (private)
+    const uint8_t consumer[] = {0xad, 0x00, 0x80, 0x85, 0x20, 0x4c, 0x00, 0x02};
+
+    bool result = true;
+    for(bool threaded : {false, true}) {
+        RAM ram0(0x8000), ram1(0x8000), shared(0x100);
+        for(uint16_t i = 0; i < sizeof(producer); ++i) ram0.data()[0x0200+i] = producer[i];
+        for(uint16_t i = 0; i < sizeof(consumer); ++i) ram1.data()[0x0200+i] = consumer[i];
+
+        System<NMOS6502> board(2, 50);
+        board.bus(0).map(0x0000, 0x7fff, ram0);
+        board.bus(1).map(0x0000, 0x7fff, ram1);
+        board.share(0x8000, 0x80ff, shared);
+        board.core(0).setPC(0x0200);
+        board.core(1).setPC(0x0200);
+        board.setThreaded(threaded);
+
+        board.run(100000);
+
+        //Both cores ran their cycles, only the shared page is common
+        bool cycles = board.core(0).getCycles() >= 100000 && board.core(1).getCycles() >= 100000 &&
+                      board.core(0).getCycles() < 100000 + 3 && board.core(1).getCycles() < 100000 + 3;
+        bool seen = ram1.data()[0x20] != 0 && shared.data()[0] != 0 && ram0.data()[0x10] != 0;
+        bool separate = ram0.data()[0x20] == 0 && ram1.data()[0x10] == 0;
+
+        result = result && cycles && seen && separate;
+    }
+
+    std::cout << "Multi-CPU system\n";
+
+    return result;
+}
+
+/*
+    Run the recompiler test ROM (VIA timer IRQs, JSR to code copied
+    into RAM, JMP indirect, decimal mode) on the interpreter and on
+    its translation: registers, cycles and RAM must be the same.
+*/
+static bool recompilerTest() {
+    std::ifstream file("./recompiler_test.bin", std::ios::binary);
+    std::vector<uint8_t> image{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+    ROM rom(image);
+
+    CPUState states[2];
+    RAM ram[2] = {RAM(0x8000), RAM(0x8000)};
+    for(int translated = 0; translated < 2; ++translated) {
+        Bus bus;
+        MOS6502 cpu = MOS6502(
+            [&bus](uint16_t addr, uint8_t data) { bus.write(addr, data); },
+            [&bus](uint16_t addr) { return bus.read(addr); });
+        VIA via(cpu.scheduler());
+        bus.map(0x0000, 0x7fff, ram[translated]);
+        bus.map(0x8000, 0x800f, via);
+        bus.map(0xf000, 0xffff, rom);
+        cpu.setPC(0xf000);
+
+        if(translated) {
+            recompiledTestROM(cpu, 300000);
+        } else {
+            while(cpu.getCycles() < 300000) cpu.step();
+        }
+        states[translated] = cpu.getState();
+    }
+
+    bool same = states[0].PC == states[1].PC && states[0].AC == states[1].AC &&
+                states[0].X == states[1].X && states[0].Y == states[1].Y &&
+                states[0].SR == states[1].SR && states[0].SP == states[1].SP &&
+                states[0].cycles == states[1].cycles &&
+                std::equal(ram[0].data(), ram[0].data() + 0x8000, ram[1].data());
+    //IRQs taken, RAM code and every handler of the jump table executed
+    bool ran = ram[1].data()[0x35] > 0 && ram[1].data()[0x12] > 0 &&
+               ram[1].data()[0x30] > 0 && ram[1].data()[0x31] > 0 &&
+               ram[1].data()[0x32] > 0 && ram[1].data()[0x33] > 0;
+
+    std::cout << "Recompiler\n";
+
+    return image.size() == 0x1000 && same && ran;
+}
+
+/*
+    Analyse the recompiler test ROM: the handlers reached through
+    JMP ($0020) are only found once the jump has been resolved while
+    running.
+*/
+static bool controlFlowTest() {
+    std::ifstream file("./recompiler_test.bin", std::ios::binary);
+    std::vector<uint8_t> image{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+    ControlFlow<NMOS6502> flow(image, 0xf000);
+
+    using Byte = ControlFlow<NMOS6502>::Byte;
+    //Reset, IRQ handler and JSR return addresses; the jump table is data
+    bool code = flow.type(0xf000) == Byte::opcode && flow.type(0xf001) == Byte::operand &&
+                flow.type(0xf078) == Byte::opcode && flow.type(0xf083) == Byte::data &&
+                flow.type(0xf043) == Byte::data;
+    bool sites = flow.indirectSites() == std::vector<uint16_t>{0xf040} &&
+                 flow.blockAt(0xf040) != nullptr && flow.blockAt(0xf040)->indirect &&
+                 flow.blockAt(0xf040)->successors.empty();
+    //Copy loop: BPL back to the block start, fall-through after it
+    ControlFlow<NMOS6502>::Block const * copy = flow.blockAt(0xf00c);
+    bool graph = copy && copy->start == 0xf00c && copy->last == 0xf013 &&
+                 copy->successors == std::vector<uint16_t>{0xf00c, 0xf015};
+    std::size_t blocks = flow.blocks().size();
+
+    //Resolve the indirect jump while running the ROM
+    Bus bus;
+    RAM ram(0x8000);
+    ROM rom(image);
+    MOS6502 cpu = MOS6502(
+        [&bus](uint16_t addr, uint8_t data) { bus.write(addr, data); },
+        [&bus](uint16_t addr) { return bus.read(addr); });
+    VIA via(cpu.scheduler());
+    bus.map(0x0000, 0x7fff, ram);
+    bus.map(0x8000, 0x800f, via);
+    bus.map(0xf000, 0xffff, rom);
+    ControlFlowTracker<NMOS6502> tracker(flow);
+    cpu.setHooks(&tracker);
+    cpu.setPC(0xf000);
+    while(cpu.getCycles() < 20000) cpu.step();
+
+    bool resolved = flow.type(0xf043) == Byte::opcode && flow.type(0xf059) == Byte::opcode &&
+                    flow.blockAt(0xf040)->successors.size() == 4 &&
+                    flow.blocks().size() > blocks;
+
+    std::cout << "Control flow\n";
+
+    return code && sites && graph && resolved;
+}
+
+/*
+    Format some instructions, a small image and the trace of a short
+    program.
+*/
+static bool disassemblerTest() {
+    Disassembler<CMOS65C02> disassembler;
+    disassembler.addSymbol(0x0010, "counter");
+    char out[Disassembler<CMOS65C02>::MAX_LINE];
+
+    auto format = [&](uint16_t addr, std::initializer_list<uint8_t> bytes) {
+        uint8_t b[3] = {0, 0, 0};
+        std::copy(bytes.begin(), bytes.end(), b);
+        return std::string(out, disassembler.line(addr, b, out));
+    };
+    bool lines = format(0xf000, {0xbd, 0x34, 0x12}) == "f000  bd 34 12  LDA $1234,X\n" &&
+                 format(0xf003, {0xd0, 0xfb}) == "f003  d0 fb     BNE $f000\n" &&
+                 format(0xf005, {0xb1, 0x10}) == "f005  b1 10     LDA (counter),Y\n" &&
+                 format(0xf007, {0x0a}) == "f007  0a        ASL A\n" &&
+                 format(0xf008, {0x7c, 0x00, 0x80}) == "f008  7c 00 80  JMP ($8000,X)\n" &&
+                 format(0xf00b, {0xa9, 0x2a}) == "f00b  a9 2a     LDA #$2a\n";
+
+    //Bulk: the last instruction does not fit in the image
+    const uint8_t image[] = {0xe8, 0x86, 0x10, 0x4c};
+    int pipeImage[2];
+    if(pipe(pipeImage) != 0) return false;
+    bool written = disassembler.disassemble(image, sizeof(image), 0x0200, pipeImage[1]);
+    close(pipeImage[1]);
+    char text[256];
+    ssize_t n = read(pipeImage[0], text, sizeof(text));
+    close(pipeImage[0]);
+    bool bulk = written && std::string(text, n > 0 ? n : 0) ==
+                "0200  e8        INX\n0201  86 10     STX counter\n0203  4c        .byte $4c\n";
+
+    //An image ending with an implied instruction: nothing is read past it
+    std::vector<uint8_t> tail{0xa9, 0x01, 0x60};
+    if(pipe(pipeImage) != 0) return false;
+    written = disassembler.disassemble(tail.data(), tail.size(), 0x0200, pipeImage[1]);
+    close(pipeImage[1]);
+    n = read(pipeImage[0], text, sizeof(text));
+    close(pipeImage[0]);
+    bulk = bulk && written && std::string(text, n > 0 ? n : 0) ==
+           "0200  a9 01     LDA #$01\n0202  60        RTS\n";
+
+    //Without symbols: the lines of every opcode, as line() formats them
+    Disassembler<CMOS65C02> plain;
+    std::vector<uint8_t> opcodes;
+    for(unsigned op = 0; op < 0x100; ++op) {
+        opcodes.insert(opcodes.end(), {uint8_t(op), uint8_t(op ^ 0x5a), uint8_t(op + 0x81)});
+    }
+    std::string expected;
+    for(std::size_t offset = 0; offset < opcodes.size(); ) {
+        expected.append(out, plain.line(0xff00 + offset, opcodes.data() + offset, out));
+        offset += instructionLength(INSTRUCTIONS<CMOS65C02>[opcodes[offset]].mode);
+    }
+    if(pipe(pipeImage) != 0) return false;
+    written = plain.disassemble(opcodes.data(), opcodes.size(), 0xff00, pipeImage[1]);
+    close(pipeImage[1]);
+    std::string listing;
+    while((n = read(pipeImage[0], text, sizeof(text))) > 0) listing.append(text, n);
+    close(pipeImage[0]);
+    bulk = bulk && written && listing == expected;
+
+    //Trace of LDX #$03; DEX; BNE *-3
+    RAM ram(0x10000);
+    const uint8_t program[] = {0xa2, 0x03, 0xca, 0xd0, 0xfd};
+    for(uint16_t i = 0; i < sizeof(program); ++i) ram.data()[0x0200+i] = program[i];
+    Bus bus;
+    bus.map(0x0000, 0xffff, ram);
+    MOS65C02 cpu = MOS65C02(
+        [&bus](uint16_t addr, uint8_t data) { bus.write(addr, data); },
+        [&bus](uint16_t addr) { return bus.read(addr); });
+    int pipeTrace[2], pipeText[2];
+    if(pipe(pipeTrace) != 0 || pipe(pipeText) != 0) return false;
+    {
+        TraceRecorder recorder(pipeTrace[1]);
+        cpu.setHooks(&recorder);
+        cpu.setPC(0x0200);
+        for(int i = 0; i < 7; ++i) cpu.step();
+        cpu.setHooks(nullptr);
+    }
+    close(pipeTrace[1]);
+    bool formatted = disassembler.disassembleTrace(pipeTrace[0], pipeText[1]);
+    close(pipeTrace[0]);
+    close(pipeText[1]);
+    std::string trace;
+    char chunk[256];
+    while((n = read(pipeText[0], chunk, sizeof(chunk))) > 0) trace.append(chunk, n);
+    close(pipeText[0]);
+    std::string first = "0200  a2 03     LDX #$03                A:00 X:00 Y:00 P:20 SP:ff CYC:0\n";
+    bool traced = formatted && trace.compare(0, first.size(), first) == 0 &&
+                  std::count(trace.begin(), trace.end(), '\n') == 7 &&
+                  trace.find("0203  d0 fd     BNE $0202               A:00 X:00 Y:00 P:22 SP:ff CYC:") != std::string::npos;
+
+    std::cout << "Disassembler\n" << trace;
+
+    return lines && bulk && traced;
+}
+
+/*
+    Lockstep of the interpreter with the cycle-exact engine and the
+    recompiled test ROM, then with an engine corrupting X on an INX:
+    the divergence is bisected down to that instruction.
+*/
+template<class Variant>
+static bool lockstepEngineTest(uint32_t seed, uint64_t blockCycles) {
+    Lockstep<Variant> lockstep;
+    CycleEngine<Variant> engine(lockstep.candidate());
+    lockstep.setEngine([&lockstep, &engine](uint64_t end) {
+        while(lockstep.candidate().getCycles() < end) engine.step();
+    });
+
+    std::vector<uint8_t> program(0x10000);
+    randomInstructions<Variant>(program.data(), program.size(), seed);
+    lockstep.load(0x0000, program.data(), program.size());
+    lockstep.start(CPUState{0x0400, 0x12, 0x34, 0x56, 0x20, 0xff, 0});
+    bool agreed = lockstep.run(2000000, blockCycles);
+    if(!agreed) {
+        Divergence const & d = lockstep.divergence();
+        std::cout << "Divergence after PC " << std::hex << d.before.PC << " cycle " << std::dec << d.before.cycles << "\n";
+    }
+    return agreed;
+}
+
+static bool lockstepTest() {
+    bool cycleExact = lockstepEngineTest<NMOS6502>(1, 1) && lockstepEngineTest<CMOS65C02>(2, 1000) &&
+                      lockstepEngineTest<RP2A03>(3, 1000);
+
+    //Recompiled ROM (its VIA is plain memory here)
+    std::ifstream file("./recompiler_test.bin", std::ios::binary);
+    std::vector<uint8_t> image{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+    Lockstep<NMOS6502> recompiled;
+    recompiled.setEngine([&recompiled](uint64_t end) { recompiledTestROM(recompiled.candidate(), end); });
+    recompiled.load(0xf000, image.data(), image.size());
+    recompiled.start(CPUState{0xf000, 0, 0, 0, 0x24, 0xff, 0});
+    bool translated = !image.empty() && recompiled.run(1000000, 10000);
+
+    //LDX #$00; loop: INX; STX $10; JMP loop
+    const uint8_t program[] = {0xa2, 0x00, 0xe8, 0x86, 0x10, 0x4c, 0x02, 0x02};
+    Lockstep<NMOS6502> broken;
+    broken.setEngine([&broken](uint64_t end) {
+        MOS6502& cpu = broken.candidate();
+        while(cpu.getCycles() < end) {
+            bool corrupt = cpu.readMemory(cpu.getPC()) == 0xe8 && cpu.getX() == 0x7f;
+            cpu.step();
+            if(corrupt) cpu.setX(cpu.getX() + 1);
+        }
+    });
+    broken.load(0x0200, program, sizeof(program));
+    broken.start(CPUState{0x0200, 0, 0, 0, 0x20, 0xff, 0});
+    bool detected = !broken.run(1000000, 50000);
+
+    Divergence const & d = broken.divergence();
+    std::cout << "Lockstep\n" << "Divergence after PC " << std::hex << d.before.PC
+              << ": X " << +d.reference.X << " (reference) " << +d.candidate.X << " (candidate)\n"
+              << std::dec;
+
+    //Same registers and cycles, but the write of STA $0380 is lost
+    //LDX #$00; loop: INX; TXA; STA $0300,X; JMP loop
+    const uint8_t stores[] = {0xa2, 0x00, 0xe8, 0x8a, 0x9d, 0x00, 0x03, 0x4c, 0x02, 0x02};
+    Lockstep<NMOS6502> lost;
+    lost.setEngine([&lost](uint64_t end) {
+        MOS6502& cpu = lost.candidate();
+        while(cpu.getCycles() < end) {
+            bool skip = cpu.readMemory(cpu.getPC()) == 0x9d && cpu.getX() == 0x80;
+            uint8_t old = cpu.readMemory(0x0380);
+            cpu.step();
+            if(skip) cpu.writeMemory(0x0380, old);
+        }
+    });
+    lost.load(0x0200, stores, sizeof(stores));
+    lost.start(CPUState{0x0200, 0, 0, 0, 0x20, 0xff, 0});
+    bool written = !lost.run(1000000, 50000);
+    Divergence const & m = lost.divergence();
+
+    //Cycle 2 + 127 loops of 8 cycles: the 128th INX
+    return cycleExact && translated && detected && d.before.PC == 0x0202 && d.before.cycles == 2 + 127*8 &&
+           d.reference.PC == 0x0203 && d.reference.X == 0x80 && d.candidate.X == 0x81 &&
+           d.reference.cycles == d.candidate.cycles && d.memory.empty() &&
+           broken.reference().getX() == 0x80 && broken.candidate().getX() == 0x81 &&
+           written && m.before.PC == 0x0204 && m.before.cycles == 2 + 127*12 + 4 &&
+           m.reference.PC == m.candidate.PC && m.reference.cycles == m.candidate.cycles &&
+           m.memory == std::vector<MemoryRange>{MemoryRange{0x0380, 1}} &&
+           lost.referenceMemory().read(0x0380) == 0x80 && lost.candidateMemory().read(0x0380) == 0x00;
+}
+
+/*
+    Batch runner: success address, trap (branch to itself),
+    cycle limit and missing ROM, from a config file.
+*/
+static bool runnerTest() {
+    //LDX #$05; DEX; BNE *-1; BEQ *; NOP; JMP $0207
+    const uint8_t program[] = {0xa2, 0x05, 0xca, 0xd0, 0xfd, 0xf0, 0xfe, 0xea, 0x4c, 0x07, 0x02};
+    std::ofstream("/tmp/mos6502_runner_test.bin", std::ios::binary)
+        .write(reinterpret_cast<char const *>(program), sizeof(program));
+    std::ofstream("/tmp/mos6502_runner_test.cfg")
+        << "# file load entry success cycles\n"
+        << "mos6502_runner_test.bin 0200 0200 0205 1000\n"
+        << "\n"
+        << "mos6502_runner_test.bin 0200 0200 0300 1000 cmos  # the loop ends in BEQ *\n";
+    std::ofstream("/tmp/mos6502_runner_bad.cfg")
+        << "mos6502_runner_test.bin 0200 0200 0205 1000\n"
+        << "mos6502_runner_test.bin 0200 0200 10000 1000\n";
+
+    std::vector<TestConfig> configs;
+    std::size_t line;
+    bool parsed = loadTestConfigs("/tmp/mos6502_runner_test.cfg", configs, line) && configs.size() == 2 &&
+                  configs[0].file == "/tmp/mos6502_runner_test.bin" && configs[1].variant == TestVariant::cmos;
+    std::vector<TestConfig> bad;
+    bool rejected = !loadTestConfigs("/tmp/mos6502_runner_bad.cfg", bad, line) && line == 2;
+
+    //NOP; JMP $0207 is not a trap: only the cycle limit stops it
+    configs.push_back(TestConfig{"/tmp/mos6502_runner_test.bin", TestVariant::nmos, 0x0200, 0x0207, 0x0300, 100});
+    configs.push_back(TestConfig{"/tmp/mos6502_runner_missing.bin", TestVariant::nmos, 0x0200, 0x0200, 0x0205, 100});
+    std::vector<TestResult> results = runTests(configs, 2);
+
+    std::cout << "Test runner\n";
+    for(std::size_t i = 0; i < results.size(); ++i) {
+        std::cout << testStatusName(results[i].status) << " " << configs[i].file << " "
+                  << results[i].cycles << " cycles\n";
+    }
+
+    return parsed && rejected && results.size() == 4 &&
+           results[0].status == TestStatus::passed && results[0].pc == 0x0205 && results[0].cycles == 26 &&
+           results[1].status == TestStatus::trap && results[1].pc == 0x0205 &&
+           results[2].status == TestStatus::timeout && results[2].cycles >= 100 &&
+           results[3].status == TestStatus::loadError;
+}
+
+int main(void) {
+    int failed = 0;
+    uint64_t cycles = 0;
+    uint64_t nmosCycles = 0;
+
+    failed += !functionalTest<MOS6502>("NMOS 6502", nmosCycles);
+    failed += !functionalTest<MOS65C02>("CMOS 65C02", cycles);
+    failed += !functionalTest<MOS2A03>("Ricoh 2A03", cycles);
+    failed += !cycleExactTest<NMOS6502>("NMOS 6502", nmosCycles);
+    failed += !busCycleTest();
+    failed += !cmosNopTest();
+    failed += !decimalTest();
+    failed += !cmosInstructionsTest();
+    failed += !trapTest();
+    failed += !hooksTest();
+    failed += !memoryTest();
+    failed += !dirtyPagesTest();
+    failed += !dumpTest();
+    failed += !rewindTest();
+    failed += !loaderTest();
+    failed += !romImageTest();
+    failed += !bankedMemoryTest();
+    failed += !heatmapTest();
+    failed += !busTest();
+    failed += !viaTest<false>();
+    failed += !viaTest<true>();
+    failed += !aciaTest();
+    failed += !framebufferTest();
+    failed += !spscQueueTest();
+    failed += !aciaQueueTest();
+    failed += !asyncMachineTest();
+    failed += !systemTest();
+    failed += !recompilerTest();
+    failed += !controlFlowTest();
+    failed += !disassemblerTest();
+    failed += !lockstepTest();
+    failed += !runnerTest();
+
+    return failed;
 }